@@ -1,16 +1,22 @@
 #include "backend_logging.h"
 
+#include <cstdlib>
+
 namespace {
-// read environment variable to see if we should be logging;
-bool log_on =
-    std::getenv("ALUMINUM_SHARK_BACKEND_LOGGING") == nullptr
-        ? false
-        : std::stoi(std::getenv("ALUMINUM_SHARK_BACKEND_LOGGING")) == 1;
+// read environment variable to see if we should be logging. 1 logs the
+// backend calls, 2 adds the details of the ciphertext operations
+int read_log_level() {
+  const char* value = std::getenv("ALUMINUM_SHARK_BACKEND_LOGGING");
+  return value == nullptr ? BACKEND_LOG_LEVEL_OFF : std::atoi(value);
+}
 }  // namespace
 
 namespace aluminum_shark {
 namespace seal_backend {
-bool log() { return log_on; }
+
+const int log_level_value = read_log_level();
+
+bool log() { return BACKEND_LOG_ENABLED(BACKEND_LOG_LEVEL_INFO); }
 
 NullStream& nullstream() {
   static NullStream nullstream;
@@ -18,4 +24,4 @@ NullStream& nullstream() {
 }
 
 }  // namespace seal_backend
-}  // namespace aluminum_shark
\ No newline at end of file
+}  // namespace aluminum_shark
@@ -4,6 +4,18 @@
 #include <iostream>
 #include <string>
 
+// log levels. ALUMINUM_SHARK_BACKEND_LOGGING selects the level at runtime
+#define BACKEND_LOG_LEVEL_OFF 0
+#define BACKEND_LOG_LEVEL_INFO 1
+#define BACKEND_LOG_LEVEL_DEBUG 2
+
+// highest level compiled in. messages above it are removed by the compiler,
+// e.g. build with -DALUMINUM_SHARK_BACKEND_MAX_LOG_LEVEL=0 to strip all of
+// them
+#ifndef ALUMINUM_SHARK_BACKEND_MAX_LOG_LEVEL
+#define ALUMINUM_SHARK_BACKEND_MAX_LOG_LEVEL BACKEND_LOG_LEVEL_DEBUG
+#endif
+
 namespace aluminum_shark {
 namespace seal_backend {
 
@@ -20,27 +32,41 @@ const NullStream& operator<<(NullStream&& os, const T& value) {
 
 NullStream& nullstream();
 
+// level set through ALUMINUM_SHARK_BACKEND_LOGGING
+extern const int log_level_value;
+
+inline int log_level() { return log_level_value; }
+
 bool log();
 
 }  // namespace seal_backend
 }  // namespace aluminum_shark
 
-// streaming interface
+// true if messages of `LEVEL` are printed
+#define BACKEND_LOG_ENABLED(LEVEL)                     \
+  ((LEVEL) <= ALUMINUM_SHARK_BACKEND_MAX_LOG_LEVEL &&  \
+   ::aluminum_shark::seal_backend::log_level() >= (LEVEL))
+
+// streaming interface. the operands are only evaluated if the level is enabled
 #define BACKEND_LOG_FAIL_FILE_LINE(FILE, LINE) \
   std::cout << "SEAL Backend: [" << FILE << ":" << LINE << "] "
-// set FILE and LINE manually
-#define BACKEND_LOG_FILE_LINE(FILE, LINE)              \
-  (::aluminum_shark::seal_backend::log()               \
-       ? std::cout                                     \
-       : ::aluminum_shark::seal_backend::nullstream()) \
-      << "Backend: [" << FILE << ":" << LINE << "] "
+// set LEVEL, FILE and LINE manually
+#define BACKEND_LOG_LEVEL_FILE_LINE(LEVEL, FILE, LINE) \
+  if (!BACKEND_LOG_ENABLED(LEVEL)) {                   \
+  } else                                               \
+    std::cout << "Backend: [" << FILE << ":" << LINE << "] "
+#define BACKEND_LOG_FILE_LINE(FILE, LINE) \
+  BACKEND_LOG_LEVEL_FILE_LINE(BACKEND_LOG_LEVEL_INFO, FILE, LINE)
 
 #define BACKEND_LOG BACKEND_LOG_FILE_LINE(__FILE__, __LINE__)
+// detailed output of the ciphertext operations
+#define BACKEND_LOG_DEBUG \
+  BACKEND_LOG_LEVEL_FILE_LINE(BACKEND_LOG_LEVEL_DEBUG, __FILE__, __LINE__)
 
 // append to stream
-#define BACKEND_LOG_A                    \
-  (::aluminum_shark::seal_backend::log() \
-       ? std::cout                       \
-       : ::aluminum_shark::seal_backend::nullstream())
+#define BACKEND_LOG_A                               \
+  if (!BACKEND_LOG_ENABLED(BACKEND_LOG_LEVEL_INFO)) { \
+  } else                                              \
+    std::cout
 
-#endif /* ALUMINUM_SHARK_SEAL_BACKEND_LOGGING_H */
\ No newline at end of file
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_LOGGING_H */
@@ -0,0 +1,150 @@
+#include "ctxt_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = {'A', 'S', 'C', 'T'};
+const uint32_t VERSION = 1;
+
+template <class T>
+void write_value(std::ostream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <class T>
+T read_value(const char*& pos, const char* end, const std::string& file) {
+  if (static_cast<size_t>(end - pos) < sizeof(T)) {
+    throw std::runtime_error(file + " is truncated");
+  }
+  T value;
+  std::memcpy(&value, pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
+
+size_t padding(size_t offset) { return (8 - offset % 8) % 8; }
+
+}  // namespace
+
+namespace aluminum_shark {
+
+CtxtFileWriter::CtxtFileWriter(const std::string& file,
+                               const std::string& backend, int content_type,
+                               uint32_t compression,
+                               const std::vector<size_t>& shape, size_t count)
+    : _file(file), _out(file, std::ios::binary | std::ios::trunc),
+      _count(count) {
+  if (!_out) {
+    throw std::runtime_error("failed to create " + file);
+  }
+  _out.write(MAGIC, sizeof(MAGIC));
+  write_value<uint32_t>(_out, VERSION);
+  write_value<uint32_t>(_out, backend.size());
+  _out.write(backend.data(), backend.size());
+  write_value<int32_t>(_out, content_type);
+  write_value<uint32_t>(_out, compression);
+  write_value<uint32_t>(_out, shape.size());
+  for (size_t dim : shape) {
+    write_value<uint64_t>(_out, dim);
+  }
+  write_value<uint64_t>(_out, count);
+  pad();
+}
+
+void CtxtFileWriter::pad() {
+  static const char zeros[8] = {0};
+  _out.write(zeros, padding(_out.tellp()));
+}
+
+void CtxtFileWriter::add(CtxtEntry entry,
+                         const std::function<void(std::ostream&)>& write) {
+  if (_added == _count) {
+    throw std::runtime_error("too many ciphertexts for " + _file);
+  }
+  // the size is only known after the data is written
+  std::streampos entry_pos = _out.tellp();
+  entry.bytes = 0;
+  _out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  std::streampos begin = _out.tellp();
+  write(_out);
+  std::streampos end = _out.tellp();
+  entry.bytes = end - begin;
+  _out.seekp(entry_pos);
+  _out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  _out.seekp(end);
+  pad();
+  ++_added;
+}
+
+void CtxtFileWriter::add(CtxtEntry entry, const void* data, size_t size) {
+  add(entry, [data, size](std::ostream& out) {
+    out.write(static_cast<const char*>(data), size);
+  });
+}
+
+void CtxtFileWriter::close() {
+  _out.close();
+  if (_added != _count) {
+    throw std::runtime_error(_file + " expects " + std::to_string(_count) +
+                             " ciphertexts, got " + std::to_string(_added));
+  }
+  if (!_out) {
+    throw std::runtime_error("failed to write " + _file);
+  }
+}
+
+CtxtFileReader::CtxtFileReader(const std::string& file,
+                               const std::string& backend)
+    : _mapped(file) {
+  const char* begin = _mapped.data();
+  const char* pos = begin;
+  const char* end = pos + _mapped.size();
+  if (_mapped.size() < sizeof(MAGIC) ||
+      std::memcmp(pos, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error(file + " is not a ciphertext file");
+  }
+  pos += sizeof(MAGIC);
+  uint32_t version = read_value<uint32_t>(pos, end, file);
+  if (version != VERSION) {
+    throw std::runtime_error(file + " has unsupported version " +
+                             std::to_string(version));
+  }
+  uint32_t name_size = read_value<uint32_t>(pos, end, file);
+  if (static_cast<size_t>(end - pos) < name_size) {
+    throw std::runtime_error(file + " is truncated");
+  }
+  std::string name(pos, name_size);
+  pos += name_size;
+  if (name != backend) {
+    throw std::runtime_error(file + " was written by " + name + " not " +
+                             backend);
+  }
+  _content_type = read_value<int32_t>(pos, end, file);
+  _compression = read_value<uint32_t>(pos, end, file);
+  uint32_t rank = read_value<uint32_t>(pos, end, file);
+  for (uint32_t i = 0; i < rank; ++i) {
+    _shape.push_back(read_value<uint64_t>(pos, end, file));
+  }
+  uint64_t count = read_value<uint64_t>(pos, end, file);
+  pos += std::min<size_t>(padding(pos - begin), end - pos);
+  _entries.reserve(
+      std::min<uint64_t>(count, (end - pos) / sizeof(CtxtEntry)));
+  for (uint64_t i = 0; i < count; ++i) {
+    if (static_cast<size_t>(end - pos) < sizeof(CtxtEntry)) {
+      throw std::runtime_error(file + " is truncated");
+    }
+    const CtxtEntry* entry = reinterpret_cast<const CtxtEntry*>(pos);
+    pos += sizeof(CtxtEntry);
+    if (static_cast<uint64_t>(end - pos) < entry->bytes) {
+      throw std::runtime_error(file + " is truncated");
+    }
+    pos += entry->bytes;
+    pos += std::min<size_t>(padding(pos - begin), end - pos);
+    _entries.push_back(entry);
+  }
+}
+
+}  // namespace aluminum_shark
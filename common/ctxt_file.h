@@ -0,0 +1,87 @@
+#ifndef ALUMINUM_SHARK_COMMON_CTXT_FILE_H
+#define ALUMINUM_SHARK_COMMON_CTXT_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace aluminum_shark {
+
+// Metadata stored in front of every ciphertext in a ciphertext file. The
+// layout is fixed so it can be read straight from the mapped file.
+struct CtxtEntry {
+  // SEAL parms_id. unused by OpenFHE
+  uint64_t parms_id[4];
+  uint64_t level;
+  double scale;
+  // number of polynomials
+  uint32_t size;
+  // backend specific flags
+  uint32_t flags;
+  // size of the serialized ciphertext that follows
+  uint64_t bytes;
+};
+static_assert(sizeof(CtxtEntry) == 64, "CtxtEntry needs to be packed");
+
+// On disk format for batches of ciphertexts. A header (magic "ASCT",
+// uint32 version, backend name, content type, compression, shape and number
+// of ciphertexts) is followed by a `CtxtEntry` and the serialized data of
+// every ciphertext. The data starts at 8 byte aligned offsets.
+class CtxtFileWriter {
+ public:
+  // throws std::runtime_error if the file can't be created
+  CtxtFileWriter(const std::string& file, const std::string& backend,
+                 int content_type, uint32_t compression,
+                 const std::vector<size_t>& shape, size_t count);
+
+  // adds a ciphertext. `write` writes the data into the stream.
+  // `entry.bytes` is set by the writer
+  void add(CtxtEntry entry, const std::function<void(std::ostream&)>& write);
+  void add(CtxtEntry entry, const void* data, size_t size);
+
+  // flushes the file. throws std::runtime_error if not exactly `count`
+  // ciphertexts were added or writing failed
+  void close();
+
+ private:
+  std::string _file;
+  std::ofstream _out;
+  size_t _count;
+  size_t _added = 0;
+
+  void pad();
+};
+
+class CtxtFileReader {
+ public:
+  // maps `file` into memory and reads the entry table. throws
+  // std::runtime_error if the file is not a ciphertext file written by
+  // `backend`
+  CtxtFileReader(const std::string& file, const std::string& backend);
+
+  int content_type() const { return _content_type; };
+  uint32_t compression() const { return _compression; };
+  const std::vector<size_t>& shape() const { return _shape; };
+  size_t count() const { return _entries.size(); };
+
+  const CtxtEntry& entry(size_t i) const { return *_entries[i]; };
+  // serialized data of the `i`th ciphertext. points into the mapped file
+  const char* data(size_t i) const {
+    return reinterpret_cast<const char*>(_entries[i] + 1);
+  };
+
+ private:
+  MappedFile _mapped;
+  int _content_type;
+  uint32_t _compression;
+  std::vector<size_t> _shape;
+  std::vector<const CtxtEntry*> _entries;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_CTXT_FILE_H */
@@ -0,0 +1,133 @@
+#ifndef ALUMINUM_SHARK_COMMON_ENCODING_TABLE_H
+#define ALUMINUM_SHARK_COMMON_ENCODING_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+namespace aluminum_shark {
+
+// encodings of a single plaintext keyed by (level, scale). entries are
+// immutable once published and are never removed, so lookups are a few atomic
+// loads and never block. threads that miss encode on their own and publish the
+// result. if two threads race to publish the same key, the first encoding wins
+// and is returned to both. at most `max_per_level` scales are kept per level,
+// further encodings are handed back without being stored.
+//
+// a `Weak` table only keeps weak references. the encodings are owned by a
+// cache with its own memory budget and expire when the cache evicts them. the
+// nodes of expired encodings are skipped and still count towards
+// `max_per_level`
+template <class T, bool Weak = false>
+class EncodingTable {
+ public:
+  static constexpr size_t max_per_level = 8;
+
+  explicit EncodingTable(size_t levels)
+      : _levels(levels), _heads(new std::atomic<const Node*>[levels]) {
+    for (size_t i = 0; i < _levels; ++i) {
+      _heads[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~EncodingTable() {
+    for (size_t i = 0; i < _levels; ++i) {
+      const Node* node = _heads[i].load(std::memory_order_relaxed);
+      while (node) {
+        const Node* next = node->next;
+        delete node;
+        node = next;
+      }
+    }
+  }
+
+  EncodingTable(const EncodingTable&) = delete;
+  EncodingTable& operator=(const EncodingTable&) = delete;
+
+  // returns the encoding for `level` and `scale` or nullptr
+  std::shared_ptr<const T> find(size_t level, double scale) const {
+    if (level >= _levels) {
+      return nullptr;
+    }
+    for (const Node* node = _heads[level].load(std::memory_order_acquire);
+         node; node = node->next) {
+      if (node->scale == scale) {
+        std::shared_ptr<const T> value = get(node->value);
+        if (value) {
+          return value;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  // stores `value` for `level` and `scale` and returns the encoding stored
+  // for the key, which is `value` unless another thread was faster
+  std::shared_ptr<const T> publish(size_t level, double scale,
+                                   std::shared_ptr<const T> value) {
+    if (level >= _levels) {
+      return value;
+    }
+    Node* node = new Node{scale, value, nullptr};
+    const Node* head = _heads[level].load(std::memory_order_acquire);
+    const Node* searched = nullptr;
+    size_t length = 0;
+    while (true) {
+      // only the nodes added since the last attempt need to be searched
+      for (const Node* n = head; n != searched; n = n->next) {
+        if (n->scale == scale) {
+          std::shared_ptr<const T> existing = get(n->value);
+          if (existing) {
+            delete node;
+            return existing;
+          }
+        }
+        ++length;
+      }
+      if (length >= max_per_level) {
+        delete node;
+        return value;
+      }
+      searched = head;
+      node->next = head;
+      if (_heads[level].compare_exchange_weak(head, node,
+                                              std::memory_order_release,
+                                              std::memory_order_acquire)) {
+        _size.fetch_add(1, std::memory_order_relaxed);
+        return value;
+      }
+    }
+  }
+
+  // number of stored encodings, including expired ones of a `Weak` table
+  size_t size() const { return _size.load(std::memory_order_relaxed); }
+
+  size_t levels() const { return _levels; }
+
+ private:
+  using Ref = std::conditional_t<Weak, std::weak_ptr<const T>,
+                                 std::shared_ptr<const T>>;
+
+  struct Node {
+    double scale;
+    Ref value;
+    const Node* next;
+  };
+
+  // nullptr if the encoding expired
+  static std::shared_ptr<const T> get(const std::shared_ptr<const T>& value) {
+    return value;
+  }
+  static std::shared_ptr<const T> get(const std::weak_ptr<const T>& value) {
+    return value.lock();
+  }
+
+  const size_t _levels;
+  std::unique_ptr<std::atomic<const Node*>[]> _heads;
+  std::atomic<size_t> _size{0};
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_ENCODING_TABLE_H */
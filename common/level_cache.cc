@@ -0,0 +1,43 @@
+#include "level_cache.h"
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+const size_t budget_bytes =
+    (std::getenv("ALUMINUM_SHARK_LEVEL_CACHE_MB") == nullptr
+         ? size_t{256}
+         : std::stoul(std::getenv("ALUMINUM_SHARK_LEVEL_CACHE_MB")))
+    << 20;
+
+std::atomic<size_t> used_bytes{0};
+}  // namespace
+
+namespace aluminum_shark {
+
+std::atomic_ulong LevelCacheBudget::hits = 0;
+std::atomic_ulong LevelCacheBudget::misses = 0;
+std::atomic_ulong LevelCacheBudget::rejected = 0;
+
+bool LevelCacheBudget::enabled() { return budget_bytes != 0; }
+
+bool LevelCacheBudget::reserve(size_t bytes) {
+  size_t used = used_bytes.load(std::memory_order_relaxed);
+  do {
+    if (used + bytes > budget_bytes) {
+      return false;
+    }
+  } while (!used_bytes.compare_exchange_weak(used, used + bytes,
+                                             std::memory_order_relaxed));
+  return true;
+}
+
+void LevelCacheBudget::release(size_t bytes) {
+  used_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t LevelCacheBudget::used() {
+  return used_bytes.load(std::memory_order_relaxed);
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,134 @@
+#ifndef ALUMINUM_SHARK_COMMON_LEVEL_CACHE_H
+#define ALUMINUM_SHARK_COMMON_LEVEL_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace aluminum_shark {
+
+// memory budget and statistics shared by all level caches. the budget is
+// ALUMINUM_SHARK_LEVEL_CACHE_MB megabytes (default 256), 0 disables caching
+class LevelCacheBudget {
+ public:
+  // true if versions are cached at all
+  static bool enabled();
+  // takes `bytes` from the budget. returns false if they don't fit
+  static bool reserve(size_t bytes);
+  static void release(size_t bytes);
+  static size_t used();
+
+  static std::atomic_ulong hits;
+  static std::atomic_ulong misses;
+  // versions that were computed but didn't fit into the budget
+  static std::atomic_ulong rejected;
+};
+
+// lower level versions of a ciphertext. skip connections, hidden states and
+// biases are combined with many ciphertexts at lower levels and would
+// otherwise be brought down to the same level again for every one of them.
+//
+// versions are keyed by level, scale and the degree of the scale (OpenFHE's
+// noise scale degree, 1 for SEAL) and belong to a generation of the
+// ciphertext. the owner calls `invalidate` before it modifies the ciphertext,
+// which only bumps the generation. versions of older generations are never
+// returned and are dropped by the next lookup or with the cache. lookups take
+// a lock, versions are computed outside of it. if two threads compute the same
+// version the first one is kept
+template <class T>
+class LevelCache {
+ public:
+  LevelCache() = default;
+  ~LevelCache() {
+    for (const Entry& entry : _entries) {
+      LevelCacheBudget::release(entry.bytes);
+    }
+  }
+
+  // a copy of the owner starts without versions
+  LevelCache(const LevelCache&) : LevelCache() {}
+  LevelCache& operator=(const LevelCache&) {
+    invalidate();
+    return *this;
+  }
+
+  // returns the version at `level`, `scale` and `scale_degree`. on a miss it
+  // is computed by `make`, which returns a std::shared_ptr<const T>, and
+  // stored if its `bytes` fit into the budget
+  template <class F>
+  std::shared_ptr<const T> get(int64_t level, double scale, size_t bytes,
+                               F make, uint32_t scale_degree = 1) {
+    const uint64_t generation = _generation.load(std::memory_order_relaxed);
+    if (!LevelCacheBudget::enabled()) {
+      return make();
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      purge(generation);
+      for (const Entry& entry : _entries) {
+        if (entry.level == level && entry.scale == scale &&
+            entry.scale_degree == scale_degree) {
+          ++LevelCacheBudget::hits;
+          return entry.value;
+        }
+      }
+    }
+    ++LevelCacheBudget::misses;
+    std::shared_ptr<const T> value = make();
+    if (!LevelCacheBudget::reserve(bytes)) {
+      ++LevelCacheBudget::rejected;
+      return value;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    purge(generation);
+    for (const Entry& entry : _entries) {
+      if (entry.level == level && entry.scale == scale &&
+          entry.scale_degree == scale_degree) {
+        LevelCacheBudget::release(bytes);
+        return entry.value;
+      }
+    }
+    _entries.push_back(
+        Entry{generation, level, scale, scale_degree, value, bytes});
+    return value;
+  }
+
+  // the cached versions no longer match the ciphertext. must not run
+  // concurrently with `get`, just like the modification that follows it
+  void invalidate() { _generation.fetch_add(1, std::memory_order_relaxed); }
+
+ private:
+  struct Entry {
+    uint64_t generation;
+    int64_t level;
+    double scale;
+    uint32_t scale_degree;
+    std::shared_ptr<const T> value;
+    size_t bytes;
+  };
+
+  // drops the versions of generations before `generation`. needs `_mutex`
+  void purge(uint64_t generation) {
+    size_t kept = 0;
+    for (size_t i = 0; i < _entries.size(); ++i) {
+      if (_entries[i].generation == generation) {
+        _entries[kept++] = std::move(_entries[i]);
+      } else {
+        LevelCacheBudget::release(_entries[i].bytes);
+      }
+    }
+    _entries.resize(kept);
+  }
+
+  std::atomic<uint64_t> _generation{0};
+  std::mutex _mutex;
+  std::vector<Entry> _entries;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_LEVEL_CACHE_H */
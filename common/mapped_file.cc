@@ -0,0 +1,78 @@
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace aluminum_shark {
+
+MappedFile::MappedFile(const std::string& file) {
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd == -1) {
+    throw std::runtime_error("failed to open " + file + ": " +
+                             std::strerror(errno));
+  }
+  struct stat st;
+  if (::fstat(fd, &st) == -1) {
+    ::close(fd);
+    throw std::runtime_error("failed to stat " + file + ": " +
+                             std::strerror(errno));
+  }
+  _size = st.st_size;
+  if (_size != 0) {
+    void* ptr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("failed to map " + file + ": " +
+                               std::strerror(errno));
+    }
+    // the file is read front to back
+    ::madvise(ptr, _size, MADV_SEQUENTIAL);
+    _data = static_cast<const char*>(ptr);
+  }
+  // the mapping stays valid after closing the file
+  ::close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (_data != nullptr) {
+    ::munmap(const_cast<char*>(_data), _size);
+  }
+}
+
+MemoryStreamBuf::MemoryStreamBuf(const char* data, size_t size) {
+  char* begin = const_cast<char*>(data);
+  setg(begin, begin, begin + size);
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekoff(
+    off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+  if (!(which & std::ios_base::in)) {
+    return pos_type(off_type(-1));
+  }
+  char* target;
+  if (dir == std::ios_base::beg) {
+    target = eback() + off;
+  } else if (dir == std::ios_base::cur) {
+    target = gptr() + off;
+  } else {
+    target = egptr() + off;
+  }
+  if (target < eback() || target > egptr()) {
+    return pos_type(off_type(-1));
+  }
+  setg(eback(), target, egptr());
+  return pos_type(target - eback());
+}
+
+MemoryStreamBuf::pos_type MemoryStreamBuf::seekpos(
+    pos_type pos, std::ios_base::openmode which) {
+  return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,43 @@
+#ifndef ALUMINUM_SHARK_COMMON_MAPPED_FILE_H
+#define ALUMINUM_SHARK_COMMON_MAPPED_FILE_H
+
+#include <cstddef>
+#include <streambuf>
+#include <string>
+
+namespace aluminum_shark {
+
+// read only memory mapping of a whole file. the file is unmapped when the
+// object is destroyed
+class MappedFile {
+ public:
+  // throws std::runtime_error if the file can't be opened or mapped
+  explicit MappedFile(const std::string& file);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return _data; };
+  size_t size() const { return _size; };
+
+ private:
+  const char* _data = nullptr;
+  size_t _size = 0;
+};
+
+// read only stream buffer over existing memory. allows passing mapped memory
+// to APIs that only take a std::istream without copying it
+class MemoryStreamBuf : public std::streambuf {
+ public:
+  MemoryStreamBuf(const char* data, size_t size);
+
+ protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override;
+  pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_MAPPED_FILE_H */
@@ -1,25 +1,97 @@
 #include "object_count.h"
 
-#include <algorithm>
-#include <mutex>
+#include <atomic>
+#include <cstdlib>
+#include <string>
 
 #include "backend_logging.h"
 
 namespace {
-// object counting variables
-int ptxt_count_ = 0;
-int ctxt_count_ = 0;
+// object counting variables. every thread updates its own shard, readers sum
+// up all shards
+constexpr size_t n_shards = 32;
 
-int max_ptxt_count_ = 0;
-int max_ctxt_count_ = 0;
+struct alignas(64) Shard {
+  std::atomic<int64_t> ptxt_count{0};
+  std::atomic<int64_t> ctxt_count{0};
+  std::atomic<int64_t> ptxt_create_count{0};
+  std::atomic<int64_t> ptxt_destroy_count{0};
+  std::atomic<int64_t> ctxt_create_count{0};
+  std::atomic<int64_t> ctxt_destroy_count{0};
+  std::atomic<int64_t> ptxt_bytes{0};
+  std::atomic<int64_t> ctxt_bytes{0};
+  // changes not yet added to the totals of the high-water marks
+  std::atomic<int64_t> ptxt_pending{0};
+  std::atomic<int64_t> ctxt_pending{0};
+  std::atomic<int64_t> bytes_pending{0};
+};
+
+Shard shards[n_shards];
+std::atomic<size_t> next_shard{0};
 
-int ctxt_create_count = 0;
-int ctxt_destroy_count = 0;
+// a shard adds its pending changes to the totals once they reach these sizes.
+// the totals are only touched by every few objects (or megabyte) and lag
+// behind the merged values by less than n_shards times these sizes
+constexpr int64_t count_flush = 8;
+constexpr int64_t bytes_flush = int64_t{1} << 20;
+
+// totals the high-water marks are taken from
+struct alignas(64) Totals {
+  std::atomic<int64_t> ptxt_count{0};
+  std::atomic<int64_t> ctxt_count{0};
+  std::atomic<int64_t> bytes{0};
+};
 
-int ptxt_create_count = 0;
-int ptxt_destroy_count = 0;
+Totals totals;
+
+// high-water marks. updated when a shard flushes its changes and when they are
+// read
+std::atomic<int64_t> max_ptxt_count_{0};
+std::atomic<int64_t> max_ctxt_count_{0};
+std::atomic<int64_t> max_bytes_{0};
+
+Shard& shard() {
+  thread_local Shard& local =
+      shards[next_shard.fetch_add(1, std::memory_order_relaxed) % n_shards];
+  return local;
+}
+
+int64_t merged(std::atomic<int64_t> Shard::*field) {
+  int64_t sum = 0;
+  for (const Shard& s : shards) {
+    sum += (s.*field).load(std::memory_order_relaxed);
+  }
+  return sum;
+}
+
+void update_max(std::atomic<int64_t>& max, int64_t value) {
+  int64_t current = max.load(std::memory_order_relaxed);
+  while (value > current &&
+         !max.compare_exchange_weak(current, value,
+                                    std::memory_order_relaxed)) {
+  }
+}
 
-std::mutex count_mu;
+void add(std::atomic<int64_t> Shard::*field, int64_t value) {
+  (shard().*field).fetch_add(value, std::memory_order_relaxed);
+}
+
+// adds `delta` to the pending changes of the thread's shard. once they reach
+// `flush` they are moved to `total` and `max` is raised to the new total
+void track_max(std::atomic<int64_t> Shard::*pending,
+               std::atomic<int64_t>& total, std::atomic<int64_t>& max,
+               int64_t delta, int64_t flush) {
+  std::atomic<int64_t>& local = shard().*pending;
+  int64_t value = local.fetch_add(delta, std::memory_order_relaxed) + delta;
+  if (value < flush && value > -flush) {
+    return;
+  }
+  value = local.exchange(0, std::memory_order_relaxed);
+  update_max(max, total.fetch_add(value, std::memory_order_relaxed) + value);
+}
+
+// growth of plaintexts and ciphertexts caused by the thread
+thread_local int64_t thread_allocated_bytes = 0;
 }  // namespace
 
 namespace aluminum_shark {
@@ -38,97 +110,147 @@ void count_ptxt(int count) {
   if (!AS_OBJECT_COUNT) {
     return;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  ptxt_count_ += count;
-  max_ptxt_count_ = std::max(max_ptxt_count_, ptxt_count_);
+  add(&Shard::ptxt_count, count);
+  track_max(&Shard::ptxt_pending, totals.ptxt_count, max_ptxt_count_, count,
+            count_flush);
   if (count > 0) {
-    ptxt_create_count += count;
+    add(&Shard::ptxt_create_count, count);
   } else {
-    ptxt_destroy_count -= count;
+    add(&Shard::ptxt_destroy_count, -count);
   }
-  BACKEND_LOG << "ptxt count " << ptxt_count_ << std::endl;
+  BACKEND_LOG << "ptxt count " << merged(&Shard::ptxt_count) << std::endl;
 };
 
 void count_ctxt(int count) {
   if (!AS_OBJECT_COUNT) {
     return;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  ctxt_count_ += count;
-  max_ctxt_count_ = std::max(max_ctxt_count_, ctxt_count_);
+  add(&Shard::ctxt_count, count);
+  track_max(&Shard::ctxt_pending, totals.ctxt_count, max_ctxt_count_, count,
+            count_flush);
   if (count > 0) {
-    ctxt_create_count += count;
-    BACKEND_LOG << "ctxt count " << ctxt_count_
-                << "ctxt creation no: " << ctxt_create_count << std::endl;
+    add(&Shard::ctxt_create_count, count);
+    BACKEND_LOG << "ctxt count " << merged(&Shard::ctxt_count)
+                << "ctxt creation no: " << merged(&Shard::ctxt_create_count)
+                << std::endl;
   } else {
-    ctxt_destroy_count -= count;
-    BACKEND_LOG << "ctxt count " << ctxt_count_
-                << "ctxt destroy no: " << ctxt_destroy_count << std::endl;
+    add(&Shard::ctxt_destroy_count, -count);
+    BACKEND_LOG << "ctxt count " << merged(&Shard::ctxt_count)
+                << "ctxt destroy no: " << merged(&Shard::ctxt_destroy_count)
+                << std::endl;
   }
 };
 
+void count_ptxt_bytes(int64_t delta) {
+  if (!AS_OBJECT_COUNT || delta == 0) {
+    return;
+  }
+  add(&Shard::ptxt_bytes, delta);
+  track_max(&Shard::bytes_pending, totals.bytes, max_bytes_, delta,
+            bytes_flush);
+  if (delta > 0) {
+    thread_allocated_bytes += delta;
+  }
+}
+
+void count_ctxt_bytes(int64_t delta) {
+  if (!AS_OBJECT_COUNT || delta == 0) {
+    return;
+  }
+  add(&Shard::ctxt_bytes, delta);
+  track_max(&Shard::bytes_pending, totals.bytes, max_bytes_, delta,
+            bytes_flush);
+  if (delta > 0) {
+    thread_allocated_bytes += delta;
+  }
+}
+
 int get_ptxt_count() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return ptxt_count_;
+  return merged(&Shard::ptxt_count);
 };
 
 int get_ctxt_count() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return ctxt_count_;
+  return merged(&Shard::ctxt_count);
 };
 
 int get_max_ptxt_count() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return max_ptxt_count_;
+  // the current value may be above the totals of the last flushes
+  update_max(max_ptxt_count_, merged(&Shard::ptxt_count));
+  return max_ptxt_count_.load(std::memory_order_relaxed);
 }
 
 int get_max_ctxt_count() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return max_ctxt_count_;
+  update_max(max_ctxt_count_, merged(&Shard::ctxt_count));
+  return max_ctxt_count_.load(std::memory_order_relaxed);
 }
 
 int get_ptxt_creations() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return ptxt_create_count;
+  return merged(&Shard::ptxt_create_count);
 }
 int get_ptxt_destructions() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return ptxt_destroy_count;
+  return merged(&Shard::ptxt_destroy_count);
 }
 
 int get_ctxt_creations() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return ctxt_create_count;
+  return merged(&Shard::ctxt_create_count);
 }
 
 int get_ctxt_destructions() {
   if (!AS_OBJECT_COUNT) {
     return -1;
   }
-  std::lock_guard<std::mutex> guard(count_mu);
-  return ctxt_destroy_count;
+  return merged(&Shard::ctxt_destroy_count);
 }
 
-}  // namespace aluminum_shark
+int64_t get_ptxt_bytes() {
+  if (!AS_OBJECT_COUNT) {
+    return -1;
+  }
+  return merged(&Shard::ptxt_bytes);
+}
 
+int64_t get_ctxt_bytes() {
+  if (!AS_OBJECT_COUNT) {
+    return -1;
+  }
+  return merged(&Shard::ctxt_bytes);
+}
+
+int64_t get_max_bytes() {
+  if (!AS_OBJECT_COUNT) {
+    return -1;
+  }
+  update_max(max_bytes_,
+             merged(&Shard::ptxt_bytes) + merged(&Shard::ctxt_bytes));
+  return max_bytes_.load(std::memory_order_relaxed);
+}
+
+int64_t get_thread_allocated_bytes() {
+  if (!AS_OBJECT_COUNT) {
+    return -1;
+  }
+  return thread_allocated_bytes;
+}
+
+}  // namespace aluminum_shark
@@ -1,11 +1,16 @@
 #ifndef ALUMINUM_SHARK_COMMON_OBJECT_COUNT_H
 #define ALUMINUM_SHARK_COMMON_OBJECT_COUNT_H
 
+#include <cstdint>
+
 namespace aluminum_shark {
 
 extern const bool AS_OBJECT_COUNT;
 
-// object counting
+// object counting. the counters are sharded by thread and merged when they are
+// read, counting doesn't take a lock. the high-water marks are exact for the
+// moments they are read, in between they may miss peaks by a few objects (or
+// megabytes) per thread
 void count_ptxt(int count);
 void count_ctxt(int count);
 int get_ptxt_count();
@@ -20,6 +25,18 @@ int get_ptxt_destructions();
 int get_ctxt_creations();
 int get_ctxt_destructions();
 
+// memory used by live objects. `delta` is the change of the size of the
+// coefficient buffers of an object in bytes
+void count_ptxt_bytes(int64_t delta);
+void count_ctxt_bytes(int64_t delta);
+int64_t get_ptxt_bytes();
+int64_t get_ctxt_bytes();
+// high-water mark of the bytes used by plaintexts and ciphertexts together
+int64_t get_max_bytes();
+// bytes the calling thread has added to plaintexts and ciphertexts so far.
+// only grows, frees are not subtracted
+int64_t get_thread_allocated_bytes();
+
 }  // namespace aluminum_shark
 
 #endif /* ALUMINUM_SHARK_COMMON_OBJECT_COUNT_H */
@@ -0,0 +1,357 @@
+#include "op_capture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "backend_logging.h"
+
+namespace {
+
+using aluminum_shark::CAPTURE_OP;
+using aluminum_shark::CaptureRecord;
+
+constexpr char magic[8] = {'A', 'S', 'C', 'A', 'P', 'T', 'U', 'R'};
+constexpr uint32_t version = 1;
+
+const char* capture_file_name() {
+  static const char* name = [] {
+    const char* value = std::getenv("ALUMINUM_SHARK_CAPTURE");
+    if (value != nullptr && value[0] == '\0') {
+      value = nullptr;
+    }
+    BACKEND_LOG << "capturing operations to: "
+                << (value != nullptr ? value : "off") << std::endl;
+    return value;
+  }();
+  return name;
+}
+
+// set if the capture file can't be written. capturing stops for the rest of
+// the process
+std::atomic_bool capture_failed{false};
+
+// the capture file and the ids of the ciphertexts. all writes hold the lock,
+// the order of the records is the order the operations finished in
+struct CaptureFile {
+  std::mutex mutex;
+  std::ofstream out;
+  std::unordered_map<const void*, uint32_t> ids;
+  uint32_t next_id = 1;
+  uint32_t contexts = 0;
+
+  // returns false if capturing failed
+  bool write(const CaptureRecord& record) {
+    if (capture_failed.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (!out.is_open()) {
+      out.open(capture_file_name(), std::ios::binary);
+      if (!out) {
+        return fail("can't open");
+      }
+      const uint32_t record_size = sizeof(CaptureRecord);
+      out.write(magic, sizeof(magic));
+      out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+      out.write(reinterpret_cast<const char*>(&record_size),
+                sizeof(record_size));
+    }
+    out.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    if (!out) {
+      return fail("can't write to");
+    }
+    return true;
+  }
+
+  // logs the failure once and disables capturing
+  bool fail(const char* what) {
+    BACKEND_LOG_FAIL_FILE_LINE(__FILE__, __LINE__)
+        << what << " capture file " << capture_file_name()
+        << ". capturing is disabled" << std::endl;
+    capture_failed.store(true, std::memory_order_relaxed);
+    out.close();
+    return false;
+  }
+
+  // id of the ciphertext at `ctxt`. unknown ciphertexts are recorded as input
+  uint32_t id(const void* ctxt, int16_t level, float scale, uint16_t thread) {
+    auto iter = ids.find(ctxt);
+    if (iter != ids.end()) {
+      return iter->second;
+    }
+    CaptureRecord input{};
+    input.op = CAPTURE_OP::INPUT;
+    input.thread = thread;
+    input.result = next_id++;
+    input.lhs_level = level;
+    input.lhs_scale = scale;
+    write(input);
+    ids[ctxt] = input.result;
+    return input.result;
+  }
+};
+
+CaptureFile& capture_file() {
+  static CaptureFile file;
+  return file;
+}
+
+// depth of the active capture of the thread. only depth 0 is recorded
+thread_local int depth = 0;
+
+uint16_t thread_index() {
+  static std::atomic<uint16_t> next{0};
+  thread_local uint16_t index = next.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
+float log2_scale(double scale) {
+  return scale > 0 ? static_cast<float>(std::log2(scale)) : 0;
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+bool capture_enabled() {
+  return capture_file_name() != nullptr &&
+         !capture_failed.load(std::memory_order_relaxed);
+}
+
+void capture_context(bool ckks, bool from_arguments,
+                     const std::string& parameters) {
+  if (!capture_enabled()) {
+    return;
+  }
+  CaptureFile& file = capture_file();
+  std::lock_guard<std::mutex> lock(file.mutex);
+  CaptureRecord record{};
+  record.op = CAPTURE_OP::CONTEXT;
+  record.flags = (ckks ? CAPTURE_DOUBLE : 0) |
+                 (from_arguments ? CAPTURE_ARGUMENTS : 0);
+  record.thread = thread_index();
+  record.result = file.contexts++;
+  record.rhs = parameters.size();
+  if (file.write(record)) {
+    file.out.write(parameters.data(), parameters.size());
+    file.out.flush();
+  }
+}
+
+void capture_release(const void* ctxt) {
+  if (!capture_enabled()) {
+    return;
+  }
+  CaptureFile& file = capture_file();
+  std::lock_guard<std::mutex> lock(file.mutex);
+  auto iter = file.ids.find(ctxt);
+  if (iter == file.ids.end()) {
+    return;
+  }
+  CaptureRecord record{};
+  record.op = CAPTURE_OP::RELEASE;
+  record.thread = thread_index();
+  record.lhs = iter->second;
+  file.ids.erase(iter);
+  file.write(record);
+}
+
+OpCapture::OpCapture(CAPTURE_OP op, bool inplace)
+    : _active(capture_enabled() && depth == 0) {
+  if (!_active) {
+    return;
+  }
+  ++depth;
+  _record.op = op;
+  _record.flags = inplace ? CAPTURE_INPLACE : 0;
+  _record.thread = thread_index();
+  _record.lhs_level = -1;
+  _record.rhs_level = -1;
+  _uncaught = std::uncaught_exceptions();
+  _start = std::chrono::steady_clock::now();
+}
+
+OpCapture::OpCapture(OpCapture&& other)
+    : _record(other._record),
+      _lhs(other._lhs),
+      _rhs(other._rhs),
+      _result(other._result),
+      _active(other._active),
+      _uncaught(other._uncaught),
+      _start(other._start) {
+  other._active = false;
+}
+
+OpCapture::~OpCapture() {
+  if (!_active) {
+    return;
+  }
+  --depth;
+  if (std::uncaught_exceptions() > _uncaught ||
+      (_result == nullptr && !(_record.flags & CAPTURE_INPLACE))) {
+    // the operation failed
+    return;
+  }
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - _start)
+                .count();
+  _record.duration_us = std::min<decltype(us)>(us, UINT32_MAX);
+  CaptureFile& file = capture_file();
+  std::lock_guard<std::mutex> lock(file.mutex);
+  _record.lhs = file.id(_lhs, _record.lhs_level, _record.lhs_scale,
+                        _record.thread);
+  if (_rhs != nullptr) {
+    _record.rhs = file.id(_rhs, _record.rhs_level, _record.rhs_scale,
+                          _record.thread);
+  }
+  if (_result != nullptr) {
+    // the address may have been used by a ciphertext that was not captured
+    _record.result = file.next_id++;
+    file.ids[_result] = _record.result;
+  }
+  file.write(_record);
+}
+
+void OpCapture::lhs(const void* ctxt, int level, double scale) {
+  if (!_active) {
+    return;
+  }
+  _lhs = ctxt;
+  _record.lhs_level = level;
+  _record.lhs_scale = log2_scale(scale);
+}
+
+void OpCapture::rhs(const void* ctxt, int level, double scale) {
+  if (!_active) {
+    return;
+  }
+  _rhs = ctxt;
+  _record.rhs_level = level;
+  _record.rhs_scale = log2_scale(scale);
+}
+
+void OpCapture::plain(size_t values, uint64_t hash, bool doubles,
+                      bool all_zero, bool all_one) {
+  if (!_active) {
+    return;
+  }
+  _record.flags |= CAPTURE_PLAIN | (doubles ? CAPTURE_DOUBLE : 0) |
+                   (all_zero ? CAPTURE_ALL_ZERO : 0) |
+                   (all_one ? CAPTURE_ALL_ONE : 0);
+  _record.rhs = values;
+  std::memcpy(&_record.arg, &hash, sizeof(hash));
+}
+
+void OpCapture::scalar(long value) {
+  if (!_active) {
+    return;
+  }
+  _record.flags |= CAPTURE_SCALAR;
+  _record.arg = value;
+}
+
+void OpCapture::scalar(double value) {
+  if (!_active) {
+    return;
+  }
+  _record.flags |= CAPTURE_SCALAR | CAPTURE_DOUBLE;
+  std::memcpy(&_record.arg, &value, sizeof(value));
+}
+
+void OpCapture::steps(int steps) {
+  if (!_active) {
+    return;
+  }
+  _record.arg = steps;
+}
+
+void OpCapture::result(const void* ctxt) {
+  if (!_active) {
+    return;
+  }
+  _result = ctxt;
+}
+
+Capture read_capture(const std::string& file) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("can't open capture " + file);
+  }
+  char file_magic[sizeof(magic)];
+  uint32_t file_version = 0;
+  uint32_t record_size = 0;
+  in.read(file_magic, sizeof(file_magic));
+  in.read(reinterpret_cast<char*>(&file_version), sizeof(file_version));
+  in.read(reinterpret_cast<char*>(&record_size), sizeof(record_size));
+  if (!in || std::memcmp(file_magic, magic, sizeof(magic)) != 0) {
+    throw std::runtime_error(file + " is not a capture");
+  }
+  if (file_version != version || record_size != sizeof(CaptureRecord)) {
+    throw std::runtime_error(file + " has unsupported version " +
+                             std::to_string(file_version));
+  }
+  Capture capture;
+  CaptureRecord record;
+  while (in.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+    if (record.op == CAPTURE_OP::CONTEXT) {
+      Capture::Context context{(record.flags & CAPTURE_DOUBLE) != 0,
+                               (record.flags & CAPTURE_ARGUMENTS) != 0,
+                               std::string(record.rhs, '\0')};
+      if (!in.read(&context.parameters[0], record.rhs)) {
+        break;
+      }
+      record.result = capture.contexts.size();
+      capture.contexts.push_back(std::move(context));
+    }
+    capture.records.push_back(record);
+  }
+  // a partial record at the end is left by a process that did not exit
+  // cleanly. everything before it is usable
+  return capture;
+}
+
+std::string capture_op_name(const CaptureRecord& record) {
+  std::string name;
+  switch (record.op) {
+    case CAPTURE_OP::CONTEXT:
+      return "context";
+    case CAPTURE_OP::INPUT:
+      return "input";
+    case CAPTURE_OP::RELEASE:
+      return "release";
+    case CAPTURE_OP::COPY:
+      return "copy";
+    case CAPTURE_OP::ADD:
+      name = "add";
+      break;
+    case CAPTURE_OP::SUB:
+      name = "sub";
+      break;
+    case CAPTURE_OP::MULT:
+      name = "mult";
+      break;
+    case CAPTURE_OP::ROTATE:
+      name = "rotate";
+      break;
+    default:
+      return "unknown";
+  }
+  if (record.flags & CAPTURE_PLAIN) {
+    name += "_plain";
+  } else if (record.flags & CAPTURE_SCALAR) {
+    name += "_scalar";
+  }
+  if (record.flags & CAPTURE_INPLACE) {
+    name += "_inplace";
+  }
+  return name;
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,199 @@
+#ifndef ALUMINUM_SHARK_COMMON_OP_CAPTURE_H
+#define ALUMINUM_SHARK_COMMON_OP_CAPTURE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// capture of the ciphertext operations of a computation. if
+// ALUMINUM_SHARK_CAPTURE is set to a file name every context creation and
+// HECtxt operation is written to that file as a fixed size binary record.
+// tools/op_replay re-executes a capture against a backend library with fresh
+// keys, without TensorFlow or python.
+//
+// ciphertexts are identified by ids assigned in the order they appear.
+// ciphertexts that were not created by a captured operation (encryption,
+// loading, backend specific functions) are recorded as INPUT the first time
+// they are used. plaintext values are not stored, only a hash of them.
+//
+// file layout: the magic "ASCAPTUR", the version and the record size as
+// uint32, then the records. a CONTEXT record is followed by `rhs` bytes of
+// context parameters (see `capture_context`).
+
+namespace aluminum_shark {
+
+enum class CAPTURE_OP : uint8_t {
+  CONTEXT,  // a context was created, the following ops belong to it
+  INPUT,    // `result` entered the computation
+  RELEASE,  // `lhs` was destroyed
+  COPY,
+  ADD,
+  SUB,
+  MULT,
+  ROTATE
+};
+
+// flags of a record
+constexpr uint8_t CAPTURE_INPLACE = 1;  // the result is written into `lhs`
+constexpr uint8_t CAPTURE_PLAIN = 2;    // the operand is a plaintext
+constexpr uint8_t CAPTURE_SCALAR = 4;   // the operand is `arg`
+// the operand holds doubles. for CONTEXT: the context uses CKKS
+constexpr uint8_t CAPTURE_DOUBLE = 8;
+constexpr uint8_t CAPTURE_ALL_ZERO = 16;  // all plaintext values are 0
+constexpr uint8_t CAPTURE_ALL_ONE = 32;   // all plaintext values are 1
+// CONTEXT: created from named arguments instead of the fixed parameters
+constexpr uint8_t CAPTURE_ARGUMENTS = 64;
+
+// levels are given as reported by the backend: the chain index for SEAL, the
+// number of rescales for OpenFHE. scales are log2 of the CKKS scale, 0 for BFV
+struct CaptureRecord {
+  CAPTURE_OP op;
+  uint8_t flags;
+  uint16_t thread;  // capturing thread
+  // ciphertext ids, 0 is none. for CONTEXT `result` is the index of the
+  // context and `lhs` is unused
+  uint32_t result;
+  uint32_t lhs;
+  // plaintext operand: number of values. CONTEXT: length of the parameters
+  uint32_t rhs;
+  int16_t lhs_level;
+  int16_t rhs_level;
+  float lhs_scale;
+  float rhs_scale;
+  // duration of the operation, saturates at ~71 minutes
+  uint32_t duration_us;
+  // scalar operand (bits of the double if CAPTURE_DOUBLE), plaintext hash or
+  // rotation steps
+  int64_t arg;
+};
+static_assert(sizeof(CaptureRecord) == 40, "unexpected record padding");
+
+// true if ALUMINUM_SHARK_CAPTURE is set
+bool capture_enabled();
+
+// records the creation of a context. `parameters` holds one parameter per
+// line as `name:type=value` or `name:type[]=value,value...` for arrays with
+// type i (integer), d (double) or s (string), see `capture_argument`
+void capture_context(bool ckks, bool from_arguments,
+                     const std::string& parameters);
+
+// records that the ciphertext at `ctxt` was destroyed if it was captured
+void capture_release(const void* ctxt);
+
+// type letter of a context parameter
+template <class T>
+constexpr char capture_type() {
+  return std::is_floating_point<T>::value
+             ? 'd'
+             : std::is_integral<T>::value ? 'i' : 's';
+}
+
+// one line of the context parameters for an array parameter
+template <class T>
+std::string capture_argument(const std::string& name,
+                             const std::vector<T>& values) {
+  std::stringstream ss;
+  ss << name << ':' << capture_type<T>() << "[]=";
+  ss.precision(17);
+  for (size_t i = 0; i < values.size(); ++i) {
+    ss << (i == 0 ? "" : ",") << values[i];
+  }
+  ss << '\n';
+  return ss.str();
+}
+
+// one line of the context parameters for a single value
+template <class T>
+std::string capture_argument(const std::string& name, const T& value) {
+  std::stringstream ss;
+  ss.precision(17);
+  ss << name << ':' << capture_type<T>() << '=' << value << '\n';
+  return ss.str();
+}
+
+// context parameters of a list of aluminum_shark_Arguments. the struct is
+// defined by the plugin so it is a template parameter here
+template <class Argument>
+std::string capture_arguments(const std::vector<Argument>& arguments) {
+  std::string parameters;
+  for (const Argument& arg : arguments) {
+    // types as in python/aluminum_shark/c_arguments.py
+    if (arg.type == 0 && arg.is_array) {
+      const long* array = reinterpret_cast<const long*>(arg.array_);
+      parameters += capture_argument(
+          arg.name, std::vector<long>(array, array + arg.size_));
+    } else if (arg.type == 0) {
+      parameters += capture_argument(arg.name, static_cast<long>(arg.int_));
+    } else if (arg.type == 1 && arg.is_array) {
+      const double* array = reinterpret_cast<const double*>(arg.array_);
+      parameters += capture_argument(
+          arg.name, std::vector<double>(array, array + arg.size_));
+    } else if (arg.type == 1) {
+      parameters +=
+          capture_argument(arg.name, static_cast<double>(arg.double_));
+    } else if (arg.type == 2 && !arg.is_array) {
+      parameters += capture_argument(arg.name, std::string(arg.string_));
+    }
+  }
+  return parameters;
+}
+
+// records one operation. only the outermost operation of a thread is
+// recorded, operations that are implemented through other operations are
+// captured once. the record is written when the object is destroyed, unless
+// the operation threw. all setters are no-ops if the object is not active
+class OpCapture {
+ public:
+  OpCapture(CAPTURE_OP op, bool inplace);
+  ~OpCapture();
+
+  OpCapture(OpCapture&& other);
+  OpCapture(const OpCapture&) = delete;
+  OpCapture& operator=(const OpCapture&) = delete;
+
+  bool active() const { return _active; }
+
+  void lhs(const void* ctxt, int level, double scale);
+  void rhs(const void* ctxt, int level, double scale);
+  void plain(size_t values, uint64_t hash, bool doubles, bool all_zero,
+             bool all_one);
+  void scalar(long value);
+  void scalar(double value);
+  void steps(int steps);
+  // the ciphertext created by the operation
+  void result(const void* ctxt);
+
+ private:
+  CaptureRecord _record{};
+  const void* _lhs = nullptr;
+  const void* _rhs = nullptr;
+  const void* _result = nullptr;
+  bool _active;
+  int _uncaught;
+  std::chrono::steady_clock::time_point _start;
+};
+
+// a capture file
+struct Capture {
+  struct Context {
+    bool ckks;
+    bool from_arguments;
+    std::string parameters;
+  };
+  std::vector<Context> contexts;
+  std::vector<CaptureRecord> records;
+};
+
+// reads a capture file. throws std::runtime_error if it can't be read
+Capture read_capture(const std::string& file);
+
+// name of the operation of `record`, e.g. "mult_plain_inplace"
+std::string capture_op_name(const CaptureRecord& record);
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_OP_CAPTURE_H */
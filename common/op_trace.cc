@@ -0,0 +1,175 @@
+#include "op_trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "backend_logging.h"
+#include "object_count.h"
+
+namespace {
+
+struct TraceEvent {
+  const char* op;
+  int lhs_level;
+  int rhs_level;
+  int64_t start_ns;
+  int64_t end_ns;
+  int64_t bytes;
+};
+
+// events of one thread. the owning thread is the only writer, the lock is
+// only contended while the trace is written
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<TraceEvent> events;
+  // total number of events recorded. events[recorded % capacity] is next
+  size_t recorded = 0;
+  uint32_t tid;
+};
+
+size_t buffer_capacity() {
+  static const size_t capacity = []() -> size_t {
+    const char* value = std::getenv("ALUMINUM_SHARK_TRACE_BUFFER");
+    if (value != nullptr && std::stoi(value) > 0) {
+      return std::stoi(value);
+    }
+    return 1 << 16;
+  }();
+  return capacity;
+}
+
+std::atomic<bool> enabled{[] {
+  const char* value = std::getenv("ALUMINUM_SHARK_TRACE");
+  bool ret = value != nullptr && std::stoi(value) == 1;
+  BACKEND_LOG << "using tracing: " << ret << std::endl;
+  return ret;
+}()};
+
+// buffers of all threads that recorded events. they outlive their threads so
+// the events of finished threads are still written
+std::mutex buffers_mutex;
+std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+
+ThreadBuffer& thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> local = [] {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    buffer->events.resize(buffer_capacity());
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffer->tid = buffers.size();
+    buffers.push_back(buffer);
+    return buffer;
+  }();
+  return *local;
+}
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void write_event(std::ostream& out, const TraceEvent& event, uint32_t tid) {
+  // chrome traces use microseconds
+  out << "{\"name\":\"" << event.op << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+      << tid << ",\"ts\":" << event.start_ns / 1e3
+      << ",\"dur\":" << (event.end_ns - event.start_ns) / 1e3
+      << ",\"args\":{\"lhs_level\":" << event.lhs_level
+      << ",\"rhs_level\":" << event.rhs_level << ",\"bytes\":" << event.bytes
+      << "}}";
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+void enable_tracing(bool enable) {
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool tracing_enabled() { return enabled.load(std::memory_order_relaxed); }
+
+TraceSpan::TraceSpan(const char* op, int lhs_level, int rhs_level)
+    : _op(op),
+      _lhs_level(lhs_level),
+      _rhs_level(rhs_level),
+      _enabled(tracing_enabled()) {
+  if (_enabled) {
+    _start_bytes = get_thread_allocated_bytes();
+    _start_ns = now_ns();
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  if (!_enabled) {
+    return;
+  }
+  int64_t end_ns = now_ns();
+  int64_t bytes = AS_OBJECT_COUNT
+                      ? get_thread_allocated_bytes() - _start_bytes
+                      : 0;
+  ThreadBuffer& buffer = thread_buffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.events[buffer.recorded % buffer.events.size()] = {
+      _op, _lhs_level, _rhs_level, _start_ns, end_ns, bytes};
+  ++buffer.recorded;
+}
+
+size_t write_trace(const std::string& file) {
+  std::ofstream out(file);
+  if (!out) {
+    throw std::runtime_error("can't write trace to " + file);
+  }
+  // nanosecond resolution for the microsecond timestamps
+  out << std::fixed << std::setprecision(3);
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,"
+         "\"args\":{\"name\":\"backend\"}}";
+  size_t written = 0;
+  std::lock_guard<std::mutex> buffers_lock(buffers_mutex);
+  for (const std::shared_ptr<ThreadBuffer>& buffer : buffers) {
+    std::lock_guard<std::mutex> lock(buffer->mutex);
+    const size_t capacity = buffer->events.size();
+    // oldest event first. older events have been overwritten
+    size_t first =
+        buffer->recorded > capacity ? buffer->recorded - capacity : 0;
+    for (size_t i = first; i < buffer->recorded; ++i) {
+      out << ",\n";
+      write_event(out, buffer->events[i % capacity], buffer->tid);
+      ++written;
+    }
+    buffer->recorded = 0;
+  }
+  out << "\n]}\n";
+  if (!out) {
+    throw std::runtime_error("can't write trace to " + file);
+  }
+  BACKEND_LOG << "wrote " << written << " trace events to " << file
+              << std::endl;
+  return written;
+}
+
+}  // namespace aluminum_shark
+
+extern "C" {
+
+void aluminum_shark_enable_tracing(bool enable) {
+  aluminum_shark::enable_tracing(enable);
+}
+
+long aluminum_shark_write_trace(const char* file) {
+  try {
+    return aluminum_shark::write_trace(file);
+  } catch (const std::exception& e) {
+    BACKEND_LOG << e.what() << std::endl;
+    return -1;
+  }
+}
+
+}  // extern "C"
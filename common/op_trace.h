@@ -0,0 +1,62 @@
+#ifndef ALUMINUM_SHARK_COMMON_OP_TRACE_H
+#define ALUMINUM_SHARK_COMMON_OP_TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// span tracing of backend operations. while tracing is enabled every TraceSpan
+// records an event into a ring buffer of its thread. `write_trace` writes the
+// buffered events as Chrome trace JSON which can be opened in chrome://tracing
+// or ui.perfetto.dev.
+//
+// tracing is enabled with ALUMINUM_SHARK_TRACE=1 or `enable_tracing`. each
+// thread keeps the last ALUMINUM_SHARK_TRACE_BUFFER events (default 65536).
+// timestamps are taken from the steady clock, which is CLOCK_MONOTONIC on
+// Linux, the clock of python's time.monotonic_ns(). so the events line up with
+// spans recorded in python.
+
+namespace aluminum_shark {
+
+void enable_tracing(bool enable);
+bool tracing_enabled();
+
+// records the time spent in its scope as an event named `op`. the levels of
+// the operands are stored as arguments of the event, -1 means not applicable.
+// if object counting is enabled (ALUMINUM_SHARK_COUNT_BACKEND_OBJ) the bytes
+// allocated by the thread during the span are stored as well
+class TraceSpan {
+ public:
+  explicit TraceSpan(const char* op, int lhs_level = -1, int rhs_level = -1);
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+ private:
+  const char* const _op;
+  const int _lhs_level;
+  const int _rhs_level;
+  const bool _enabled;
+  int64_t _start_ns = 0;
+  int64_t _start_bytes = 0;
+};
+
+// writes all buffered events of all threads to `file` and clears the buffers.
+// returns the number of events written. throws if `file` can't be written
+size_t write_trace(const std::string& file);
+
+}  // namespace aluminum_shark
+
+// C interface. the python module loads the backend library directly to call
+// these
+extern "C" {
+
+void aluminum_shark_enable_tracing(bool enable);
+
+// returns the number of events written or -1 on error
+long aluminum_shark_write_trace(const char* file);
+
+}  // extern "C"
+
+#endif /* ALUMINUM_SHARK_COMMON_OP_TRACE_H */
@@ -0,0 +1,19 @@
+#include "parallel.h"
+
+#include <cstdlib>
+#include <string>
+
+namespace aluminum_shark {
+
+size_t batch_threads() {
+  static const size_t threads = []() -> size_t {
+    const char* value = std::getenv("ALUMINUM_SHARK_BATCH_THREADS");
+    if (value != nullptr && std::stoi(value) > 0) {
+      return std::stoi(value);
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+  }();
+  return threads;
+}
+
+}  // namespace aluminum_shark
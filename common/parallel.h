@@ -0,0 +1,110 @@
+#ifndef ALUMINUM_SHARK_COMMON_PARALLEL_H
+#define ALUMINUM_SHARK_COMMON_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aluminum_shark {
+
+// number of worker threads used by the batch functions of the contexts. set
+// with ALUMINUM_SHARK_BATCH_THREADS, defaults to the number of cores
+size_t batch_threads();
+
+// calls `f(i)` for every i in [0, n) on up to `threads` threads (0 selects
+// `batch_threads()`). the calling thread is one of the workers. indices are
+// handed out one at a time, so uneven work is balanced. if `f` throws the
+// remaining indices are skipped and the first exception is rethrown once all
+// threads are done
+template <class F>
+void parallel_for(size_t n, size_t threads, F&& f) {
+  if (threads == 0) {
+    threads = batch_threads();
+  }
+  threads = std::max<size_t>(1, std::min(threads, n));
+  std::atomic<size_t> next{0};
+  std::exception_ptr error;
+  std::mutex error_mutex;
+  auto work = [&]() {
+    for (size_t i = next.fetch_add(1); i < n; i = next.fetch_add(1)) {
+      try {
+        f(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        next.store(n);
+      }
+    }
+  };
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (size_t t = 1; t < threads; ++t) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+// position of the values of a batch of ciphertexts in a flat buffer. value
+// `slot` of ciphertext `ctxt` is stored at `ctxt * ctxt_stride + slot *
+// slot_stride`. this covers the layouts of the plugin: one value per
+// ciphertext (simple), the first axis in the slots (batch) and rows of a
+// row-major array (e2e and standalone batches)
+struct BatchLayout {
+  // number of ciphertexts
+  size_t count = 0;
+  // values per ciphertext
+  size_t slots = 0;
+  size_t ctxt_stride = 0;
+  size_t slot_stride = 1;
+
+  size_t index(size_t ctxt, size_t slot) const {
+    return ctxt * ctxt_stride + slot * slot_stride;
+  }
+
+  // `count` rows of `slots` consecutive values
+  static BatchLayout rows(size_t count, size_t slots) {
+    return BatchLayout{count, slots, slots, 1};
+  }
+
+  // a row-major `slots` x `count` array. ciphertext i holds column i
+  static BatchLayout columns(size_t slots, size_t count) {
+    return BatchLayout{count, slots, 1, count};
+  }
+
+  // copies the values of ciphertext `ctxt` from `values` into `out`
+  template <class T, class U>
+  void gather(const T* values, size_t ctxt, std::vector<U>& out) const {
+    out.resize(slots);
+    const T* src = values + ctxt * ctxt_stride;
+    for (size_t j = 0; j < slots; ++j) {
+      out[j] = static_cast<U>(src[j * slot_stride]);
+    }
+  }
+
+  // copies the first `slots` values of `in` to the positions of ciphertext
+  // `ctxt` in `values`
+  template <class T, class U>
+  void scatter(const std::vector<U>& in, size_t ctxt, T* values) const {
+    T* dst = values + ctxt * ctxt_stride;
+    size_t n = std::min(slots, in.size());
+    for (size_t j = 0; j < n; ++j) {
+      dst[j * slot_stride] = static_cast<T>(in[j]);
+    }
+  }
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_PARALLEL_H */
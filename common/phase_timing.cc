@@ -0,0 +1,170 @@
+#include "phase_timing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+using aluminum_shark::N_PHASES;
+using aluminum_shark::PHASE;
+using aluminum_shark::TIMED_LEVELS;
+
+// histogram buckets. durations below 4ns have a bucket each, every power of
+// two above is split into 4 buckets. covers all 64 bit durations
+constexpr size_t n_buckets = 256;
+
+size_t bucket(uint64_t ns) {
+  if (ns < 4) {
+    return ns;
+  }
+  size_t exponent = 63 - __builtin_clzll(ns);
+  size_t sub = (ns >> (exponent - 2)) & 3;
+  return 4 * (exponent - 1) + sub;
+}
+
+// center of the durations that fall into bucket `i`
+double bucket_center(size_t i) {
+  if (i < 4) {
+    return i;
+  }
+  size_t exponent = i / 4 + 1;
+  double width = static_cast<double>(uint64_t{1} << (exponent - 2));
+  return (4 + i % 4) * width + width / 2;
+}
+
+// every thread records into its own shard, readers sum up all shards
+constexpr size_t n_shards = 32;
+
+struct alignas(64) Shard {
+  std::atomic<uint64_t> buckets[N_PHASES][n_buckets] = {};
+  std::atomic<uint64_t> level_ns[N_PHASES][TIMED_LEVELS] = {};
+};
+
+Shard shards[n_shards];
+std::atomic<size_t> next_shard{0};
+std::atomic<bool> enabled{false};
+
+Shard& shard() {
+  thread_local Shard& local =
+      shards[next_shard.fetch_add(1, std::memory_order_relaxed) % n_shards];
+  return local;
+}
+
+size_t index(PHASE phase) { return static_cast<size_t>(phase); }
+
+// merged histogram of `phase`
+void merged(PHASE phase, uint64_t (&buckets)[n_buckets]) {
+  std::fill(buckets, buckets + n_buckets, 0);
+  for (const Shard& s : shards) {
+    for (size_t i = 0; i < n_buckets; ++i) {
+      buckets[i] += s.buckets[index(phase)][i].load(std::memory_order_relaxed);
+    }
+  }
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+void enable_phase_timing(bool enable) {
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool phase_timing_enabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+const char* phase_name(PHASE phase) {
+  switch (phase) {
+    case PHASE::TENSOR_PRODUCT:
+      return "tensor_product";
+    case PHASE::PLAIN_PRODUCT:
+      return "plain_product";
+    case PHASE::RELINEARIZE:
+      return "relinearize";
+    case PHASE::RESCALE:
+      return "rescale";
+    case PHASE::MATCH_SCALE:
+      return "match_scale";
+    case PHASE::ROTATE:
+      return "rotate";
+    default:
+      return "unknown";
+  }
+}
+
+PhaseTimer::PhaseTimer(PHASE phase, size_t level)
+    : _phase(phase),
+      _level(std::min(level, TIMED_LEVELS - 1)),
+      _enabled(phase_timing_enabled()) {
+  if (_enabled) {
+    _start = std::chrono::steady_clock::now();
+  }
+}
+
+PhaseTimer::~PhaseTimer() {
+  if (!_enabled) {
+    return;
+  }
+  uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - _start)
+                    .count();
+  Shard& s = shard();
+  s.buckets[index(_phase)][bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+  s.level_ns[index(_phase)][_level].fetch_add(ns, std::memory_order_relaxed);
+}
+
+uint64_t phase_count(PHASE phase) {
+  uint64_t buckets[n_buckets];
+  merged(phase, buckets);
+  uint64_t count = 0;
+  for (uint64_t b : buckets) {
+    count += b;
+  }
+  return count;
+}
+
+double phase_total_us(PHASE phase) {
+  double total = 0;
+  for (size_t level = 0; level < TIMED_LEVELS; ++level) {
+    total += phase_level_total_us(phase, level);
+  }
+  return total;
+}
+
+double phase_level_total_us(PHASE phase, size_t level) {
+  if (level >= TIMED_LEVELS) {
+    return 0;
+  }
+  uint64_t ns = 0;
+  for (const Shard& s : shards) {
+    ns += s.level_ns[index(phase)][level].load(std::memory_order_relaxed);
+  }
+  return ns / 1e3;
+}
+
+double phase_quantile_us(PHASE phase, double q) {
+  uint64_t buckets[n_buckets];
+  merged(phase, buckets);
+  uint64_t count = 0;
+  for (uint64_t b : buckets) {
+    count += b;
+  }
+  if (count == 0) {
+    return 0;
+  }
+  // rank of the quantile, 1 based
+  uint64_t rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * count)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < n_buckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return bucket_center(i) / 1e3;
+    }
+  }
+  return bucket_center(n_buckets - 1) / 1e3;
+}
+
+}  // namespace aluminum_shark
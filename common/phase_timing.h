@@ -0,0 +1,61 @@
+#ifndef ALUMINUM_SHARK_COMMON_PHASE_TIMING_H
+#define ALUMINUM_SHARK_COMMON_PHASE_TIMING_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace aluminum_shark {
+
+// phases of the ciphertext operations that are timed
+enum class PHASE : size_t {
+  TENSOR_PRODUCT,  // ctxt x ctxt multiplication without relinearization
+  PLAIN_PRODUCT,   // ctxt x ptxt multiplication
+  RELINEARIZE,
+  RESCALE,
+  MATCH_SCALE,  // scale and level matching of operands
+  ROTATE,
+  COUNT
+};
+constexpr size_t N_PHASES = static_cast<size_t>(PHASE::COUNT);
+
+// the time spent per level is recorded for this many levels. higher levels are
+// recorded in the last one
+constexpr size_t TIMED_LEVELS = 16;
+
+// timing is off by default. while it is off a PhaseTimer only checks a flag
+void enable_phase_timing(bool enable);
+bool phase_timing_enabled();
+
+// lower case name of the phase, e.g. "tensor_product"
+const char* phase_name(PHASE phase);
+
+// records the time spent in its scope for `phase` at `level`. the durations are
+// collected in per-thread log-bucketed histograms, recording doesn't take a
+// lock
+class PhaseTimer {
+ public:
+  PhaseTimer(PHASE phase, size_t level);
+  ~PhaseTimer();
+
+  PhaseTimer(const PhaseTimer&) = delete;
+  PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+ private:
+  const PHASE _phase;
+  const size_t _level;
+  const bool _enabled;
+  std::chrono::steady_clock::time_point _start;
+};
+
+// statistics merged over all threads. durations are in microseconds
+uint64_t phase_count(PHASE phase);
+double phase_total_us(PHASE phase);
+double phase_level_total_us(PHASE phase, size_t level);
+// the `q` quantile (0 <= q <= 1) of the durations of `phase`. accurate to the
+// width of a histogram bucket, a quarter of a power of two
+double phase_quantile_us(PHASE phase, double q);
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_PHASE_TIMING_H */
@@ -0,0 +1,159 @@
+#include "rotation_keys.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+int normalize(long step, int slots) {
+  return static_cast<int>(((step % slots) + slots) % slots);
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+std::vector<int> naf(int value) {
+  std::vector<int> result;
+  long v = value;
+  long power = 1;
+  while (v != 0) {
+    if (v & 1) {
+      // pick the digit that makes the remaining value divisible by 4
+      long digit = 2 - ((v % 4) + 4) % 4;
+      result.push_back(static_cast<int>(digit * power));
+      v -= digit;
+    }
+    v /= 2;
+    power *= 2;
+  }
+  return result;
+}
+
+std::vector<int> power_of_two_steps(int slots) {
+  std::vector<int> result;
+  for (int i = 1; i < slots; i *= 2) {
+    result.push_back(i);
+    result.push_back(-i);
+  }
+  return result;
+}
+
+bool compose_rotation(int step, int slots, const std::vector<int>& available,
+                      std::vector<int>& plan) {
+  plan.clear();
+  const int target = normalize(step, slots);
+  if (target == 0) {
+    return true;
+  }
+  // normalized step -> step the key was generated for
+  std::unordered_map<int, int> keys;
+  for (int s : available) {
+    int n = normalize(s, slots);
+    if (n != 0) {
+      keys.emplace(n, s);
+    }
+  }
+  auto key = keys.find(target);
+  if (key != keys.end()) {
+    plan.push_back(key->second);
+    return true;
+  }
+
+  // NAF of the step going left and right. take the shorter one that only
+  // uses available keys
+  for (long candidate : {static_cast<long>(target),
+                         static_cast<long>(target) - slots}) {
+    std::vector<int> digits = naf(static_cast<int>(candidate));
+    bool complete = std::all_of(digits.begin(), digits.end(), [&](int d) {
+      return keys.count(normalize(d, slots)) != 0;
+    });
+    if (complete && (plan.empty() || digits.size() < plan.size())) {
+      plan.clear();
+      for (int d : digits) {
+        plan.push_back(keys[normalize(d, slots)]);
+      }
+    }
+  }
+  if (!plan.empty()) {
+    return true;
+  }
+
+  // breadth first search over the rotation amounts reachable with the
+  // available keys. finds the shortest sequence. sequences longer than the
+  // NAF over all power of two keys are not worth it
+  int max_length = 1;
+  for (int i = 1; i < slots; i *= 2) {
+    ++max_length;
+  }
+  std::vector<int> previous(slots, -1);
+  std::vector<int> length(slots, 0);
+  std::queue<int> queue;
+  previous[0] = 0;
+  queue.push(0);
+  while (!queue.empty() && previous[target] == -1) {
+    int current = queue.front();
+    queue.pop();
+    if (length[current] == max_length) {
+      continue;
+    }
+    for (const auto& k : keys) {
+      int next = (current + k.first) % slots;
+      if (previous[next] == -1) {
+        previous[next] = current;
+        length[next] = length[current] + 1;
+        queue.push(next);
+      }
+    }
+  }
+  if (previous[target] == -1) {
+    return false;
+  }
+  for (int current = target; current != 0; current = previous[current]) {
+    plan.push_back(keys[normalize(current - previous[current], slots)]);
+  }
+  std::reverse(plan.begin(), plan.end());
+  return true;
+}
+
+std::atomic<uint64_t> RotationStepLog::next_id{0};
+
+void RotationStepLog::record(int step) {
+  // the thread's sets of all logs it recorded into. sets of destroyed logs
+  // are dropped when a new one is added
+  thread_local std::unordered_map<uint64_t, std::weak_ptr<ThreadSteps>> local;
+  auto it = local.find(_id);
+  std::shared_ptr<ThreadSteps> steps;
+  if (it != local.end()) {
+    steps = it->second.lock();
+  }
+  if (!steps) {
+    for (auto i = local.begin(); i != local.end();) {
+      i = i->second.expired() ? local.erase(i) : std::next(i);
+    }
+    steps = std::make_shared<ThreadSteps>();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _threads.push_back(steps);
+    }
+    local[_id] = steps;
+  }
+  // only contended while the steps are read
+  std::lock_guard<std::mutex> lock(steps->mutex);
+  steps->steps.insert(step);
+}
+
+std::vector<int> RotationStepLog::steps() const {
+  std::set<int> merged;
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (const auto& thread : _threads) {
+    std::lock_guard<std::mutex> thread_lock(thread->mutex);
+    merged.insert(thread->steps.begin(), thread->steps.end());
+  }
+  return std::vector<int>(merged.begin(), merged.end());
+}
+
+}  // namespace aluminum_shark
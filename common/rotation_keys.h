@@ -0,0 +1,57 @@
+#ifndef ALUMINUM_SHARK_COMMON_ROTATION_KEYS_H
+#define ALUMINUM_SHARK_COMMON_ROTATION_KEYS_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace aluminum_shark {
+
+// non-adjacent form of `value`. returns the signed powers of two that sum up
+// to `value`, no two of them are adjacent powers
+std::vector<int> naf(int value);
+
+// the steps the libraries generate rotation keys for by default: +-2^i for
+// all powers of two smaller than `slots`
+std::vector<int> power_of_two_steps(int slots);
+
+// splits a rotation by `step` into a sequence of rotations by the steps in
+// `available` (the steps keys were generated for). tries a single key, the
+// NAF of the step and finally the shortest sequence of available keys.
+// `plan` is empty if `step` is a multiple of `slots`. returns false if the
+// rotation can't be composed from the available keys
+bool compose_rotation(int step, int slots, const std::vector<int>& available,
+                      std::vector<int>& plan);
+
+// the rotation steps a context has used. every thread records into its own
+// set, so rotations on different threads don't wait for each other. the
+// context's lock is only taken the first time a thread records a step
+class RotationStepLog {
+ public:
+  RotationStepLog() = default;
+  RotationStepLog(const RotationStepLog&) = delete;
+  RotationStepLog& operator=(const RotationStepLog&) = delete;
+
+  void record(int step);
+  // the steps recorded by all threads, sorted
+  std::vector<int> steps() const;
+
+ private:
+  struct ThreadSteps {
+    std::mutex mutex;
+    std::set<int> steps;
+  };
+
+  static std::atomic<uint64_t> next_id;
+  // identifies the log in the threads' sets. the address could be reused
+  const uint64_t _id = next_id++;
+  mutable std::mutex _mutex;
+  std::vector<std::shared_ptr<ThreadSteps>> _threads;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_ROTATION_KEYS_H */
@@ -0,0 +1,138 @@
+#include "section_file.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char MAGIC[4] = {'A', 'S', 'S', 'F'};
+const uint32_t VERSION = 1;
+
+template <class T>
+T read_value(const char*& pos, const char* end, const std::string& file) {
+  if (static_cast<size_t>(end - pos) < sizeof(T)) {
+    throw std::runtime_error(file + " is truncated");
+  }
+  T value;
+  std::memcpy(&value, pos, sizeof(T));
+  pos += sizeof(T);
+  return value;
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+SectionWriter::SectionWriter(const std::string& file,
+                             const std::string& backend, bool secret)
+    : _file(file) {
+  if (secret) {
+    // an existing file keeps its permissions when it is opened, so they are
+    // set on the descriptor as well
+    int fd = ::open(file.c_str(), O_CREAT | O_WRONLY | O_TRUNC,
+                    S_IRUSR | S_IWUSR);
+    if (fd < 0) {
+      throw std::runtime_error("failed to create " + file);
+    }
+    int failed = ::fchmod(fd, S_IRUSR | S_IWUSR);
+    ::close(fd);
+    if (failed != 0) {
+      throw std::runtime_error("failed to restrict the permissions of " +
+                               file);
+    }
+  }
+  _out.open(file, std::ios::binary | std::ios::trunc);
+  if (!_out) {
+    throw std::runtime_error("failed to create " + file);
+  }
+  uint32_t name_size = backend.size();
+  _out.write(MAGIC, sizeof(MAGIC));
+  _out.write(reinterpret_cast<const char*>(&VERSION), sizeof(VERSION));
+  _out.write(reinterpret_cast<const char*>(&name_size), sizeof(name_size));
+  _out.write(backend.data(), name_size);
+}
+
+void SectionWriter::add(Section tag,
+                        const std::function<void(std::ostream&)>& write) {
+  uint32_t t = static_cast<uint32_t>(tag);
+  uint64_t size = 0;
+  _out.write(reinterpret_cast<const char*>(&t), sizeof(t));
+  // the size is only known after the content is written
+  std::streampos size_pos = _out.tellp();
+  _out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  std::streampos begin = _out.tellp();
+  write(_out);
+  std::streampos end = _out.tellp();
+  size = end - begin;
+  _out.seekp(size_pos);
+  _out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  _out.seekp(end);
+}
+
+void SectionWriter::add(Section tag, const void* data, size_t size) {
+  add(tag, [data, size](std::ostream& out) {
+    out.write(static_cast<const char*>(data), size);
+  });
+}
+
+void SectionWriter::close() {
+  _out.close();
+  if (!_out) {
+    throw std::runtime_error("failed to write " + _file);
+  }
+}
+
+SectionReader::SectionReader(const std::string& file,
+                             const std::string& backend)
+    : _file(file), _mapped(file) {
+  const char* pos = _mapped.data();
+  const char* end = pos + _mapped.size();
+  if (_mapped.size() < sizeof(MAGIC) ||
+      std::memcmp(pos, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error(file + " is not a key file");
+  }
+  pos += sizeof(MAGIC);
+  uint32_t version = read_value<uint32_t>(pos, end, file);
+  if (version != VERSION) {
+    throw std::runtime_error(file + " has unsupported version " +
+                             std::to_string(version));
+  }
+  uint32_t name_size = read_value<uint32_t>(pos, end, file);
+  if (static_cast<size_t>(end - pos) < name_size) {
+    throw std::runtime_error(file + " is truncated");
+  }
+  std::string name(pos, name_size);
+  pos += name_size;
+  if (name != backend) {
+    throw std::runtime_error(file + " was written by " + name + " not " +
+                             backend);
+  }
+  while (pos != end) {
+    Section tag = static_cast<Section>(read_value<uint32_t>(pos, end, file));
+    uint64_t size = read_value<uint64_t>(pos, end, file);
+    if (static_cast<uint64_t>(end - pos) < size) {
+      throw std::runtime_error(file + " is truncated");
+    }
+    _sections[tag] = std::make_pair(pos, size);
+    pos += size;
+  }
+}
+
+bool SectionReader::has(Section tag) const {
+  return _sections.find(tag) != _sections.end();
+}
+
+std::pair<const char*, size_t> SectionReader::get(Section tag) const {
+  auto it = _sections.find(tag);
+  if (it == _sections.end()) {
+    throw std::runtime_error(_file + " has no section " +
+                             std::to_string(static_cast<uint32_t>(tag)));
+  }
+  return it->second;
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,69 @@
+#ifndef ALUMINUM_SHARK_COMMON_SECTION_FILE_H
+#define ALUMINUM_SHARK_COMMON_SECTION_FILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "mapped_file.h"
+
+namespace aluminum_shark {
+
+// On disk format used to persist keys and parameters. A header
+// (magic "ASSF", uint32 version, backend name) is followed by sections. Every
+// section is a uint32 tag, the uint64 size of the content and the content.
+// The content is whatever the backend library serializes, so the format stays
+// the same for all backends.
+enum class Section : uint32_t {
+  PARAMETERS = 1,
+  PUBLIC_KEY = 2,
+  RELIN_KEYS = 3,
+  GALOIS_KEYS = 4,
+  SECRET_KEY = 5,
+  ROTATION_STEPS = 6,
+  SCALE = 7,
+};
+
+class SectionWriter {
+ public:
+  // throws std::runtime_error if the file can't be created. a `secret` file
+  // is only readable by its owner, before anything is written to it
+  SectionWriter(const std::string& file, const std::string& backend,
+                bool secret = false);
+
+  // adds a section. `write` writes the content into the stream
+  void add(Section tag, const std::function<void(std::ostream&)>& write);
+  void add(Section tag, const void* data, size_t size);
+
+  // flushes the file. throws std::runtime_error if writing failed
+  void close();
+
+ private:
+  std::string _file;
+  std::ofstream _out;
+};
+
+class SectionReader {
+ public:
+  // maps `file` into memory and reads the section table. throws
+  // std::runtime_error if the file is not a section file written by
+  // `backend`
+  SectionReader(const std::string& file, const std::string& backend);
+
+  bool has(Section tag) const;
+
+  // content of the section. throws std::runtime_error if it is missing
+  std::pair<const char*, size_t> get(Section tag) const;
+
+ private:
+  std::string _file;
+  MappedFile _mapped;
+  std::map<Section, std::pair<const char*, size_t>> _sections;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_COMMON_SECTION_FILE_H */
@@ -6,7 +6,10 @@
 #include <stdexcept>
 
 #include "context.h"
+#include "ctxt.h"
+#include "level_cache.h"
 #include "logging.h"
+#include "op_capture.h"
 #include "openfhe.h"
 #include "python/arg_utils.h"
 
@@ -21,6 +24,35 @@ std::shared_ptr<aluminum_shark::HEBackend> createBackend() {
   AS_LOG_INFO << " Created OpenFHEBackend " << std::endl;
   return ptr;
 }
+
+// batch encryption for callers that only hold the HEContext of this backend,
+// e.g. the C API of the plugin (see OpenFHEContext::encryptBatch)
+void encryptBatchDouble(aluminum_shark::HEContext* context,
+                        const double* values,
+                        const aluminum_shark::BatchLayout& layout,
+                        std::shared_ptr<aluminum_shark::HECtxt>* out,
+                        size_t threads) {
+  static_cast<aluminum_shark::OpenFHEContext*>(context)->encryptBatch(
+      values, layout, out, "", threads);
+}
+
+void decryptBatchDouble(aluminum_shark::HEContext* context,
+                        const std::shared_ptr<aluminum_shark::HECtxt>* ctxts,
+                        const aluminum_shark::BatchLayout& layout,
+                        double* values, size_t threads) {
+  static_cast<aluminum_shark::OpenFHEContext*>(context)->decryptBatch(
+      ctxts, layout, values, threads);
+}
+
+// see OpenFHEContext::linearCombination. `bias` may be nullptr
+std::shared_ptr<aluminum_shark::HECtxt> linearCombination(
+    aluminum_shark::HEContext* context,
+    const std::vector<std::shared_ptr<aluminum_shark::HECtxt>>& ctxts,
+    const std::vector<std::shared_ptr<aluminum_shark::HEPtxt>>& ptxts,
+    std::shared_ptr<aluminum_shark::HEPtxt> bias) {
+  auto* he_context = static_cast<aluminum_shark::OpenFHEContext*>(context);
+  return he_context->linearCombination(ctxts, ptxts, bias);
+}
 }  // extern "C"
 
 namespace {
@@ -53,6 +85,9 @@ HEContext* OpenFHEBackend::createContextCKKS(
   AS_LOG_INFO << "Creating Context. Arguments\n"
               << args_to_string(arguments) << std::endl;
   lbcrypto::CCParams<lbcrypto::CryptoContextCKKSRNS> params;
+  bool lazy_evaluation = false;
+  bool rotation_keys = true;
+  std::vector<int> rotation_steps;
   for (const aluminum_shark_Argument& arg : arguments) {
     const char* name = arg.name;
     AS_LOG_DEBUG << "Processing argument: " << name << " type: " << arg.type
@@ -81,6 +116,27 @@ HEContext* OpenFHEBackend::createContextCKKS(
       }
       params.SetRingDim(arg.int_);
       continue;
+    } else if (std::strcmp(name, "lazy_evaluation") == 0) {
+      if (arg.type != 0 || arg.array_) {
+        AS_LOG_CRITICAL << name << " needs to be scalar int" << std::endl;
+      }
+      lazy_evaluation = arg.int_;
+      continue;
+    } else if (std::strcmp(name, "galois_keys") == 0) {
+      if (arg.type != 0 || arg.array_) {
+        AS_LOG_CRITICAL << name << " needs to be scalar int" << std::endl;
+      }
+      rotation_keys = arg.int_ != 0;
+      continue;
+    } else if (std::strcmp(name, "rotation_steps") == 0) {
+      if (arg.type != 0 || !arg.is_array) {
+        AS_LOG_CRITICAL << name << " needs to be int array" << std::endl;
+      }
+      long* arr = reinterpret_cast<long*>(arg.array_);
+      for (size_t i = 0; i < arg.size_; i++) {
+        rotation_steps.push_back(arr[i]);
+      }
+      continue;
     }
   }
   params.SetScalingTechnique(ScalingTechnique::FLEXIBLEAUTO);
@@ -92,7 +148,10 @@ HEContext* OpenFHEBackend::createContextCKKS(
   context->Enable(PKESchemeFeature::KEYSWITCH);
   context->Enable(PKESchemeFeature::LEVELEDSHE);
 
-  return new OpenFHEContext(context, *this);
+  HEContext* he_context = new OpenFHEContext(
+      context, *this, lazy_evaluation, rotation_keys, rotation_steps);
+  capture_context(true, true, capture_arguments(arguments));
+  return he_context;
 }
 
 const std::string& OpenFHEBackend::name() { return BACKEND_NAME; }
@@ -103,7 +162,95 @@ void OpenFHEBackend::set_log_level(int level) {
   ::aluminum_shark::set_log_level(level);
 }
 
+std::shared_ptr<Monitor> OpenFHEBackend::enable_ressource_monitor(
+    bool enable) const {
+  if (enable) {
+    if (!OpenFHEMonitor::instance) {
+      OpenFHEMonitor::instance = std::make_shared<OpenFHEMonitor>();
+    }
+    OpenFHECtxt::count_ops = true;
+  } else {
+    OpenFHEMonitor::instance = nullptr;
+    OpenFHECtxt::count_ops = false;
+  }
+  return OpenFHEMonitor::instance;
+}
+
 // monitor stuff
-const std::vector<std::string> OpenFHEMonitor::supported_values;
+std::shared_ptr<OpenFHEMonitor> OpenFHEMonitor::instance;
+
+// the level reductions and rescales done by FLEXIBLEAUTO are bookkeeping,
+// not operations. like in SEALMonitor their names don't start with `ctxt_` so
+// they are not counted as operations
+const std::vector<std::string> OpenFHEMonitor::supported_values{
+    "ctxt_ctxt_mulitplication",  //
+    "ctxt_ptxt_mulitplication",  //
+    "ctxt_ctxt_addition",        //
+    "ctxt_ptxt_addition",        //
+    "ctxt_rotation",             //
+    "match_mod_switch",          //
+    "rescale",                   //
+    "level_cache_hits",          //
+    "level_cache_misses",        //
+    "level_cache_rejected"};
+
+// helper. the value_no needs to cooresponds to the index in
+// OpenFHEMonitor::supported_values
+bool OpenFHEMonitor::get_monitor_value(size_t value_no, double& value) {
+  switch (value_no) {
+    case 0:
+      value = OpenFHECtxt::mult_ctxt_count;
+      return true;
+    case 1:
+      value = OpenFHECtxt::mult_ptxt_count;
+      return true;
+    case 2:
+      value = OpenFHECtxt::add_ctxt_count;
+      return true;
+    case 3:
+      value = OpenFHECtxt::add_ptxt_count;
+      return true;
+    case 4:
+      value = OpenFHECtxt::rot_count;
+      return true;
+    case 5:
+      value = OpenFHECtxt::level_reduce_count;
+      return true;
+    case 6:
+      value = OpenFHECtxt::rescale_count;
+      return true;
+    case 7:
+      value = LevelCacheBudget::hits;
+      return true;
+    case 8:
+      value = LevelCacheBudget::misses;
+      return true;
+    case 9:
+      value = LevelCacheBudget::rejected;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool OpenFHEMonitor::get(const std::string& name, double& value) {
+  for (size_t i = 0; i < supported_values.size(); ++i) {
+    if (supported_values[i] == name) {
+      return get_monitor_value(i, value);
+    }
+  }
+  return false;
+}
+
+bool OpenFHEMonitor::get_next(std::string& name, double& value) {
+  name = supported_values[_count];
+  get_monitor_value(_count, value);
+  _count = (_count + 1) % supported_values.size();
+  return _count != 0;
+}
+
+const std::vector<std::string>& OpenFHEMonitor::values() {
+  return supported_values;
+}
 
 }  // namespace aluminum_shark
\ No newline at end of file
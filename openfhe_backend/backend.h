@@ -15,25 +15,31 @@ std::shared_ptr<aluminum_shark::HEBackend> createBackend();
 }  // extern "C"
 namespace aluminum_shark {
 
-// not fully implemented. does nothhing atm
+// counts the operations performed on ciphertexts. uses the same value names as
+// the SEALMonitor. OpenFHE rescales and level reduces operands itself, those
+// adjustments are counted as well
 class OpenFHEMonitor : public Monitor {
  public:
   // retrieves the value specified by name and writes it into value, returns
   // false if the value is not logged or unsoproted;
-  bool get(const std::string& name, double& value) override { return false; };
+  bool get(const std::string& name, double& value) override;
 
   // can be used to iterate over all logged valued by this monitor. puts the
   // name of the value into `name` and the value into `value`. Returns false if
   // there are no more values. Calling it again after that restarts
-  bool get_next(std::string& name, double& value) override { return false; };
+  bool get_next(std::string& name, double& value) override;
 
   // returns a list of all values supported by this monitor
-  const std::vector<std::string>& values() override {
-    return supported_values;
-  };
+  const std::vector<std::string>& values() override;
+
+  static std::shared_ptr<OpenFHEMonitor> instance;
 
  private:
   static const std::vector<std::string> supported_values;
+  size_t _count = 0;
+  // helper. the value_no needs to cooresponds to the index in
+  // OpenFHEMonitor::supported_values
+  bool get_monitor_value(size_t value_no, double& value);
 };
 
 class OpenFHEBackend : public HEBackend {
@@ -59,14 +65,11 @@ class OpenFHEBackend : public HEBackend {
   virtual void set_log_level(int level) override;
 
   std::shared_ptr<Monitor> enable_ressource_monitor(
-      bool enable) const override {
-    return std::make_shared<OpenFHEMonitor>();
-  };
+      bool enable) const override;
 
   std::shared_ptr<Monitor> get_ressource_monitor() const override {
-    return std::make_shared<OpenFHEMonitor>();
+    return OpenFHEMonitor::instance;
   };
-  ;
 
  private:
   const API_VERSION version_;
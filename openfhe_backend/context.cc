@@ -2,14 +2,24 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <memory>
+#include <stdexcept>
 #include <string>
 
 #include "backend_logging.h"
 #include "context.h"
+#include "ciphertext-ser.h"
+#include "cryptocontext-ser.h"
 #include "ctxt.h"
+#include "ctxt_file.h"
+#include "key/key-ser.h"
 #include "ptxt.h"
+#include "scheme/ckksrns/ckksrns-ser.h"
+#include "section_file.h"
 #include "utils/utils.h"
 
 namespace {
@@ -18,6 +28,31 @@ const std::string BACKEND_NAME = "OpenFHE Backend";
 const std::string BACKEND_STRING = BACKEND_NAME;
 // BACKEND_NAME + " using OpenFHE " + OpenFHEBackend();
 
+double to_mb(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+// bytes of the polynomials of a key switching key. the keys are not serialized
+// to measure them
+size_t key_bytes(const lbcrypto::EvalKey<lbcrypto::DCRTPoly>& key) {
+  size_t bytes = 0;
+  for (const auto* polys : {&key->GetAVector(), &key->GetBVector()}) {
+    for (const lbcrypto::DCRTPoly& poly : *polys) {
+      bytes += poly.GetNumOfElements() * poly.GetRingDimension() * 8;
+    }
+  }
+  return bytes;
+}
+
+// passes the content of a section as stream to `read`. the content is not
+// copied
+template <class F>
+void read_section(const aluminum_shark::SectionReader& reader,
+                  aluminum_shark::Section tag, F&& read) {
+  auto section = reader.get(tag);
+  aluminum_shark::MemoryStreamBuf buf(section.first, section.second);
+  std::istream in(&buf);
+  read(in);
+}
+
 }  // namespace
 
 namespace aluminum_shark {
@@ -32,6 +67,13 @@ CONTENT_TYPE type_to_content_type<double>() {
   return CONTENT_TYPE::DOUBLE;
 }
 
+uint32_t OpenFHEContext::levels() const {
+  return _internal_context->GetCryptoParameters()
+      ->GetElementParams()
+      ->GetParams()
+      .size();
+}
+
 bool OpenFHEContext::is_ckks() const { return _is_ckks; }
 
 bool OpenFHEContext::is_bfv() const { return _is_bfv; }
@@ -60,28 +102,375 @@ void OpenFHEContext::createPrivateKey() {
   _sec_key_ready = true;
   AS_LOG_INFO << "generating relineraztion key" << std::endl;
   _internal_context->EvalMultKeyGen(_sec_key);
+  size_t mult_bytes = 0;
+  for (const auto& key :
+       _internal_context->GetEvalMultKeyVector(_sec_key->GetKeyTag())) {
+    mult_bytes += key_bytes(key);
+  }
+  AS_LOG_INFO << "relinearization key: " << to_mb(mult_bytes) << " MB"
+              << std::endl;
+  if (!_gen_rotation_keys) {
+    return;
+  }
+  std::vector<int> steps = rotationKeySteps();
+  AS_LOG_INFO << "generating " << steps.size() << " rotation keys"
+              << std::endl;
+  _internal_context->EvalRotateKeyGen(_sec_key, steps);
+  size_t bytes = 0;
+  for (const auto& key :
+       _internal_context->GetEvalAutomorphismKeyMap(_sec_key->GetKeyTag())) {
+    bytes += key_bytes(key.second);
+  }
+  AS_LOG_INFO << "rotation keys: " << to_mb(bytes) << " MB" << std::endl;
+  size_t all_keys = power_of_two_steps(_slot_count).size();
+  if (!steps.empty() && steps.size() != all_keys) {
+    AS_LOG_INFO << "all power of two rotation keys: " << all_keys
+                << " keys, " << to_mb(bytes / steps.size() * all_keys) << " MB"
+                << std::endl;
+  }
 }
 
-// save public key to file
+std::vector<int> OpenFHEContext::rotationPlan(int steps) const {
+  const int slots = static_cast<int>(_slot_count);
+  _used_rotation_steps.record(((steps % slots) + slots) % slots);
+  std::vector<int> plan;
+  {
+    // plans are only added and replaced by loaded keys, lookups share the lock
+    std::shared_lock<std::shared_mutex> lock(_rotation_mutex);
+    auto it = _rotation_plans.find(steps);
+    if (it != _rotation_plans.end()) {
+      return it->second;
+    }
+    if (!compose_rotation(steps, slots, _rotation_steps, plan)) {
+      AS_LOG_CRITICAL << "no rotation keys for a rotation by " << steps
+                      << ". add it to `rotation_steps`" << std::endl;
+      throw std::runtime_error("missing rotation key for rotation by " +
+                               std::to_string(steps));
+    }
+  }
+  if (plan.size() > 1) {
+    AS_LOG_INFO << "rotation by " << steps << " is composed of "
+                << plan.size() << " rotations" << std::endl;
+  }
+  std::lock_guard<std::shared_mutex> lock(_rotation_mutex);
+  _rotation_plans.emplace(steps, plan);
+  return plan;
+}
 
+std::vector<int> OpenFHEContext::usedRotationSteps() const {
+  std::vector<int> result;
+  for (int step : _used_rotation_steps.steps()) {
+    if (step != 0) {
+      result.push_back(step);
+    }
+  }
+  return result;
+}
+
+void OpenFHEContext::logRotationSteps() const {
+  std::vector<int> steps = usedRotationSteps();
+  if (steps.empty()) {
+    return;
+  }
+  std::stringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < steps.size(); ++i) {
+    ss << (i == 0 ? "" : ", ") << steps[i];
+  }
+  ss << "]";
+  AS_LOG_INFO << "rotation steps used: " << ss.str() << std::endl;
+}
+
+std::vector<int> OpenFHEContext::rotationKeySteps() const {
+  // rotations by multiples of the slot count are no-ops
+  std::vector<int> steps;
+  for (int step : _rotation_steps) {
+    if (step % static_cast<int>(_slot_count) != 0) {
+      steps.push_back(step);
+    }
+  }
+  return steps;
+}
+
+void OpenFHEContext::saveParameters(SectionWriter& writer) const {
+  writer.add(Section::PARAMETERS, [this](std::ostream& out) {
+    lbcrypto::Serial::Serialize(_internal_context, out,
+                                lbcrypto::SerType::BINARY);
+  });
+  writer.add(Section::ROTATION_STEPS, _rotation_steps.data(),
+             _rotation_steps.size() * sizeof(int));
+}
+
+void OpenFHEContext::loadParameters(const SectionReader& reader) {
+  lbcrypto::CryptoContext<lbcrypto::DCRTPoly> context;
+  read_section(reader, Section::PARAMETERS, [&context](std::istream& in) {
+    lbcrypto::Serial::Deserialize(context, in, lbcrypto::SerType::BINARY);
+  });
+  // OpenFHE hands out the existing context if the parameters match. keys are
+  // bound to that object
+  if (context != _internal_context) {
+    AS_LOG_CRITICAL << "crypto context of the keys doesn't match the context"
+                    << std::endl;
+    throw std::runtime_error("crypto context doesn't match");
+  }
+  auto section = reader.get(Section::ROTATION_STEPS);
+  std::vector<int> steps(section.second / sizeof(int));
+  std::memcpy(steps.data(), section.first, steps.size() * sizeof(int));
+  std::lock_guard<std::shared_mutex> lock(_rotation_mutex);
+  _rotation_steps = std::move(steps);
+  _rotation_plans.clear();
+}
+
+// save public key to file. the file contains the crypto context, the public,
+// relinearization and rotation keys
 void OpenFHEContext::savePublicKey(const std::string& file) {
-  BACKEND_LOG << "saving keys not implemented yet" << std::endl;
+  if (!_pub_key_ready) {
+    AS_LOG_CRITICAL << "no public key to save" << std::endl;
+    throw std::runtime_error("no public key to save");
+  }
+  auto start = std::chrono::steady_clock::now();
+  SectionWriter writer(file, BACKEND_NAME);
+  saveParameters(writer);
+  writer.add(Section::PUBLIC_KEY, [this](std::ostream& out) {
+    lbcrypto::Serial::Serialize(_pub_key, out, lbcrypto::SerType::BINARY);
+  });
+  writer.add(Section::RELIN_KEYS, [this](std::ostream& out) {
+    lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::SerializeEvalMultKey(
+        out, lbcrypto::SerType::BINARY, _internal_context);
+  });
+  if (_gen_rotation_keys) {
+    writer.add(Section::GALOIS_KEYS, [this](std::ostream& out) {
+      lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::
+          SerializeEvalAutomorphismKey(out, lbcrypto::SerType::BINARY,
+                                       _internal_context);
+    });
+  }
+  writer.close();
+  AS_LOG_INFO << "saved public keys to " << file << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
 }
-// save private key ot file
 
+// save private key ot file. the file contains the crypto context and the
+// secret key. it is only readable by the owner
 void OpenFHEContext::savePrivateKey(const std::string& file) {
-  BACKEND_LOG << "saving keys not implemented yet" << std::endl;
+  if (!_sec_key_ready) {
+    AS_LOG_CRITICAL << "no private key to save" << std::endl;
+    throw std::runtime_error("no private key to save");
+  }
+  SectionWriter writer(file, BACKEND_NAME, true);
+  saveParameters(writer);
+  writer.add(Section::SECRET_KEY, [this](std::ostream& out) {
+    lbcrypto::Serial::Serialize(_sec_key, out, lbcrypto::SerType::BINARY);
+  });
+  writer.close();
+  AS_LOG_INFO << "saved secret key to " << file << std::endl;
 }
 
-// load public key from file
-
+// load public key from file. the keys are read directly from the mapped file
 void OpenFHEContext::loadPublicKey(const std::string& file) {
-  BACKEND_LOG << "loading keys not implemented yet" << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  SectionReader reader(file, BACKEND_NAME);
+  loadParameters(reader);
+  read_section(reader, Section::PUBLIC_KEY, [this](std::istream& in) {
+    lbcrypto::Serial::Deserialize(_pub_key, in, lbcrypto::SerType::BINARY);
+  });
+  read_section(reader, Section::RELIN_KEYS, [](std::istream& in) {
+    lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::DeserializeEvalMultKey(
+        in, lbcrypto::SerType::BINARY);
+  });
+  _gen_rotation_keys = reader.has(Section::GALOIS_KEYS);
+  if (_gen_rotation_keys) {
+    read_section(reader, Section::GALOIS_KEYS, [](std::istream& in) {
+      lbcrypto::CryptoContextImpl<lbcrypto::DCRTPoly>::
+          DeserializeEvalAutomorphismKey(in, lbcrypto::SerType::BINARY);
+    });
+  }
+  _pub_key_ready = true;
+  AS_LOG_INFO << "loaded public keys from " << file << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
 }
-// load private key from file
 
+// load private key from file
 void OpenFHEContext::loadPrivateKey(const std::string& file) {
-  BACKEND_LOG << "loading keys not implemented yet" << std::endl;
+  SectionReader reader(file, BACKEND_NAME);
+  loadParameters(reader);
+  read_section(reader, Section::SECRET_KEY, [this](std::istream& in) {
+    lbcrypto::Serial::Deserialize(_sec_key, in, lbcrypto::SerType::BINARY);
+  });
+  _sec_key_ready = true;
+  AS_LOG_INFO << "loaded secret key from " << file << std::endl;
+}
+
+void OpenFHEContext::saveCiphertexts(
+    const std::string& file, const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+    const std::vector<size_t>& shape) const {
+  auto start = std::chrono::steady_clock::now();
+  int content_type =
+      ctxts.empty() ? static_cast<int>(CONTENT_TYPE::invalid)
+                    : static_cast<int>(
+                          std::dynamic_pointer_cast<OpenFHECtxt>(ctxts[0])
+                              ->content_type());
+  CtxtFileWriter writer(file, BACKEND_NAME, content_type, 0, shape,
+                        ctxts.size());
+  for (const auto& ctxt : ctxts) {
+    const auto& internal =
+        std::dynamic_pointer_cast<OpenFHECtxt>(ctxt)->openFHECiphertext();
+    CtxtEntry entry{};
+    entry.level = internal->GetLevel();
+    entry.scale = internal->GetScalingFactor();
+    entry.size = internal->GetElements().size();
+    writer.add(entry, [&internal](std::ostream& out) {
+      lbcrypto::Serial::Serialize(internal, out, lbcrypto::SerType::BINARY);
+    });
+  }
+  writer.close();
+  AS_LOG_INFO << "saved " << ctxts.size() << " ciphertexts to " << file
+              << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
+}
+
+std::vector<std::shared_ptr<HECtxt>> OpenFHEContext::loadCiphertexts(
+    const std::string& file, std::vector<size_t>* shape) const {
+  auto start = std::chrono::steady_clock::now();
+  CtxtFileReader reader(file, BACKEND_NAME);
+  std::vector<std::shared_ptr<HECtxt>> result;
+  result.reserve(reader.count());
+  for (size_t i = 0; i < reader.count(); ++i) {
+    lbcrypto::Ciphertext<lbcrypto::DCRTPoly> internal;
+    MemoryStreamBuf buf(reader.data(i), reader.entry(i).bytes);
+    std::istream in(&buf);
+    lbcrypto::Serial::Deserialize(internal, in, lbcrypto::SerType::BINARY);
+    if (internal->GetCryptoContext() != _internal_context) {
+      throw std::runtime_error("ciphertext " + std::to_string(i) + " of " +
+                               file + " doesn't belong to the context");
+    }
+    result.push_back(std::make_shared<OpenFHECtxt>(
+        internal, file + "[" + std::to_string(i) + "]",
+        static_cast<CONTENT_TYPE>(reader.content_type()), *this));
+  }
+  if (shape != nullptr) {
+    *shape = reader.shape();
+  }
+  AS_LOG_INFO << "loaded " << result.size() << " ciphertexts from " << file
+              << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
+  return result;
+}
+
+void OpenFHEContext::saveCiphertext(const std::string& file,
+                                    const std::shared_ptr<HECtxt>& ctxt) const {
+  saveCiphertexts(file, {ctxt});
+}
+
+std::shared_ptr<HECtxt> OpenFHEContext::loadCiphertext(
+    const std::string& file) const {
+  auto ctxts = loadCiphertexts(file);
+  if (ctxts.size() != 1) {
+    throw std::runtime_error(file + " contains " +
+                             std::to_string(ctxts.size()) + " ciphertexts");
+  }
+  return ctxts[0];
+}
+
+std::shared_ptr<HECtxt> OpenFHEContext::linearCombination(
+    const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+    const std::vector<std::shared_ptr<HEPtxt>>& ptxts,
+    std::shared_ptr<HEPtxt> bias) const {
+  if (ctxts.empty() || ctxts.size() != ptxts.size()) {
+    throw std::invalid_argument(
+        "linearCombination needs the same number of ciphertexts and "
+        "plaintexts");
+  }
+  auto first = std::dynamic_pointer_cast<OpenFHECtxt>(ctxts[0]);
+  auto start = std::chrono::steady_clock::now();
+  // returns true and sets `value` if every slot of `ptxt` holds the same value
+  auto constant_value = [](const OpenFHEPtxt& ptxt, double& value) {
+    const auto& values = ptxt.double_values;
+    if (values.empty() ||
+        std::adjacent_find(values.begin(), values.end(),
+                           std::not_equal_to<double>()) != values.end()) {
+      return false;
+    }
+    value = values[0];
+    return true;
+  };
+
+  // terms with an all zero plaintext don't contribute. if all of them are
+  // zero the last term is kept so the result is a valid ciphertext
+  std::vector<lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>> inputs;
+  std::vector<std::shared_ptr<OpenFHEPtxt>> weights;
+  bool constant = is_ckks();
+  std::vector<double> constants;
+  for (size_t i = 0; i < ctxts.size(); ++i) {
+    auto ptxt = std::dynamic_pointer_cast<OpenFHEPtxt>(ptxts[i]);
+    if (ptxt->isAllZero() && !(i == ctxts.size() - 1 && inputs.empty())) {
+      continue;
+    }
+    inputs.push_back(
+        std::dynamic_pointer_cast<OpenFHECtxt>(ctxts[i])->relinearized());
+    weights.push_back(ptxt);
+    double value = 0;
+    if (constant && constant_value(*ptxt, value)) {
+      constants.push_back(value);
+    } else {
+      constant = false;
+    }
+  }
+
+  lbcrypto::Ciphertext<lbcrypto::DCRTPoly> sum;
+  try {
+    if (constant) {
+      sum = _internal_context->EvalLinearWSum(inputs, constants);
+    } else {
+      std::vector<lbcrypto::Ciphertext<lbcrypto::DCRTPoly>> products;
+      products.reserve(inputs.size());
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        products.push_back(_internal_context->EvalMult(
+            inputs[i], weights[i]->encodedToMatch(inputs[i], true)));
+      }
+      sum = products.size() == 1 ? products[0]
+                                 : _internal_context->EvalAddMany(products);
+    }
+    // counted like the separate operations, the same as SEALContext does
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      OpenFHECtxt::count_adjustments(inputs[i], true);
+      OpenFHECtxt::count_ctxt_ptxt_mult();
+      if (i != 0) {
+        OpenFHECtxt::count_ctxt_ctxt_add();
+      }
+    }
+    if (bias) {
+      auto bias_ptxt = std::dynamic_pointer_cast<OpenFHEPtxt>(bias);
+      if (!bias_ptxt->isAllZero()) {
+        _internal_context->EvalAddInPlace(
+            sum, bias_ptxt->encodedToMatch(sum, false));
+        OpenFHECtxt::count_ctxt_ptxt_add();
+      }
+    }
+  } catch (const std::exception& e) {
+    AS_LOG_CRITICAL << "linearCombination failed: " << e.what() << std::endl;
+    throw;
+  }
+  AS_LOG_INFO << "linear combination of " << inputs.size() << " terms"
+              << (constant ? " (constant weights)" : "") << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
+  return std::make_shared<OpenFHECtxt>(sum, first->name() + " linear comb",
+                                       first->content_type(), *this);
 }
 
 // Ciphertext related
@@ -136,6 +525,47 @@ std::vector<double> OpenFHEContext::decryptDouble(
   return decodeDouble(result);
 }
 
+// batch encryption. OpenFHE also parallelizes single operations with OpenMP,
+// with many workers OMP_NUM_THREADS=1 avoids oversubscribing the cores
+void OpenFHEContext::encryptBatch(const double* values,
+                                  const BatchLayout& layout,
+                                  std::shared_ptr<HECtxt>* out,
+                                  const std::string& name,
+                                  size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    std::vector<double> plain;
+    layout.gather(values, i, plain);
+    out[i] = encrypt(plain, name + "[" + std::to_string(i) + "]");
+  });
+}
+
+void OpenFHEContext::encryptBatch(const long* values, const BatchLayout& layout,
+                                  std::shared_ptr<HECtxt>* out,
+                                  const std::string& name,
+                                  size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    std::vector<long> plain;
+    layout.gather(values, i, plain);
+    out[i] = encrypt(plain, name + "[" + std::to_string(i) + "]");
+  });
+}
+
+void OpenFHEContext::decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                                  const BatchLayout& layout, double* values,
+                                  size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    layout.scatter(decryptDouble(ctxts[i]), i, values);
+  });
+}
+
+void OpenFHEContext::decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                                  const BatchLayout& layout, long* values,
+                                  size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    layout.scatter(decryptLong(ctxts[i]), i, values);
+  });
+}
+
 // Plaintext related
 
 // encoding
@@ -167,6 +597,7 @@ std::shared_ptr<HEPtxt> OpenFHEContext::encode_internal(
   std::shared_ptr<OpenFHEPtxt> ptxt_ptr = std::make_shared<OpenFHEPtxt>(
       _internal_context->MakePackedPlaintext(plain, noiseScaleDeg, level),
       CONTENT_TYPE::LONG, *this);
+  ptxt_ptr->long_values = plain;
   // check if all values are one or zero
   auto zero_one = all_zero_or_one(plain);
   ptxt_ptr->_allZero = zero_one.first;
@@ -181,6 +612,7 @@ std::shared_ptr<HEPtxt> OpenFHEContext::encode_internal(
   std::shared_ptr<OpenFHEPtxt> ptxt_ptr = std::make_shared<OpenFHEPtxt>(
       _internal_context->MakeCKKSPackedPlaintext(plain, noiseScaleDeg, level),
       CONTENT_TYPE::DOUBLE, *this);
+  ptxt_ptr->double_values = plain;
 
   // check if all values are one or zero
   auto zero_one = all_zero_or_one(plain);
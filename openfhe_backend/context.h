@@ -2,12 +2,19 @@
 #define ALUMINUM_SHARK_OPENFHE_BACKEND_CONTEXT_H
 
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "backend.h"
 #include "backend_logging.h"
 #include "he_backend/he_backend.h"
 #include "object_count.h"
+#include "parallel.h"
+#include "rotation_keys.h"
+#include "section_file.h"
 
 namespace aluminum_shark {
 
@@ -47,6 +54,7 @@ class OpenFHEContext : public HEContext {
       std::cout << "  total destroyed ctxt: " << get_ctxt_destructions()
                 << std::endl;
     }
+    logRotationSteps();
   };
 
   virtual const std::string& to_string() const override;
@@ -128,14 +136,23 @@ class OpenFHEContext : public HEContext {
 
   // OpenFHE specific API
   OpenFHEContext(lbcrypto::CryptoContext<lbcrypto::DCRTPoly> context,
-                 const OpenFHEBackend& backend)
-      : _internal_context(context), _backend(backend) {
+                 const OpenFHEBackend& backend, bool lazy_evaluation = false,
+                 bool rotation_keys = true,
+                 const std::vector<int>& rotation_steps = {})
+      : _internal_context(context),
+        _backend(backend),
+        _lazy_evaluation(lazy_evaluation),
+        _gen_rotation_keys(rotation_keys),
+        _rotation_steps(rotation_steps) {
     lbcrypto::SCHEME scheme = context->getSchemeId();
 
     _is_ckks = scheme == lbcrypto::SCHEME::CKKSRNS_SCHEME;
     _is_bfv = scheme == lbcrypto::SCHEME::BFVRNS_SCHEME;
 
     _slot_count = context->GetEncodingParams()->GetBatchSize();
+    if (_rotation_steps.empty()) {
+      _rotation_steps = power_of_two_steps(_slot_count);
+    }
 
     std::stringstream ss;
     ss << "OpenFHE ";
@@ -147,12 +164,72 @@ class OpenFHEContext : public HEContext {
       ss << "unknown scheme";
     }
     ss << "Ring dimension " << context->GetRingDimension();
+    if (_lazy_evaluation) {
+      ss << "; lazy evaluation";
+    }
     _string_representation = ss.str();
   };
 
+  // if true ciphertext products are not relinearized right away. this happens
+  // once the ciphertext is multiplied or rotated again.
+  bool lazy_evaluation() const { return _lazy_evaluation; };
+
+  // computes sum_i ctxts[i] * ptxts[i] + bias. if all plaintexts are constant
+  // the sum is computed with EvalLinearWSum, otherwise the products are summed
+  // with EvalAddMany. OpenFHE matches the levels and rescales the result once
+  // before it is multiplied again. `bias` is optional
+  std::shared_ptr<HECtxt> linearCombination(
+      const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+      const std::vector<std::shared_ptr<HEPtxt>>& ptxts,
+      std::shared_ptr<HEPtxt> bias = nullptr) const;
+
+  // encrypts the vectors of a batch stored in `values` at the positions given
+  // by `layout`. encoding and encryption are spread over `threads` workers (0
+  // selects ALUMINUM_SHARK_BATCH_THREADS). `out` needs room for `layout.count`
+  // ciphertexts. ciphertext i is named `name[i]`
+  void encryptBatch(const double* values, const BatchLayout& layout,
+                    std::shared_ptr<HECtxt>* out, const std::string& name = "",
+                    size_t threads = 0) const;
+  void encryptBatch(const long* values, const BatchLayout& layout,
+                    std::shared_ptr<HECtxt>* out, const std::string& name = "",
+                    size_t threads = 0) const;
+  // decrypts `layout.count` ciphertexts in parallel and writes their first
+  // `layout.slots` values to `values` at the positions given by `layout`
+  void decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                    const BatchLayout& layout, double* values,
+                    size_t threads = 0) const;
+  void decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                    const BatchLayout& layout, long* values,
+                    size_t threads = 0) const;
+
+  // ciphertext serialization. a batch of ciphertexts is stored together with
+  // its shape in a single file (see CtxtFileWriter) using OpenFHE's binary
+  // serialization
+  void saveCiphertexts(const std::string& file,
+                       const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+                       const std::vector<size_t>& shape = {}) const;
+  // `shape` is set to the stored shape if it is not null
+  std::vector<std::shared_ptr<HECtxt>> loadCiphertexts(
+      const std::string& file, std::vector<size_t>* shape = nullptr) const;
+  void saveCiphertext(const std::string& file,
+                      const std::shared_ptr<HECtxt>& ctxt) const;
+  std::shared_ptr<HECtxt> loadCiphertext(const std::string& file) const;
+
+  // steps of the rotation keys used to rotate by `steps`. the list is empty if
+  // no rotation is needed. a step without a key is composed from the
+  // available keys. throws if that is not possible. records `steps` as used
+  std::vector<int> rotationPlan(int steps) const;
+
+  // all rotation steps used so far. passing them as `rotation_steps` to a new
+  // context generates only the keys the computation needs
+  std::vector<int> usedRotationSteps() const;
+
   void encode(OpenFHEPtxt& ptxt, size_t noiseScaleDeg = 1,
               uint32_t level = 0) const;
 
+  // number of levels a ciphertext can be at
+  uint32_t levels() const;
+
   std::shared_ptr<HEPtxt> encode_internal(const std::vector<long>& plain,
                                           size_t noiseScaleDeg = 1,
                                           uint32_t level = 0) const;
@@ -172,34 +249,40 @@ class OpenFHEContext : public HEContext {
   bool _sec_key_ready = false;
   bool _is_ckks = false;
   bool _is_bfv = false;
+  bool _lazy_evaluation = false;
+  bool _gen_rotation_keys = true;
+  // steps to generate rotation keys for. defaults to all power of two steps
+  std::vector<int> _rotation_steps;
+  mutable std::shared_mutex _rotation_mutex;
+  mutable std::unordered_map<int, std::vector<int>> _rotation_plans;
+  mutable RotationStepLog _used_rotation_steps;
   size_t _slot_count;
   std::string _string_representation;
 
   bool is_ckks() const;
   bool is_bfv() const;
 
+  void logRotationSteps() const;
+
+  // `_rotation_steps` without the steps that don't need a key
+  std::vector<int> rotationKeySteps() const;
+
+  // crypto context and rotation steps stored with the keys. loading checks
+  // that the crypto context matches
+  void saveParameters(SectionWriter& writer) const;
+  void loadParameters(const SectionReader& reader);
+
   // checks if all values in a vector are 0 or 1. return std::pair<all_zero,
-  // all_one>
+  // all_one>. both are false for an empty vector
   template <class T>
   std::pair<bool, bool> all_zero_or_one(const std::vector<T>& in) const {
-    bool all_one = true;
-    bool all_zero = true;
-    if (in.size() == 1) {
-      all_zero = in[0] == 0;
-      all_one = in[0] == 1;
-
-    } else {
-      for (auto i : in) {
-        if (i != 0) {
-          all_zero = false;
-          break;
-        }
-      }
-      for (auto i : in) {
-        if (i != 1) {
-          all_one = true;
-          break;
-        }
+    bool all_zero = !in.empty();
+    bool all_one = !in.empty();
+    for (auto i : in) {
+      all_zero = all_zero && i == 0;
+      all_one = all_one && i == 1;
+      if (!all_zero && !all_one) {
+        break;
       }
     }
     return std::pair<bool, bool>(all_zero, all_one);
@@ -6,7 +6,13 @@
 // #include <streambuf>
 #include <sstream>
 
+#include "backend_logging.h"
+#include "inplace_ops.h"
+#include "level_cache.h"
 #include "logging.h"
+#include "op_capture.h"
+#include "op_trace.h"
+#include "utils/macros.h"
 #include "utils/utils.h"
 
 std::mutex global_op_mutex;
@@ -22,9 +28,11 @@ std::string OpenFHECtxt::to_string() const {
 const HEContext* OpenFHECtxt::getContext() const { return &_context; }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::deepCopy() {
+  OpCapture captured = capture(CAPTURE_OP::COPY, false);
   OpenFHECtxt* raw = new OpenFHECtxt(*this);
   std::shared_ptr<OpenFHECtxt> result(raw);
   result->setOpenFHECiphertext(_internal_ctxt->Clone());
+  captured.result(result.get());
   return result;
 }
 
@@ -33,52 +41,53 @@ std::shared_ptr<HECtxt> OpenFHECtxt::deepCopy() {
 // ctxt and ctxt
 std::shared_ptr<HECtxt> OpenFHECtxt::operator+(
     const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<OpenFHECtxt> other_ctxt =
-      std::dynamic_pointer_cast<OpenFHECtxt>(other);
-  AS_LOG_DEBUG << "adding ciphertext" << std::endl;
+  const std::shared_ptr<const OpenFHECtxt> other_ctxt =
+      std::dynamic_pointer_cast<const OpenFHECtxt>(other);
+  TraceSpan span = trace("add", other_ctxt->openFHECiphertext());
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, *other_ctxt);
+  BACKEND_LOG_DEBUG << "adding ciphertext" << std::endl;
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
-      other_ctxt->openFHECiphertext()->Clone(),
       _name + " + " + other_ctxt->name(), _content_type, _context);
   try {
-    auto ctxt = _context._internal_context->EvalAdd(
-        _internal_ctxt, result->openFHECiphertext());
-    AS_LOG_DEBUG << "addition complete" << std::endl;
+    // ciphertexts of different sizes can be added. so nothing pending needs
+    // to be applied
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly> rhs =
+        lowered(*other_ctxt, _internal_ctxt);
+    count_adjustments(_internal_ctxt, rhs, false);
+    auto ctxt = _internal_ctxt->Clone();
+    add_in_place(_context._internal_context, ctxt, rhs);
+    result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ctxt_add();
+    BACKEND_LOG_DEBUG << "addition complete" << std::endl;
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::addInPlace(const std::shared_ptr<HECtxt> other) {
   // std::lock_guard<std::mutex> guard(global_op_mutex);
-  AS_LOG_DEBUG << "adding in place ciphertext" << std::endl;
-  const std::shared_ptr<OpenFHECtxt> other_ctxt =
-      std::dynamic_pointer_cast<OpenFHECtxt>(other);
+  BACKEND_LOG_DEBUG << "adding in place ciphertext" << std::endl;
+  const std::shared_ptr<const OpenFHECtxt> other_ctxt =
+      std::dynamic_pointer_cast<const OpenFHECtxt>(other);
+  TraceSpan span = trace("add_inplace", other_ctxt->openFHECiphertext());
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, *other_ctxt);
+  _levels.invalidate();
   try {
-    // cecking if we need to do some modswitching
-    auto temp = other_ctxt->openFHECiphertext();
-    int level_diff = _internal_ctxt->GetLevel() - temp->GetLevel();
-    AS_LOG_DEBUG << "lhs level = " << _internal_ctxt->GetLevel()
-                 << " rhs level " << temp->GetLevel() << std::endl;
-    if (level_diff != 0) {
-      temp = temp->Clone();
-    }
-    if (level_diff > 0) {
-      _context._internal_context->LevelReduceInPlace(_internal_ctxt, nullptr,
-                                                     level_diff);
-      AS_LOG_DEBUG << "Mod switched lhs by " << level_diff
-                   << ". lhs level = " << _internal_ctxt->GetLevel()
-                   << " rhs level " << temp->GetLevel() << std::endl;
-    } else if (level_diff < 0) {
-      _context._internal_context->LevelReduceInPlace(temp, nullptr,
-                                                     std::abs(level_diff));
-      AS_LOG_DEBUG << "Mod switched rhs by " << level_diff
-                   << ". lhs level = " << _internal_ctxt->GetLevel()
-                   << " rhs level " << temp->GetLevel() << std::endl;
-    }
-    _context._internal_context->EvalAddInPlace(_internal_ctxt, temp);
-    AS_LOG_DEBUG << "addition in place complete" << std::endl;
+    BACKEND_LOG_DEBUG << "lhs level = " << _internal_ctxt->GetLevel()
+                      << " rhs level "
+                      << other_ctxt->openFHECiphertext()->GetLevel()
+                      << std::endl;
+    // a higher level `other` is reduced once and its lower level version is
+    // reused. nothing is copied unless the levels or scales differ
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly> rhs =
+        lowered(*other_ctxt, _internal_ctxt);
+    count_adjustments(_internal_ctxt, rhs, false);
+    add_in_place(_context._internal_context, _internal_ctxt, rhs);
+    count_ctxt_ctxt_add();
+    BACKEND_LOG_DEBUG << "addition in place complete" << std::endl;
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -87,28 +96,41 @@ void OpenFHECtxt::addInPlace(const std::shared_ptr<HECtxt> other) {
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator-(
     const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<OpenFHECtxt> other_ctxt =
-      std::dynamic_pointer_cast<OpenFHECtxt>(other);
+  const std::shared_ptr<const OpenFHECtxt> other_ctxt =
+      std::dynamic_pointer_cast<const OpenFHECtxt>(other);
+  TraceSpan span = trace("sub", other_ctxt->openFHECiphertext());
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, *other_ctxt);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " * " + other_ctxt->name(), _content_type, _context);
-  result->setOpenFHECiphertext(other_ctxt->openFHECiphertext()->Clone());
   try {
-    auto ctxt = _context._internal_context->EvalSub(
-        _internal_ctxt, result->openFHECiphertext());
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly> rhs =
+        lowered(*other_ctxt, _internal_ctxt);
+    count_adjustments(_internal_ctxt, rhs, false);
+    auto ctxt = _internal_ctxt->Clone();
+    sub_in_place(_context._internal_context, ctxt, rhs);
+    result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ctxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
 
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::subInPlace(const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<OpenFHECtxt> other_ctxt =
-      std::dynamic_pointer_cast<OpenFHECtxt>(other);
+  const std::shared_ptr<const OpenFHECtxt> other_ctxt =
+      std::dynamic_pointer_cast<const OpenFHECtxt>(other);
+  TraceSpan span = trace("sub_inplace", other_ctxt->openFHECiphertext());
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, *other_ctxt);
+  _levels.invalidate();
   try {
-    auto temp = other_ctxt->openFHECiphertext()->Clone();
-    _context._internal_context->EvalSubInPlace(_internal_ctxt, temp);
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly> rhs =
+        lowered(*other_ctxt, _internal_ctxt);
+    count_adjustments(_internal_ctxt, rhs, false);
+    sub_in_place(_context._internal_context, _internal_ctxt, rhs);
+    count_ctxt_ctxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -117,62 +139,79 @@ void OpenFHECtxt::subInPlace(const std::shared_ptr<HECtxt> other) {
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator*(
     const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<OpenFHECtxt> other_ctxt =
-      std::dynamic_pointer_cast<OpenFHECtxt>(other);
-  AS_LOG_DEBUG << "multiplying ciphertext" << std::endl;
+  const std::shared_ptr<const OpenFHECtxt> other_ctxt =
+      std::dynamic_pointer_cast<const OpenFHECtxt>(other);
+  TraceSpan span = trace("mult", other_ctxt->openFHECiphertext());
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, *other_ctxt);
+  BACKEND_LOG_DEBUG << "multiplying ciphertext" << std::endl;
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
-      other_ctxt->openFHECiphertext()->Clone(),
       _name + " * " + other_ctxt->name(), _content_type, _context);
   try {
-    auto ctxt = _context._internal_context->EvalSub(
-        _internal_ctxt, result->openFHECiphertext());
+    count_adjustments(_internal_ctxt, other_ctxt->openFHECiphertext(), true);
+    result->setOpenFHECiphertext(
+        mult(relinearized(), other_ctxt->relinearized()));
+    count_ctxt_ctxt_mult();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
-  AS_LOG_DEBUG << "multiplying ciphertext done" << std::endl;
+  BACKEND_LOG_DEBUG << "multiplying ciphertext done" << std::endl;
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::multInPlace(const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<OpenFHECtxt> other_ctxt =
-      std::dynamic_pointer_cast<OpenFHECtxt>(other);
-  AS_LOG_DEBUG << "multiplying ciphertext in place" << std::endl;
+  const std::shared_ptr<const OpenFHECtxt> other_ctxt =
+      std::dynamic_pointer_cast<const OpenFHECtxt>(other);
+  TraceSpan span = trace("mult_inplace", other_ctxt->openFHECiphertext());
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, *other_ctxt);
+  _levels.invalidate();
+  BACKEND_LOG_DEBUG << "multiplying ciphertext in place" << std::endl;
   try {
-    _internal_ctxt = _context._internal_context->EvalMult(
-        _internal_ctxt, other_ctxt->openFHECiphertext());
+    flush();
+    count_adjustments(_internal_ctxt, other_ctxt->openFHECiphertext(), true);
+    _internal_ctxt = mult(_internal_ctxt, other_ctxt->relinearized());
+    count_ctxt_ctxt_mult();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
-  AS_LOG_DEBUG << "multiplying ciphertext in place done" << std::endl;
+  BACKEND_LOG_DEBUG << "multiplying ciphertext in place done" << std::endl;
 }
 
 // ctxt and plain
 
 // addition
 std::shared_ptr<HECtxt> OpenFHECtxt::operator+(std::shared_ptr<HEPtxt> other) {
+  TraceSpan span = trace("add_plain");
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, other);
   const std::shared_ptr<OpenFHEPtxt> ptxt =
       std::dynamic_pointer_cast<OpenFHEPtxt>(other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " + plaintext", _content_type, _context);
   try {
-    auto ctxt = _context._internal_context->EvalAdd(_internal_ctxt,
-                                                    ptxt->openFHEPlaintext());
+    auto ctxt = _context._internal_context->EvalAdd(
+        _internal_ctxt, ptxt->encodedToMatch(_internal_ctxt, false));
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::addInPlace(std::shared_ptr<HEPtxt> other) {
+  TraceSpan span = trace("add_plain_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, other);
+  _levels.invalidate();
   const std::shared_ptr<OpenFHEPtxt> ptxt =
       std::dynamic_pointer_cast<OpenFHEPtxt>(other);
   try {
     _internal_ctxt = _context._internal_context->EvalAdd(
-        _internal_ctxt, ptxt->openFHEPlaintext());
+        _internal_ctxt, ptxt->encodedToMatch(_internal_ctxt, false));
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -180,21 +219,29 @@ void OpenFHECtxt::addInPlace(std::shared_ptr<HEPtxt> other) {
 }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator+(long other) {
+  TraceSpan span = trace("add_scalar");
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " + " + std::to_string(other), _content_type, _context);
   try {
     auto ctxt = _context._internal_context->EvalAdd(_internal_ctxt, other);
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::addInPlace(long other) {
+  TraceSpan span = trace("add_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, other);
+  _levels.invalidate();
   try {
     _context._internal_context->EvalAddInPlace(_internal_ctxt, other);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -202,21 +249,29 @@ void OpenFHECtxt::addInPlace(long other) {
 }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator+(double other) {
+  TraceSpan span = trace("add_scalar");
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " + " + std::to_string(other), _content_type, _context);
   try {
     auto ctxt = _context._internal_context->EvalAdd(_internal_ctxt, other);
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::addInPlace(double other) {
+  TraceSpan span = trace("add_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, other);
+  _levels.invalidate();
   try {
     _context._internal_context->EvalAddInPlace(_internal_ctxt, other);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -225,27 +280,35 @@ void OpenFHECtxt::addInPlace(double other) {
 
 // subtraction
 std::shared_ptr<HECtxt> OpenFHECtxt::operator-(std::shared_ptr<HEPtxt> other) {
+  TraceSpan span = trace("sub_plain");
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, other);
   const std::shared_ptr<OpenFHEPtxt> ptxt =
       std::dynamic_pointer_cast<OpenFHEPtxt>(other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " + plaintext", _content_type, _context);
   try {
-    auto ctxt = _context._internal_context->EvalSub(_internal_ctxt,
-                                                    ptxt->openFHEPlaintext());
+    auto ctxt = _context._internal_context->EvalSub(
+        _internal_ctxt, ptxt->encodedToMatch(_internal_ctxt, false));
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::subInPlace(std::shared_ptr<HEPtxt> other) {
+  TraceSpan span = trace("sub_plain_inplace");
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, other);
+  _levels.invalidate();
   const std::shared_ptr<OpenFHEPtxt> ptxt =
       std::dynamic_pointer_cast<OpenFHEPtxt>(other);
   try {
     _internal_ctxt = _context._internal_context->EvalSub(
-        _internal_ctxt, ptxt->openFHEPlaintext());
+        _internal_ctxt, ptxt->encodedToMatch(_internal_ctxt, false));
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -253,21 +316,29 @@ void OpenFHECtxt::subInPlace(std::shared_ptr<HEPtxt> other) {
 }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator-(long other) {
+  TraceSpan span = trace("sub_scalar");
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " + " + std::to_string(other), _content_type, _context);
   try {
     auto ctxt = _context._internal_context->EvalSub(_internal_ctxt, other);
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::subInPlace(long other) {
+  TraceSpan span = trace("sub_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, other);
+  _levels.invalidate();
   try {
     _context._internal_context->EvalSubInPlace(_internal_ctxt, other);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -275,21 +346,29 @@ void OpenFHECtxt::subInPlace(long other) {
 }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator-(double other) {
+  TraceSpan span = trace("sub_scalar");
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " + " + std::to_string(other), _content_type, _context);
   try {
     auto ctxt = _context._internal_context->EvalSub(_internal_ctxt, other);
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
   }
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::subInPlace(double other) {
+  TraceSpan span = trace("sub_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, other);
+  _levels.invalidate();
   try {
     _context._internal_context->EvalSubInPlace(_internal_ctxt, other);
+    count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -298,8 +377,10 @@ void OpenFHECtxt::subInPlace(double other) {
 
 // multiplication
 std::shared_ptr<HECtxt> OpenFHECtxt::operator*(std::shared_ptr<HEPtxt> other) {
+  TraceSpan span = trace("mult_plain");
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, other);
   // std::lock_guard<std::mutex> guard(global_op_mutex);
-  AS_LOG_INFO << "Ctxt plaintext multiplication" << std::endl;
+  BACKEND_LOG_DEBUG << "Ctxt plaintext multiplication" << std::endl;
   const std::shared_ptr<OpenFHEPtxt> ptxt =
       std::dynamic_pointer_cast<OpenFHEPtxt>(other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
@@ -309,26 +390,33 @@ std::shared_ptr<HECtxt> OpenFHECtxt::operator*(std::shared_ptr<HEPtxt> other) {
     // TODO
   }
   if (ptxt->isAllOne()) {
-    AS_LOG_INFO << "ptxt is all one returning" << std::endl;
+    BACKEND_LOG_DEBUG << "ptxt is all one returning" << std::endl;
     result->setOpenFHECiphertext(_internal_ctxt->Clone());
+    captured.result(result.get());
     return result;
   }
 
   try {
-    AS_LOG_INFO << "Starting multiplication" << std::endl;
-    auto ctxt = _context._internal_context->EvalMult(_internal_ctxt,
-                                                     ptxt->openFHEPlaintext());
-    AS_LOG_INFO << "Done" << std::endl;
+    BACKEND_LOG_DEBUG << "Starting multiplication" << std::endl;
+    count_adjustments(_internal_ctxt, true);
+    auto ctxt = _context._internal_context->EvalMult(
+        _internal_ctxt, ptxt->encodedToMatch(_internal_ctxt, true));
+    BACKEND_LOG_DEBUG << "Done" << std::endl;
     result->setOpenFHECiphertext(ctxt);
+    count_ctxt_ptxt_mult();
   } catch (const std::exception& e) {
     AS_LOG_CRITICAL << e.what() << std::endl;
     throw;
   }
 
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::multInPlace(std::shared_ptr<HEPtxt> other) {
+  TraceSpan span = trace("mult_plain_inplace");
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, other);
+  _levels.invalidate();
   const std::shared_ptr<OpenFHEPtxt> ptxt =
       std::dynamic_pointer_cast<OpenFHEPtxt>(other);
   if (ptxt->isAllZero()) {
@@ -338,8 +426,10 @@ void OpenFHECtxt::multInPlace(std::shared_ptr<HEPtxt> other) {
     return;
   }
   try {
+    count_adjustments(_internal_ctxt, true);
     _internal_ctxt = _context._internal_context->EvalMult(
-        _internal_ctxt, ptxt->openFHEPlaintext());
+        _internal_ctxt, ptxt->encodedToMatch(_internal_ctxt, true));
+    count_ctxt_ptxt_mult();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
     throw;
@@ -347,41 +437,121 @@ void OpenFHECtxt::multInPlace(std::shared_ptr<HEPtxt> other) {
 }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator*(long other) {
+  TraceSpan span = trace("mult_scalar");
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " * " + std::to_string(other), _content_type, _context);
 
+  count_adjustments(_internal_ctxt, true);
   auto ctxt = _context._internal_context->EvalMult(_internal_ctxt, other);
   result->setOpenFHECiphertext(ctxt);
+  count_ctxt_ptxt_mult();
+  captured.result(result.get());
   return result;
 }
 
 void OpenFHECtxt::multInPlace(long other) {
+  TraceSpan span = trace("mult_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, other);
+  _levels.invalidate();
+  count_adjustments(_internal_ctxt, true);
   _context._internal_context->EvalMultInPlace(_internal_ctxt, other);
+  count_ctxt_ptxt_mult();
 }
 
 std::shared_ptr<HECtxt> OpenFHECtxt::operator*(double other) {
+  TraceSpan span = trace("mult_scalar");
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, other);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " * " + std::to_string(other), _content_type, _context);
+  count_adjustments(_internal_ctxt, true);
   auto ctxt = _context._internal_context->EvalMult(_internal_ctxt, other);
   result->setOpenFHECiphertext(ctxt);
+  count_ctxt_ptxt_mult();
+  captured.result(result.get());
   return result;
 }
 void OpenFHECtxt::multInPlace(double other) {
+  TraceSpan span = trace("mult_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, other);
+  _levels.invalidate();
+  count_adjustments(_internal_ctxt, true);
   _context._internal_context->EvalMultInPlace(_internal_ctxt, other);
+  count_ctxt_ptxt_mult();
 }
 
 // Rotation
 std::shared_ptr<HECtxt> OpenFHECtxt::rotate(int steps) {
+  TraceSpan span = trace("rotate");
+  OpCapture captured = capture(CAPTURE_OP::ROTATE, false);
+  captured.steps(steps);
   std::shared_ptr<OpenFHECtxt> result = std::make_shared<OpenFHECtxt>(
       _name + " rotated " + std::to_string(steps), _content_type, _context);
-  auto rotated = _context._internal_context->EvalRotate(_internal_ctxt, steps);
+  std::vector<int> plan = _context.rotationPlan(steps);
+  auto rotated = relinearized();
+  if (plan.empty()) {
+    rotated = rotated->Clone();
+  }
+  for (int step : plan) {
+    rotated = _context._internal_context->EvalRotate(rotated, step);
+  }
   result->setOpenFHECiphertext(rotated);
+  count_ctxt_rot();
+  captured.result(result.get());
+  return result;
+}
+
+std::vector<std::shared_ptr<HECtxt>> OpenFHECtxt::rotateMany(
+    const std::vector<int>& steps) {
+  TraceSpan span = trace("rotate_many");
+  std::vector<std::shared_ptr<HECtxt>> result;
+  result.reserve(steps.size());
+  auto ctxt = relinearized();
+  const auto& cc = _context._internal_context;
+  const uint32_t m = cc->GetCryptoParameters()
+                         ->GetElementParams()
+                         ->GetCyclotomicOrder();
+  auto precomputed = cc->EvalFastRotationPrecompute(ctxt);
+  for (int step : steps) {
+    OpCapture captured = capture(CAPTURE_OP::ROTATE, false);
+    captured.steps(step);
+    std::shared_ptr<OpenFHECtxt> rotated = std::make_shared<OpenFHECtxt>(
+        _name + " rotated " + std::to_string(step), _content_type, _context);
+    try {
+      std::vector<int> plan = _context.rotationPlan(step);
+      if (plan.size() == 1) {
+        rotated->setOpenFHECiphertext(
+            cc->EvalFastRotation(ctxt, plan[0], m, precomputed));
+      } else {
+        // no rotation or the step needs to be composed from multiple keys
+        auto composed = plan.empty() ? ctxt->Clone() : ctxt;
+        for (int p : plan) {
+          composed = cc->EvalRotate(composed, p);
+        }
+        rotated->setOpenFHECiphertext(composed);
+      }
+    } catch (const std::exception& e) {
+      AS_LOG_CRITICAL << e.what() << std::endl;
+      throw;
+    }
+    count_ctxt_rot();
+    captured.result(rotated.get());
+    result.push_back(rotated);
+  }
   return result;
 }
 
 void OpenFHECtxt::rotInPlace(int steps) {
-  _internal_ctxt =
-      _context._internal_context->EvalRotate(_internal_ctxt, steps);
+  TraceSpan span = trace("rotate_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ROTATE, true);
+  _levels.invalidate();
+  captured.steps(steps);
+  flush();
+  for (int step : _context.rotationPlan(steps)) {
+    _internal_ctxt =
+        _context._internal_context->EvalRotate(_internal_ctxt, step);
+  }
+  count_ctxt_rot();
 }
 
 // OpenFHE specific API
@@ -400,10 +570,13 @@ OpenFHECtxt::OpenFHECtxt(lbcrypto::Ciphertext<lbcrypto::DCRTPoly> ctxt,
 
 void OpenFHECtxt::setOpenFHECiphertext(
     const lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& ctxt) {
+  _levels.invalidate();
   _internal_ctxt = ctxt;
 }
 
+// the caller may modify the ciphertext
 lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& OpenFHECtxt::openFHECiphertext() {
+  _levels.invalidate();
   return _internal_ctxt;
 }
 
@@ -420,4 +593,193 @@ size_t OpenFHECtxt::size() {  // TODO
   return 0;
 }
 
+// lazy evaluation
+
+void OpenFHECtxt::flush() {
+  if (needs_relinearization()) {
+    _levels.invalidate();
+    _context._internal_context->RelinearizeInPlace(_internal_ctxt);
+  }
+}
+
+bool OpenFHECtxt::needs_relinearization() const {
+  return _internal_ctxt->GetElements().size() > 2;
+}
+
+TraceSpan OpenFHECtxt::trace(
+    const char* op,
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& rhs) const {
+  if (!tracing_enabled()) {
+    return TraceSpan(op);
+  }
+  auto level = [](const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& ctxt) {
+    return ctxt ? static_cast<int>(ctxt->GetLevel()) : -1;
+  };
+  return TraceSpan(op, level(_internal_ctxt), level(rhs));
+}
+
+OpCapture OpenFHECtxt::capture(CAPTURE_OP op, bool inplace) const {
+  OpCapture captured(op, inplace);
+  if (captured.active()) {
+    captured.lhs(this, _internal_ctxt->GetLevel(),
+                 _internal_ctxt->GetScalingFactor());
+  }
+  return captured;
+}
+
+OpCapture OpenFHECtxt::capture(CAPTURE_OP op, bool inplace,
+                               const OpenFHECtxt& rhs) const {
+  OpCapture captured = capture(op, inplace);
+  if (captured.active()) {
+    captured.rhs(&rhs, rhs._internal_ctxt->GetLevel(),
+                 rhs._internal_ctxt->GetScalingFactor());
+  }
+  return captured;
+}
+
+OpCapture OpenFHECtxt::capture(CAPTURE_OP op, bool inplace,
+                               const std::shared_ptr<HEPtxt>& rhs) const {
+  OpCapture captured = capture(op, inplace);
+  if (captured.active()) {
+    const OpenFHEPtxt& ptxt = dynamic_cast<const OpenFHEPtxt&>(*rhs);
+    captured.plain(ptxt.n_values(), ptxt.values_hash(),
+                   ptxt.content_type() == CONTENT_TYPE::DOUBLE,
+                   ptxt.isAllZero(), ptxt.isAllOne());
+  }
+  return captured;
+}
+
+template <class T>
+OpCapture OpenFHECtxt::capture(CAPTURE_OP op, bool inplace, T rhs) const {
+  OpCapture captured = capture(op, inplace);
+  captured.scalar(rhs);
+  return captured;
+}
+
+lbcrypto::Ciphertext<lbcrypto::DCRTPoly> OpenFHECtxt::relinearized() const {
+  if (!needs_relinearization()) {
+    return _internal_ctxt;
+  }
+  return _context._internal_context->Relinearize(_internal_ctxt);
+}
+
+lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly> OpenFHECtxt::lowered(
+    const OpenFHECtxt& other,
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& target) const {
+  const lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& src = other._internal_ctxt;
+  const std::vector<lbcrypto::DCRTPoly>& elements = target->GetElements();
+  if (src->GetLevel() >= target->GetLevel() ||
+      src->GetElements().size() > elements.size()) {
+    return src;
+  }
+  const size_t bytes = src->GetElements().size() *
+                       elements[0].GetNumOfElements() *
+                       elements[0].GetRingDimension() * sizeof(uint64_t);
+  return other._levels.get(
+      target->GetLevel(), target->GetScalingFactor(), bytes,
+      [&] {
+        // LevelReduce keeps the scale of the level of `src`. adding it to an
+        // encryption of zero at the level of `target` lets OpenFHE adjust
+        // the scale and the noise scale degree as well
+        count_adjustments(target, src, false);
+        auto version = _context._internal_context->EvalSub(target, target);
+        version->GetElements().resize(src->GetElements().size());
+        _context._internal_context->EvalAddInPlace(version, src);
+        return lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>(version);
+      },
+      target->GetNoiseScaleDeg());
+}
+
+lbcrypto::Ciphertext<lbcrypto::DCRTPoly> OpenFHECtxt::mult(
+    const lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& lhs,
+    const lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& rhs) const {
+  if (_context.lazy_evaluation()) {
+    return _context._internal_context->EvalMultNoRelin(lhs, rhs);
+  }
+  return _context._internal_context->EvalMult(lhs, rhs);
+}
+
+// static ressource looging code
+bool OpenFHECtxt::count_ops = false;
+
+// ctxt x ctx
+std::atomic_ulong OpenFHECtxt::mult_ctxt_count = 0;
+// ctxt x ptx
+std::atomic_ulong OpenFHECtxt::mult_ptxt_count = 0;
+
+// ctxt x ctx
+std::atomic_ulong OpenFHECtxt::add_ctxt_count = 0;
+// ctxt x ptx
+std::atomic_ulong OpenFHECtxt::add_ptxt_count = 0;
+
+std::atomic_ulong OpenFHECtxt::rot_count = 0;
+
+std::atomic_ulong OpenFHECtxt::level_reduce_count = 0;
+std::atomic_ulong OpenFHECtxt::rescale_count = 0;
+
+// resource logging
+void OpenFHECtxt::count_ctxt_ctxt_mult() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++mult_ctxt_count;
+  }
+}
+
+void OpenFHECtxt::count_ctxt_ptxt_mult() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++mult_ptxt_count;
+  }
+}
+
+void OpenFHECtxt::count_ctxt_ctxt_add() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++add_ctxt_count;
+  }
+}
+
+void OpenFHECtxt::count_ctxt_ptxt_add() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++add_ptxt_count;
+  }
+}
+
+void OpenFHECtxt::count_ctxt_rot() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++rot_count;
+  }
+}
+
+// with FLEXIBLEAUTO a product is rescaled right before it is used in the next
+// multiplication. operands at different levels are brought to the lower level
+// and a difference in the noise scale degree is evened out by a rescale
+void OpenFHECtxt::count_adjustments(
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& lhs,
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& rhs, bool mult) {
+  if (LIKELY_FALSE(count_ops)) {
+    uint32_t lhs_level = lhs->GetLevel();
+    uint32_t rhs_level = rhs->GetLevel();
+    if (mult) {
+      if (lhs->GetNoiseScaleDeg() > 1) {
+        ++rescale_count;
+        ++lhs_level;
+      }
+      if (rhs->GetNoiseScaleDeg() > 1) {
+        ++rescale_count;
+        ++rhs_level;
+      }
+    } else if (lhs->GetNoiseScaleDeg() != rhs->GetNoiseScaleDeg()) {
+      ++rescale_count;
+    }
+    if (lhs_level != rhs_level) {
+      ++level_reduce_count;
+    }
+  }
+}
+
+void OpenFHECtxt::count_adjustments(
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& ctxt, bool mult) {
+  if (LIKELY_FALSE(count_ops) && mult && ctxt->GetNoiseScaleDeg() > 1) {
+    ++rescale_count;
+  }
+}
+
 }  // namespace aluminum_shark
\ No newline at end of file
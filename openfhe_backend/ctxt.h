@@ -1,8 +1,13 @@
 #ifndef ALUMINUM_SHARK_OPENFHE_BACKEND_CTXT_H
 #define ALUMINUM_SHARK_OPENFHE_BACKEND_CTXT_H
 
+#include <atomic>
+
 #include "context.h"
 #include "he_backend/he_backend.h"
+#include "level_cache.h"
+#include "op_capture.h"
+#include "op_trace.h"
 #include "openfhe.h"
 #include "ptxt.h"
 
@@ -12,7 +17,7 @@ namespace aluminum_shark {
 class OpenFHECtxt : public HECtxt {
  public:
   // Plugin API
-  virtual ~OpenFHECtxt(){};
+  virtual ~OpenFHECtxt() { capture_release(this); };
 
   virtual std::string to_string() const override;
 
@@ -70,6 +75,11 @@ class OpenFHECtxt : public HECtxt {
 
   virtual void rotInPlace(int steps);
 
+  // rotates this ciphertext by each of `steps`. the key switching
+  // precomputation is shared by all rotations
+  std::vector<std::shared_ptr<HECtxt>> rotateMany(
+      const std::vector<int>& steps);
+
   virtual size_t size() override;
 
   // OpenFHE specific API
@@ -90,13 +100,89 @@ class OpenFHECtxt : public HECtxt {
 
   const std::string& name() const;
 
+  // lazy evaluation. products of ciphertexts are not relinearized right away
+  // if the context was created with lazy evaluation enabled. OpenFHE takes
+  // care of the rescaling. `flush` performs a pending relinearization.
+  void flush();
+  bool needs_relinearization() const;
+
+  // ressource logging api
+  static void count_ctxt_ctxt_mult();
+  static void count_ctxt_ptxt_mult();
+  static void count_ctxt_ctxt_add();
+  static void count_ctxt_ptxt_add();
+  static void count_ctxt_rot();
+
  private:
   // OpenFHE specific API
   friend OpenFHEContext;
+  friend OpenFHEMonitor;
+  friend OpenFHEBackend;
   std::string _name;
   CONTENT_TYPE _content_type;
   const OpenFHEContext& _context;
   lbcrypto::Ciphertext<lbcrypto::DCRTPoly> _internal_ctxt;
+  // lower level versions of `_internal_ctxt` (see `lowered`). invalidated by
+  // every operation that modifies or replaces it
+  mutable LevelCache<lbcrypto::CiphertextImpl<lbcrypto::DCRTPoly>> _levels;
+
+  // the ciphertext of `other` adjusted to the level, scale and noise scale
+  // degree of `target` if it is at a higher level. the version is cached by
+  // `other` until it is modified. otherwise the ciphertext of `other` is
+  // returned
+  lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly> lowered(
+      const OpenFHECtxt& other,
+      const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& target) const;
+  // returns the internal ciphertext or a relinearized copy of it
+  lbcrypto::Ciphertext<lbcrypto::DCRTPoly> relinearized() const;
+  // multiplies two ciphertexts. relinearizes the result unless lazy
+  // evaluation is enabled
+  lbcrypto::Ciphertext<lbcrypto::DCRTPoly> mult(
+      const lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& lhs,
+      const lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& rhs) const;
+
+  // span of an operation on this ciphertext for the trace. records the levels
+  // of this and `rhs` if tracing is enabled
+  TraceSpan trace(const char* op,
+                  const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& rhs =
+                      nullptr) const;
+
+  // capture of an operation on this ciphertext with the operand `rhs` (see
+  // op_capture.h)
+  OpCapture capture(CAPTURE_OP op, bool inplace) const;
+  OpCapture capture(CAPTURE_OP op, bool inplace, const OpenFHECtxt& rhs) const;
+  OpCapture capture(CAPTURE_OP op, bool inplace,
+                    const std::shared_ptr<HEPtxt>& rhs) const;
+  template <class T>
+  OpCapture capture(CAPTURE_OP op, bool inplace, T rhs) const;
+
+  // OpenFHE rescales and level reduces the operands of an operation itself.
+  // counts the adjustments needed to combine `lhs` and `rhs`
+  static void count_adjustments(
+      const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& lhs,
+      const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& rhs, bool mult);
+  // plaintexts are encoded to match the ciphertext. only the rescale before a
+  // multiplication is counted
+  static void count_adjustments(
+      const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& ctxt, bool mult);
+
+  static bool count_ops;
+
+  // ctxt x ctx
+  static std::atomic_ulong mult_ctxt_count;
+  // ctxt x ptx
+  static std::atomic_ulong mult_ptxt_count;
+
+  // ctxt x ctx
+  static std::atomic_ulong add_ctxt_count;
+  // ctxt x ptx
+  static std::atomic_ulong add_ptxt_count;
+
+  static std::atomic_ulong rot_count;
+
+  // adjustments performed by OpenFHE
+  static std::atomic_ulong level_reduce_count;
+  static std::atomic_ulong rescale_count;
 
   OpenFHECtxt(const OpenFHECtxt& other) = default;
 };
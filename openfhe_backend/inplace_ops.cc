@@ -0,0 +1,48 @@
+#include "inplace_ops.h"
+
+namespace {
+
+using Ciphertext = lbcrypto::Ciphertext<lbcrypto::DCRTPoly>;
+using ConstCiphertext = lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>;
+
+// true if the polynomials of `rhs` can be combined with those of `lhs` as
+// they are. ciphertexts at the same level have the same primes and, with the
+// same noise scale degree, the same scale. a product that is not relinearized
+// yet has an extra polynomial which `rhs` can't have
+bool matching(const Ciphertext& lhs, const ConstCiphertext& rhs) {
+  return lhs->GetLevel() == rhs->GetLevel() &&
+         lhs->GetNoiseScaleDeg() == rhs->GetNoiseScaleDeg() &&
+         lhs->GetElements().size() >= rhs->GetElements().size();
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+void add_in_place(const lbcrypto::CryptoContext<lbcrypto::DCRTPoly>& cc,
+                  Ciphertext& lhs, const ConstCiphertext& rhs) {
+  if (!matching(lhs, rhs)) {
+    cc->EvalAddInPlace(lhs, rhs);
+    return;
+  }
+  std::vector<lbcrypto::DCRTPoly>& lhs_elements = lhs->GetElements();
+  const std::vector<lbcrypto::DCRTPoly>& rhs_elements = rhs->GetElements();
+  for (size_t i = 0; i < rhs_elements.size(); ++i) {
+    lhs_elements[i] += rhs_elements[i];
+  }
+}
+
+void sub_in_place(const lbcrypto::CryptoContext<lbcrypto::DCRTPoly>& cc,
+                  Ciphertext& lhs, const ConstCiphertext& rhs) {
+  if (!matching(lhs, rhs)) {
+    cc->EvalSubInPlace(lhs, rhs);
+    return;
+  }
+  std::vector<lbcrypto::DCRTPoly>& lhs_elements = lhs->GetElements();
+  const std::vector<lbcrypto::DCRTPoly>& rhs_elements = rhs->GetElements();
+  for (size_t i = 0; i < rhs_elements.size(); ++i) {
+    lhs_elements[i] -= rhs_elements[i];
+  }
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,24 @@
+#ifndef ALUMINUM_SHARK_OPENFHE_BACKEND_INPLACE_OPS_H
+#define ALUMINUM_SHARK_OPENFHE_BACKEND_INPLACE_OPS_H
+
+#include "openfhe.h"
+
+namespace aluminum_shark {
+
+// adds `rhs` to `lhs` in place. if both ciphertexts are at the same level and
+// noise scale degree their polynomials are added directly and neither
+// ciphertext is copied. EvalAddInPlace copies `rhs` before it matches it to
+// `lhs`, even if there is nothing to match. otherwise OpenFHE reduces a
+// temporary copy of `rhs` or `lhs` itself to the common level
+void add_in_place(const lbcrypto::CryptoContext<lbcrypto::DCRTPoly>& cc,
+                  lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& lhs,
+                  const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& rhs);
+
+// subtracts `rhs` from `lhs` in place. see `add_in_place`
+void sub_in_place(const lbcrypto::CryptoContext<lbcrypto::DCRTPoly>& cc,
+                  lbcrypto::Ciphertext<lbcrypto::DCRTPoly>& lhs,
+                  const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& rhs);
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_OPENFHE_BACKEND_INPLACE_OPS_H */
@@ -1,10 +1,15 @@
 #include "ptxt.h"
 
+#include <string_view>
+
 namespace aluminum_shark {
 
 OpenFHEPtxt::OpenFHEPtxt(lbcrypto::Plaintext ptxt, CONTENT_TYPE content_type,
                          const OpenFHEContext& context)
-    : _internal_ptxt(ptxt), _content_type(content_type), _context(context) {
+    : _internal_ptxt(ptxt),
+      _content_type(content_type),
+      _context(context),
+      _encodings(context.levels()) {
   count_ptxt(1);
 }
 
@@ -33,8 +38,71 @@ size_t OpenFHEPtxt::size() {
   return 0;
 }
 
+lbcrypto::ConstPlaintext OpenFHEPtxt::encodedAt(uint32_t level,
+                                                size_t noiseScaleDeg) const {
+  if (double_values.empty() && long_values.empty()) {
+    return _internal_ptxt;
+  }
+  if (!_context.is_ckks()) {
+    // encoding does not depend on the level
+    level = 0;
+    noiseScaleDeg = 1;
+  }
+  lbcrypto::ConstPlaintext ptxt = _encodings.find(level, noiseScaleDeg);
+  if (ptxt) {
+    return ptxt;
+  }
+  const auto& crypto_context = _context._internal_context;
+  if (!_context.is_ckks()) {
+    ptxt = crypto_context->MakePackedPlaintext(long_values);
+  } else if (double_values.empty()) {
+    std::vector<double> values(long_values.begin(), long_values.end());
+    ptxt = crypto_context->MakeCKKSPackedPlaintext(values, noiseScaleDeg,
+                                                   level);
+  } else {
+    ptxt = crypto_context->MakeCKKSPackedPlaintext(double_values,
+                                                   noiseScaleDeg, level);
+  }
+  return _encodings.publish(level, noiseScaleDeg, std::move(ptxt));
+}
+
+lbcrypto::ConstPlaintext OpenFHEPtxt::encodedToMatch(
+    const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& ctxt,
+    bool mult) const {
+  if (mult && ctxt->GetNoiseScaleDeg() > 1) {
+    // OpenFHE rescales the ciphertext before multiplying it
+    return encodedAt(ctxt->GetLevel() + 1, 1);
+  }
+  return encodedAt(ctxt->GetLevel(), mult ? 1 : ctxt->GetNoiseScaleDeg());
+}
+
+void OpenFHEPtxt::precompute() const {
+  for (uint32_t level = 0; level < _encodings.levels(); ++level) {
+    encodedAt(level);
+    if (!_context.is_ckks()) {
+      break;
+    }
+  }
+}
+
 bool OpenFHEPtxt::isAllZero() const { return _allZero; }
 
 bool OpenFHEPtxt::isAllOne() const { return _allOne; }
 
+size_t OpenFHEPtxt::n_values() const {
+  return double_values.size() != 0 ? double_values.size()
+                                   : long_values.size();
+}
+
+size_t OpenFHEPtxt::values_hash() const {
+  std::string_view bytes =
+      double_values.size() != 0
+          ? std::string_view(
+                reinterpret_cast<const char*>(double_values.data()),
+                double_values.size() * sizeof(double))
+          : std::string_view(reinterpret_cast<const char*>(long_values.data()),
+                             long_values.size() * sizeof(long));
+  return std::hash<std::string_view>{}(bytes);
+}
+
 }  // namespace aluminum_shark
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <string>
 
 #include "context.h"
+#include "encoding_table.h"
 #include "he_backend/he_backend.h"
 #include "openfhe.h"
 
@@ -38,10 +39,27 @@ class OpenFHEPtxt : public HEPtxt {
 
   CONTENT_TYPE content_type() const;
 
+  // returns the values encoded at `level` with `noiseScaleDeg` without
+  // modifying this plaintext. encodings are kept per (level, noiseScaleDeg),
+  // lookups don't block. falls back to the plaintext this was created with
+  // if the values are not available
+  lbcrypto::ConstPlaintext encodedAt(uint32_t level,
+                                     size_t noiseScaleDeg = 1) const;
+  // encoding at the level and scale `ctxt` is at when it is added to a
+  // plaintext or, if `mult` is true, after OpenFHE rescaled it for a product
+  lbcrypto::ConstPlaintext encodedToMatch(
+      const lbcrypto::ConstCiphertext<lbcrypto::DCRTPoly>& ctxt,
+      bool mult) const;
+
+  // encodes the values at every level
+  void precompute() const;
+
   bool isAllZero() const;
   bool isAllOne() const;
 
-  std::mutex mutex;
+  // number and hash of the values this plaintext was created from
+  size_t n_values() const;
+  size_t values_hash() const;
 
  protected:
   lbcrypto::Plaintext _internal_ptxt;
@@ -56,11 +74,15 @@ class OpenFHEPtxt : public HEPtxt {
   bool _allZero = false;
   bool _allOne = false;
 
+  // encodings by (level, noiseScaleDeg). BFV encodings are stored at (0, 1)
+  mutable EncodingTable<lbcrypto::PlaintextImpl> _encodings;
+
   OpenFHEPtxt(const OpenFHEPtxt& other)
       : _content_type(other._content_type),
         _context(other._context),
         _allZero(other._allZero),
-        _allOne(other._allOne) {
+        _allOne(other._allOne),
+        _encodings(other._encodings.levels()) {
     count_ptxt(1);
   };
 };
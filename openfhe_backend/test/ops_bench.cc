@@ -0,0 +1,104 @@
+// compares the allocations and the time per ciphertext addition and
+// subtraction of the previous OpenFHE backend ops (EvalAdd / EvalSub on the
+// full ciphertexts, Clone + EvalSubInPlace) with add_in_place and
+// sub_in_place. counts calls to operator new. prints allocations, allocated
+// MB and us per op for operands at the same level and at different levels.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "inplace_ops.h"
+#include "openfhe.h"
+
+namespace {
+
+std::atomic<size_t> allocations{0};
+std::atomic<size_t> allocated_bytes{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+  void* ptr = std::malloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace {
+
+using Ciphertext = lbcrypto::Ciphertext<lbcrypto::DCRTPoly>;
+
+void run(const std::string& name, size_t n, const std::function<void()>& op) {
+  // warm up
+  op();
+  size_t start_allocations = allocations.load();
+  size_t start_bytes = allocated_bytes.load();
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    op();
+  }
+  double us = std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  std::cout << name << ", "
+            << static_cast<double>(allocations.load() - start_allocations) / n
+            << ", "
+            << static_cast<double>(allocated_bytes.load() - start_bytes) / n /
+                   (1 << 20)
+            << ", " << us / n << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const size_t n = argc > 1 ? std::stoul(argv[1]) : 1000;
+  lbcrypto::CCParams<lbcrypto::CryptoContextCKKSRNS> params;
+  params.SetMultiplicativeDepth(3);
+  params.SetScalingModSize(40);
+  params.SetRingDim(8192);
+  params.SetScalingTechnique(lbcrypto::ScalingTechnique::FLEXIBLEAUTO);
+  params.SetSecurityLevel(lbcrypto::SecurityLevel::HEStd_NotSet);
+  auto cc = lbcrypto::GenCryptoContext(params);
+  cc->Enable(lbcrypto::PKESchemeFeature::PKE);
+  cc->Enable(lbcrypto::PKESchemeFeature::KEYSWITCH);
+  cc->Enable(lbcrypto::PKESchemeFeature::LEVELEDSHE);
+  auto keys = cc->KeyGen();
+
+  std::vector<double> input(cc->GetEncodingParams()->GetBatchSize(), 1e-6);
+  auto ptxt = cc->MakeCKKSPackedPlaintext(input);
+  Ciphertext lhs = cc->Encrypt(keys.publicKey, ptxt);
+  Ciphertext rhs = cc->Encrypt(keys.publicKey, ptxt);
+  Ciphertext reduced = cc->LevelReduce(rhs, nullptr, 1);
+  Ciphertext lhs_reduced = cc->LevelReduce(lhs, nullptr, 1);
+
+  std::cout << "op, allocations per op, MB per op, us per op" << std::endl;
+  run("EvalAdd", n, [&]() { lhs = cc->EvalAdd(lhs, rhs); });
+  run("add_in_place", n, [&]() { aluminum_shark::add_in_place(cc, lhs, rhs); });
+  run("Clone + EvalSubInPlace", n, [&]() {
+    auto temp = rhs->Clone();
+    cc->EvalSubInPlace(lhs, temp);
+  });
+  run("sub_in_place", n, [&]() { aluminum_shark::sub_in_place(cc, lhs, rhs); });
+  // the rhs is one level below: both need to reduce a copy of it
+  run("EvalAdd, different levels", n,
+      [&]() { lhs_reduced = cc->EvalAdd(lhs_reduced, rhs); });
+  run("add_in_place, different levels", n,
+      [&]() { aluminum_shark::add_in_place(cc, lhs_reduced, rhs); });
+  run("EvalAdd, same reduced level", n,
+      [&]() { lhs_reduced = cc->EvalAdd(lhs_reduced, reduced); });
+  run("add_in_place, same reduced level", n,
+      [&]() { aluminum_shark::add_in_place(cc, lhs_reduced, reduced); });
+  return 0;
+}
@@ -10,6 +10,7 @@ from aluminum_shark.c_arguments import aluminum_shark_Argument, get_argument_typ
 import time
 import copy
 import datetime
+import json
 
 CRITICAL = 50
 ERROR = 40
@@ -151,7 +152,7 @@ create_pub_key_func.argtypes = [ctypes.c_void_p]
 create_priv_key_func = python_api_lib.aluminum_shark_CreatePrivateKey
 create_priv_key_func.argtypes = [ctypes.c_void_p]
 
-# TODO: saving and loading keys.
+# saving and loading keys
 save_pub_key_func = python_api_lib.aluminum_shark_SavePublicKey
 save_pub_key_func.argtypes = [ctypes.c_char_p, ctypes.c_void_p]
 
@@ -387,7 +388,12 @@ class CallbackHandler(object):
       name = bytes.decode(name)
       if start:
         start_t = time.time()
-        self.op_history.append({'start': start_t, 'op': name, 'before': {}})
+        self.op_history.append({
+            'start': start_t,
+            'start_ns': time.monotonic_ns(),
+            'op': name,
+            'before': {}
+        })
         self.__current_object = self.op_history[-1]['before']
         if self.show_hlo_progress:
           print(f'{self.__progress}/? started computing: ', name,
@@ -395,6 +401,7 @@ class CallbackHandler(object):
       else:
         end_t = time.time()
         self.op_history[-1]['end'] = end_t
+        self.op_history[-1]['end_ns'] = time.monotonic_ns()
         self.op_history[-1]['after'] = {}
         self.__current_object = self.op_history[-1]['after']
         self.__progress += 1
@@ -441,11 +448,39 @@ class CallbackHandler(object):
     total_ctxt_operations = 0
     for key in self.history:
       compiled_history['total_' + key] = self.history[key][-1]
-      total_ctxt_operations += self.history[key][-1]
+      # monitors also report values that are not ciphertext operations
+      if key.startswith('ctxt_'):
+        total_ctxt_operations += self.history[key][-1]
     compiled_history['total_ciphertext_operations'] = total_ctxt_operations
 
     return compiled_history
 
+  def trace_events(self):
+    """
+    The recorded HLOs as Chrome trace events. They use the same clock as the
+    events of the backend (see `HEBackend.write_trace`).
+    """
+    events = [{
+        'name': 'process_name',
+        'ph': 'M',
+        'pid': 0,
+        'args': {
+            'name': 'hlo'
+        }
+    }]
+    for entry in self.op_history:
+      if 'end_ns' not in entry:
+        continue
+      events.append({
+          'name': entry['op'],
+          'ph': 'X',
+          'pid': 0,
+          'tid': 0,
+          'ts': entry['start_ns'] / 1e3,
+          'dur': (entry['end_ns'] - entry['start_ns']) / 1e3
+      })
+    return events
+
 
 class EncryptedExecution(ObjectCleaner):
 
@@ -744,11 +779,17 @@ class Context(ObjectCleaner):
     A ciphertext can be given a name for debuggin purposes. If no name is passed
     a UUID will be generated.
 
+    numpy arrays are encrypted without converting them to lists. Their type is
+    `float` if the dtype is a floating point type (e.g. float32 or float64).
+
     Returns: encrypted `Ciphertext`
     """
     if name is None:
       name = str(uuid.uuid1())
 
+    if isinstance(ptxt, np.ndarray):
+      return self.__encrypt_ndarray(ptxt, name, dtype, shape, layout)
+
     if shape is None:
       if hasattr(ptxt, 'shape'):
         shape = ptxt.shape
@@ -788,36 +829,116 @@ class Context(ObjectCleaner):
                       shape=shape,
                       layout=layout)
 
-  def decrypt_long(self, ctxt: CipherText) -> List[int]:
+  def __encrypt_ndarray(self, ptxt: np.ndarray, name: str, dtype,
+                        shape: Union[None, Iterable[int]],
+                        layout: str) -> CipherText:
+    # numpy arrays are passed to the API through their buffer. the values are
+    # only copied if the array is strided or not of the C type, e.g. float32
+    # data is converted to double in one vectorized step
+    if shape is None:
+      shape = ptxt.shape
+    if dtype is None:
+      is_float = ptxt.dtype.kind == 'f'
+    else:
+      is_float = dtype == float
+    if is_float:
+      c_type = ctypes.c_double
+      __enc_func = encrypt_double_func
+    else:
+      c_type = ctypes.c_long
+      __enc_func = encrypt_long_func
+    data = np.ascontiguousarray(ptxt, dtype=np.dtype(c_type)).reshape(-1)
+    ptxt_ptr = data.ctypes.data_as(ctypes.POINTER(c_type))
+
+    name_arg = name.encode('utf-8')
+    shape_ptr = (ctypes.c_size_t * len(shape))(*shape)
+    shape_size = len(shape)
+    layout_c = layout.encode('utf-8')
+
+    ctxt_handle = __enc_func(ptxt_ptr, data.size, name_arg, shape_ptr,
+                             shape_size, layout_c, self.__handle)
+    return CipherText(handle=ctxt_handle,
+                      context=self,
+                      shape=shape,
+                      layout=layout)
+
+  def decrypt_long(self,
+                   ctxt: CipherText,
+                   out: Union[None, np.ndarray] = None) -> np.ndarray:
+    """
+    Decrypt the `ctxt` and decode it as `int`. The values are written to `out`
+    if it is passed (see `decrypt_batch`).
+    """
+    return self.__decrypt_internal(ctxt, decrypt_long_func, int, out)
+
+  def decrypt_double(self,
+                     ctxt: CipherText,
+                     out: Union[None, np.ndarray] = None) -> np.ndarray:
     """
-    Decrypt the `ctxt` and decode it as `int`.
+    Decrypt the `ctxt` and decode it as `float`. The values are written to
+    `out` if it is passed (see `decrypt_batch`).
     """
-    return self.__decrypt_internal(ctxt, decrypt_long_func, int)
+    return self.__decrypt_internal(ctxt, decrypt_double_func, float, out)
 
-  def decrypt_double(self, ctxt: CipherText) -> List[float]:
+  def decrypt_batch(self,
+                    ctxts: List[CipherText],
+                    dtype=float,
+                    out: Union[None, np.ndarray] = None) -> np.ndarray:
     """
-    Decrypt the `ctxt` and decode it as `float`.
+    Decrypt all `ctxts` into one array of shape `(len(ctxts), *shape)`. All
+    ciphertexts need to have the same shape. `out` can be passed to reuse an
+    array. It needs to be C-contiguous, have the right size and a dtype that
+    matches `dtype` (int64 for `int`, float64 for `float`).
     """
-    return self.__decrypt_internal(ctxt, decrypt_double_func, float)
+    if len(ctxts) == 0:
+      raise ValueError("Nothing to decrypt")
+    shape = (len(ctxts),) + self.__shape(ctxts[0])
+    out = self.__output_array(shape, dtype, out)
+    rows = out.reshape(len(ctxts), -1)
+    decrypt_func = decrypt_double_func if dtype == float else decrypt_long_func
+    for ctxt, row in zip(ctxts, rows):
+      self.__decrypt_internal(ctxt, decrypt_func, dtype, row)
+    return out
 
-  def __decrypt_internal(self, ctxt: CipherText, decrypt_func,
-                         dtype) -> np.array:
-    # get the shape to compute the size of the reutrn array
+  @staticmethod
+  def __shape(ctxt: CipherText) -> tuple:
     shape = ctxt.shape
-    size = 1
-    for x in shape:
-      size = size * x
+    if isinstance(shape, int):
+      return (shape,)
+    return tuple(shape)
+
+  @staticmethod
+  def __output_array(shape, dtype, out: Union[None, np.ndarray]) -> np.ndarray:
+    # decryption writes directly into the buffer of the returned array
     if dtype == int:
-      ret = (ctypes.c_long * size)(*list(range(size)))
+      np_dtype = np.dtype(ctypes.c_long)
     elif dtype == float:
-      ret = (ctypes.c_double * size)(*list(range(size)))
+      np_dtype = np.dtype(ctypes.c_double)
     else:
       raise ValueError("Data type needs to be float or int")
-    # ret_ptr = ctypes.pointer(ret)
+    if out is None:
+      return np.empty(shape, dtype=np_dtype)
+    if not isinstance(out, np.ndarray) or out.dtype != np_dtype:
+      raise ValueError(f"out needs to be a numpy array of type {np_dtype}")
+    if not out.flags['C_CONTIGUOUS']:
+      raise ValueError("out needs to be C-contiguous")
+    if out.size != int(np.prod(shape)):
+      raise ValueError(
+          f"out has {out.size} elements, decryption needs shape {shape}")
+    return out
+
+  def __decrypt_internal(self,
+                         ctxt: CipherText,
+                         decrypt_func,
+                         dtype,
+                         out: Union[None, np.ndarray] = None) -> np.ndarray:
+    shape = self.__shape(ctxt)
+    ret = self.__output_array(shape, dtype, out)
+    c_type = ctypes.c_long if dtype == int else ctypes.c_double
     AS_LOG("Calling decryption function,", decrypt_func.argtypes)
-    decrypt_func(ret, ctxt._handle, self.__handle)
-    ret_value = np.asarray(ret[:]).reshape(shape)
-    return ret_value
+    decrypt_func(ret.ctypes.data_as(ctypes.POINTER(c_type)), ctxt._handle,
+                 self.__handle)
+    return ret
 
   def create_keys(self) -> None:
     """
@@ -844,6 +965,36 @@ class Context(ObjectCleaner):
     create_priv_key_func(self.__handle)
     self.__has_priv_key = True
 
+  def save_public_key(self, file: str) -> None:
+    """
+    Saves the encryption parameters, public, relinearization and rotation keys
+    to `file`.
+    """
+    save_pub_key_func(file.encode('utf-8'), self.__handle)
+
+  def save_private_key(self, file: str) -> None:
+    """
+    Saves the encryption parameters and the private key to `file`.
+    """
+    save_priv_key_func(file.encode('utf-8'), self.__handle)
+
+  def load_public_key(self, file: str) -> None:
+    """
+    Loads the public, relinearization and rotation keys from `file` instead of
+    creating them. The context needs to use the parameters the keys were saved
+    with.
+    """
+    load_pub_key_func(file.encode('utf-8'), self.__handle)
+    self.__has_pub_key = True
+
+  def load_private_key(self, file: str) -> None:
+    """
+    Loads the private key from `file` instead of creating it. The context needs
+    to use the parameters the key was saved with.
+    """
+    load_priv_key_func(file.encode('utf-8'), self.__handle)
+    self.__has_priv_key = True
+
   @property
   def keys_created(self) -> bool:
     """
@@ -974,6 +1125,36 @@ class HEBackend(ObjectCleaner):
     """
     enable_ressource_monitor_func(enable, self.__handle)
 
+  def enable_tracing(self, enable):
+    """
+    Turns recording of backend operation spans on or off. Can also be turned on
+    by setting ALUMINUM_SHARK_TRACE=1.
+    """
+    lib = ctypes.CDLL(self._lib_path)
+    lib.aluminum_shark_enable_tracing.argtypes = [ctypes.c_bool]
+    lib.aluminum_shark_enable_tracing(enable)
+
+  def write_trace(self, file: str, monitor: CallbackHandler = None) -> int:
+    """
+    Writes the recorded backend operations to `file` as Chrome trace JSON and
+    clears them. If the `monitor` of an execution is given its HLOs are added
+    as a separate process. The file can be opened in chrome://tracing or
+    ui.perfetto.dev. Returns the number of backend events written.
+    """
+    lib = ctypes.CDLL(self._lib_path)
+    lib.aluminum_shark_write_trace.argtypes = [ctypes.c_char_p]
+    lib.aluminum_shark_write_trace.restype = ctypes.c_long
+    written = lib.aluminum_shark_write_trace(str.encode(file))
+    if written < 0:
+      raise RuntimeError('failed to write trace to ' + file)
+    if monitor is not None:
+      with open(file) as f:
+        trace = json.load(f)
+      trace['traceEvents'].extend(monitor.trace_events())
+      with open(file, 'w') as f:
+        json.dump(trace, f)
+    return written
+
 
 def debug_on(flag: bool) -> None:
   enable_logging_func(flag)
@@ -3,8 +3,12 @@
 
 #include "context.h"
 #include "ctxt.h"
+#include "level_cache.h"
 #include "logging.h"
+#include "op_capture.h"
+#include "phase_timing.h"
 #include "python/arg_utils.h"
+#include "scale_plan.h"
 #include "seal/seal.h"
 
 // this is the entry point to the backend
@@ -17,6 +21,35 @@ std::shared_ptr<aluminum_shark::HEBackend> createBackend() {
   return ptr;
 }
 
+// batch encryption for callers that only hold the HEContext of this backend,
+// e.g. the C API of the plugin (see SEALContext::encryptBatch)
+void encryptBatchDouble(aluminum_shark::HEContext* context,
+                        const double* values,
+                        const aluminum_shark::BatchLayout& layout,
+                        std::shared_ptr<aluminum_shark::HECtxt>* out,
+                        size_t threads) {
+  static_cast<aluminum_shark::SEALContext*>(context)->encryptBatch(
+      values, layout, out, "", threads);
+}
+
+void decryptBatchDouble(aluminum_shark::HEContext* context,
+                        const std::shared_ptr<aluminum_shark::HECtxt>* ctxts,
+                        const aluminum_shark::BatchLayout& layout,
+                        double* values, size_t threads) {
+  static_cast<aluminum_shark::SEALContext*>(context)->decryptBatch(
+      ctxts, layout, values, threads);
+}
+
+// see SEALContext::linearCombination. `bias` may be nullptr
+std::shared_ptr<aluminum_shark::HECtxt> linearCombination(
+    aluminum_shark::HEContext* context,
+    const std::vector<std::shared_ptr<aluminum_shark::HECtxt>>& ctxts,
+    const std::vector<std::shared_ptr<aluminum_shark::HEPtxt>>& ptxts,
+    std::shared_ptr<aluminum_shark::HEPtxt> bias) {
+  auto* he_context = static_cast<aluminum_shark::SEALContext*>(context);
+  return he_context->linearCombination(ctxts, ptxts, bias);
+}
+
 }  // extern "C"
 
 namespace {
@@ -47,20 +80,30 @@ HEContext* SEALBackend::createContextBFV(size_t poly_modulus_degree,
   }
   params.set_plain_modulus(plain_modulus);
   SEALContext* context_ptr = new SEALContext(seal::SEALContext(params), *this);
+  capture_context(false, false,
+                  capture_argument("poly_modulus_degree", poly_modulus_degree) +
+                      capture_argument("coeff_modulus", coeff_modulus) +
+                      capture_argument("plain_modulus", plain_modulus));
   return context_ptr;
 }
 
 HEContext* SEALBackend::createContextCKKS_internal(
     size_t poly_modulus_degree, const std::vector<int>& coeff_modulus,
-    double scale, bool galois_keys) {
+    double scale, bool galois_keys, bool lazy_evaluation,
+    const std::vector<int>& rotation_steps, bool plan_primes) {
   // setup the encryption parameters
   seal::EncryptionParameters params(seal::scheme_type::ckks);
   params.set_poly_modulus_degree(poly_modulus_degree);
+  // the planned primes keep the scales of all levels close to 2^scale (see
+  // ScalePlan)
   params.set_coeff_modulus(
-      seal::CoeffModulus::Create(poly_modulus_degree, coeff_modulus));
+      plan_primes
+          ? ScalePlan::coeff_modulus(poly_modulus_degree, coeff_modulus, scale)
+          : seal::CoeffModulus::Create(poly_modulus_degree, coeff_modulus));
 
   SEALContext* context_ptr =
-      new SEALContext(seal::SEALContext(params), *this, scale, galois_keys);
+      new SEALContext(seal::SEALContext(params), *this, scale, galois_keys,
+                      lazy_evaluation, rotation_steps);
 
   std::stringstream ss;
   auto& context_data = *(context_ptr->context().key_context_data());
@@ -116,7 +159,13 @@ HEContext* SEALBackend::createContextCKKS_internal(
 HEContext* SEALBackend::createContextCKKS(size_t poly_modulus_degree,
                                           const std::vector<int>& coeff_modulus,
                                           double scale) {
-  return createContextCKKS_internal(poly_modulus_degree, coeff_modulus, scale);
+  HEContext* context = createContextCKKS_internal(poly_modulus_degree,
+                                                  coeff_modulus, scale);
+  capture_context(true, false,
+                  capture_argument("poly_modulus_degree", poly_modulus_degree) +
+                      capture_argument("coeff_modulus", coeff_modulus) +
+                      capture_argument("scale", scale));
+  return context;
 }
 
 HEContext* SEALBackend::createContextCKKS(
@@ -128,6 +177,9 @@ HEContext* SEALBackend::createContextCKKS(
   std::vector<int> coeff_modulus;
   double scale = -1;
   bool galois_keys = true;
+  bool lazy_evaluation = false;
+  bool plan_primes = true;
+  std::vector<int> rotation_steps;
 
   for (const aluminum_shark_Argument& arg : arguments) {
     const char* name = arg.name;
@@ -160,6 +212,27 @@ HEContext* SEALBackend::createContextCKKS(
       }
       galois_keys = arg.int_ != 0;
       continue;
+    } else if (std::strcmp(name, "lazy_evaluation") == 0) {
+      if (arg.type != 0 || arg.is_array) {
+        AS_LOG_CRITICAL << name << " needs to be scalar int" << std::endl;
+      }
+      lazy_evaluation = arg.int_ != 0;
+      continue;
+    } else if (std::strcmp(name, "plan_primes") == 0) {
+      if (arg.type != 0 || arg.is_array) {
+        AS_LOG_CRITICAL << name << " needs to be scalar int" << std::endl;
+      }
+      plan_primes = arg.int_ != 0;
+      continue;
+    } else if (std::strcmp(name, "rotation_steps") == 0) {
+      if (arg.type != 0 || !arg.is_array) {
+        AS_LOG_CRITICAL << name << " needs to be int array" << std::endl;
+      }
+      long* arr = reinterpret_cast<long*>(arg.array_);
+      for (size_t i = 0; i < arg.size_; i++) {
+        rotation_steps.push_back(arr[i]);
+      }
+      continue;
     }
   }
 
@@ -167,8 +240,11 @@ HEContext* SEALBackend::createContextCKKS(
     AS_LOG_CRITICAL << "missing parameter" << std::endl;
     throw std::runtime_error("missing parameter");
   }
-  return createContextCKKS_internal(poly_modulus_degree, coeff_modulus, scale,
-                                    galois_keys);
+  HEContext* context = createContextCKKS_internal(
+      poly_modulus_degree, coeff_modulus, scale, galois_keys, lazy_evaluation,
+      rotation_steps, plan_primes);
+  capture_context(true, true, capture_arguments(arguments));
+  return context;
 }
 
 const std::string& SEALBackend::name() { return BACKEND_NAME; }
@@ -191,17 +267,70 @@ std::shared_ptr<Monitor> SEALBackend::enable_ressource_monitor(
     SEALMonitor::instance = nullptr;
     SEALCtxt::count_ops = false;
   }
+  enable_phase_timing(enable);
   return SEALMonitor::instance;
 }
 
 std::shared_ptr<SEALMonitor> SEALMonitor::instance;
 
-std::vector<std::string> SEALMonitor::supported_values{
-    "ctxt_ctxt_mulitplication",  //
-    "ctxt_ptxt_mulitplication",  //
-    "ctxt_ctxt_addition",        //
-    "ctxt_ptxt_addition",        //
-    "ctxt_rotation"};
+namespace {
+// number of operation and cache counters in SEALMonitor::supported_values
+constexpr size_t n_counters = 8;
+// matching counters, noise budget, level cache and zero and one shortcuts
+constexpr size_t n_level_values = 12;
+// number of values before the phase timings
+constexpr size_t n_untimed_values =
+    n_counters + n_level_values + SEALCtxt::MONITORED_LEVELS;
+// per phase: total, p50 and p99
+constexpr size_t n_phase_values = 3;
+}  // namespace
+
+// the counters are followed by the level telemetry: the operations done to
+// match scales and levels, the sampled BFV noise budget, the lookups of lower
+// level versions of ciphertexts, the operations skipped for zeros and ones and
+// the number of operations per chain index of their input. then come the
+// total, p50 and p99 of each phase and the time spent in each phase per level.
+// times are in microseconds. the names don't start with `ctxt_` so they are
+// not counted as operations
+std::vector<std::string> SEALMonitor::supported_values = [] {
+  std::vector<std::string> values{
+      "ctxt_ctxt_mulitplication",  //
+      "ctxt_ptxt_mulitplication",  //
+      "ctxt_ctxt_addition",        //
+      "ctxt_ptxt_addition",        //
+      "ctxt_rotation",             //
+      "ptxt_cache_hits",           //
+      "ptxt_cache_misses",         //
+      "ptxt_cache_evictions",      //
+      "match_mod_switch",          //
+      "match_rescale",             //
+      "match_multiplication",      //
+      "noise_budget_min_bits",     //
+      "noise_budget_last_bits",    //
+      "noise_budget_samples",      //
+      "level_cache_hits",          //
+      "level_cache_misses",        //
+      "level_cache_rejected",      //
+      "skipped_multiplication",    //
+      "skipped_addition",          //
+      "zero_materializations"};
+  for (size_t level = 0; level < SEALCtxt::MONITORED_LEVELS; ++level) {
+    values.push_back("ops_at_level_" + std::to_string(level));
+  }
+  for (size_t i = 0; i < N_PHASES; ++i) {
+    std::string phase = std::string("time_") + phase_name(PHASE(i));
+    values.push_back(phase + "_total_us");
+    values.push_back(phase + "_p50_us");
+    values.push_back(phase + "_p99_us");
+  }
+  for (size_t i = 0; i < N_PHASES; ++i) {
+    for (size_t level = 0; level < TIMED_LEVELS; ++level) {
+      values.push_back(std::string("time_") + phase_name(PHASE(i)) +
+                       "_level_" + std::to_string(level) + "_us");
+    }
+  }
+  return values;
+}();
 
 // helper. the value_no needs to cooresponds to the index in
 // SEALMonitor::supported_values
@@ -225,9 +354,77 @@ bool SEALMonitor::get_monitor_value(size_t value_no, double& value) {
     case 4:
       value = SEALCtxt::rot_count;
       return true;
+    case 5:
+      value = PlaintextCache::hits;
+      return true;
+    case 6:
+      value = PlaintextCache::misses;
+      return true;
+    case 7:
+      value = PlaintextCache::evictions;
+      return true;
+    case 8:
+      value = SEALCtxt::match_mod_switch_count;
+      return true;
+    case 9:
+      value = SEALCtxt::match_rescale_count;
+      return true;
+    case 10:
+      value = SEALCtxt::match_mult_count;
+      return true;
+    case 11:
+      value = SEALCtxt::noise_budget_min;
+      return true;
+    case 12:
+      value = SEALCtxt::noise_budget_last;
+      return true;
+    case 13:
+      value = SEALCtxt::noise_budget_samples;
+      return true;
+    case 14:
+      value = LevelCacheBudget::hits;
+      return true;
+    case 15:
+      value = LevelCacheBudget::misses;
+      return true;
+    case 16:
+      value = LevelCacheBudget::rejected;
+      return true;
+    case 17:
+      value = SEALCtxt::skipped_mult_count;
+      return true;
+    case 18:
+      value = SEALCtxt::skipped_add_count;
+      return true;
+    case 19:
+      value = SEALCtxt::zero_materialize_count;
+      return true;
     default:
-      return false;
+      break;
+  }
+  if (value_no < n_untimed_values) {
+    value = SEALCtxt::level_op_count[value_no - n_counters - n_level_values];
+    return true;
+  }
+  size_t timing_no = value_no - n_untimed_values;
+  if (timing_no < N_PHASES * n_phase_values) {
+    PHASE phase = PHASE(timing_no / n_phase_values);
+    switch (timing_no % n_phase_values) {
+      case 0:
+        value = phase_total_us(phase);
+        break;
+      case 1:
+        value = phase_quantile_us(phase, 0.5);
+        break;
+      default:
+        value = phase_quantile_us(phase, 0.99);
+    }
+    return true;
   }
+  timing_no -= N_PHASES * n_phase_values;
+  value = phase_level_total_us(PHASE(timing_no / TIMED_LEVELS),
+                               timing_no % TIMED_LEVELS);
+  return true;
 }
 
 bool SEALMonitor::get(const std::string& name, double& value) {
@@ -55,7 +55,8 @@ class SEALBackend : public HEBackend {
 
   virtual HEContext* createContextCKKS_internal(
       size_t poly_modulus_degree, const std::vector<int>& coeff_modulus,
-      double scale, bool galois_keys = true);
+      double scale, bool galois_keys = true, bool lazy_evaluation = false,
+      const std::vector<int>& rotation_steps = {}, bool plan_primes = true);
 
   virtual HEContext* createContextCKKS(
       std::vector<aluminum_shark_Argument> arguments) override;
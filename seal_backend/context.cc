@@ -2,14 +2,23 @@
 
 #include <stdlib.h>
 
+#include <chrono>
+#include <cstring>
 #include <functional>
+#include <limits>
 #include <memory>
 #include <string>
 
 #include "backend_logging.h"
 #include "ctxt.h"
+#include "ctxt_io.h"
+#include "linear_combination.h"
+#include "logging.h"
 #include "ptxt.h"
+#include "rotation_keys.h"
 #include "seal/seal.h"
+#include "section_file.h"
+#include "utils.h"
 #include "utils/utils.h"
 
 namespace {
@@ -38,6 +47,71 @@ void coeff_modulus_to_stringstream(
   ss << "]";
 }
 
+// maximum size of the plaintext cache in MB. 0 disables the cache
+const size_t ptxt_cache_mb =
+    std::getenv("ALUMINUM_SHARK_PTXT_CACHE_MB") == nullptr
+        ? 256
+        : std::stoul(std::getenv("ALUMINUM_SHARK_PTXT_CACHE_MB"));
+
+// if true all plaintexts created through `createPtxt` are encoded at every
+// level in the background
+const bool precompute_ptxt =
+    std::getenv("ALUMINUM_SHARK_PRECOMPUTE_PTXT") == nullptr
+        ? false
+        : std::stoi(std::getenv("ALUMINUM_SHARK_PRECOMPUTE_PTXT")) == 1;
+
+double to_mb(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+// compression selected by the environment variable `var`: "none" (default),
+// "zlib" or "zstd" if SEAL was built with them
+seal::compr_mode_type compression_from_env(const char* var) {
+  const char* mode = std::getenv(var);
+  if (mode == nullptr || std::strcmp(mode, "none") == 0) {
+    return seal::compr_mode_type::none;
+  }
+#ifdef SEAL_USE_ZLIB
+  if (std::strcmp(mode, "zlib") == 0) {
+    return seal::compr_mode_type::zlib;
+  }
+#endif
+#ifdef SEAL_USE_ZSTD
+  if (std::strcmp(mode, "zstd") == 0) {
+    return seal::compr_mode_type::zstd;
+  }
+#endif
+  AS_LOG_CRITICAL << "unsupported compression " << mode << " in " << var
+                  << ". using none" << std::endl;
+  return seal::compr_mode_type::none;
+}
+
+// compressed keys are smaller but slower to load. read on first use, so the
+// warning isn't logged during static initialization
+seal::compr_mode_type key_compression() {
+  static const seal::compr_mode_type mode =
+      compression_from_env("ALUMINUM_SHARK_KEY_COMPRESSION");
+  return mode;
+}
+
+// uncompressed ciphertexts are loaded from the mapped file without
+// deserialization
+seal::compr_mode_type ctxt_compression() {
+  static const seal::compr_mode_type mode =
+      compression_from_env("ALUMINUM_SHARK_CTXT_COMPRESSION");
+  return mode;
+}
+
+// user flags stored with ciphertexts
+constexpr uint32_t FLAG_NEEDS_RELIN = 1;
+constexpr uint32_t FLAG_NEEDS_RESCALE = 2;
+
+// if true saved public, relinearization and galois keys are regenerated in
+// SEAL's seeded form. this halves the file size but takes as long as the key
+// generation
+const bool seeded_keys =
+    std::getenv("ALUMINUM_SHARK_SEEDED_KEYS") == nullptr
+        ? false
+        : std::stoi(std::getenv("ALUMINUM_SHARK_SEEDED_KEYS")) == 1;
+
 }  // namespace
 
 namespace aluminum_shark {
@@ -53,13 +127,17 @@ CONTENT_TYPE type_to_content_type<double>() {
 }
 
 SEALContext::SEALContext(seal::SEALContext context, const SEALBackend& backend,
-                         double scale, bool galois_keys)
+                         double scale, bool galois_keys, bool lazy_evaluation,
+                         const std::vector<int>& rotation_steps)
     : _internal_context(context),
       _backend(backend),
       _scale(std::pow(2, scale)),
       _gen_galois_keys(galois_keys),
-      _keygen(context),
-      _sec_key(_keygen.secret_key()) {
+      _lazy_evaluation(lazy_evaluation),
+      _rotation_steps(rotation_steps),
+      _ptxt_cache(ptxt_cache_mb * 1024 * 1024),
+      _keygen(std::make_unique<seal::KeyGenerator>(context)),
+      _sec_key(_keygen->secret_key()) {
   _is_ckks = _internal_context.first_context_data()->parms().scheme() ==
              seal::scheme_type::ckks;
   _is_bfv = _internal_context.first_context_data()->parms().scheme() ==
@@ -74,6 +152,7 @@ SEALContext::SEALContext(seal::SEALContext context, const SEALBackend& backend,
     }
     _ckksencoder = std::make_unique<seal::CKKSEncoder>(_internal_context);
     _slot_count = _ckksencoder->slot_count();
+    _scale_plan = ScalePlan(_internal_context, _scale);
   }
   auto& params = _internal_context.first_context_data()->parms();
   std::stringstream ss;
@@ -88,6 +167,9 @@ SEALContext::SEALContext(seal::SEALContext context, const SEALBackend& backend,
        << "; coeff_modolus bits ";
     coeff_modulus_to_stringstream(ss, params.coeff_modulus(), true);
     ss << "; scale " << _scale;
+    if (_lazy_evaluation) {
+      ss << "; lazy evaluation";
+    }
   } else {
     ss << "unknown scheme";
   }
@@ -125,10 +207,33 @@ const seal::GaloisKeys& SEALContext::galoisKeys() const { return _gal_keys; }
 // the pub key gets created together with the secret key. so we create all the
 // nessecary structures like evalutor and such in this method
 void SEALContext::createPublicKey() {
-  _keygen.create_public_key(_pub_key);
-  _keygen.create_relin_keys(_relin_keys);
+  _keygen->create_public_key(_pub_key);
+  _keygen->create_relin_keys(_relin_keys);
+  AS_LOG_INFO << "relinearization keys: "
+              << to_mb(_relin_keys.save_size(seal::compr_mode_type::none))
+              << " MB" << std::endl;
   if (_gen_galois_keys) {
-    _keygen.create_galois_keys(_gal_keys);
+    if (_rotation_steps.empty()) {
+      _keygen->create_galois_keys(_gal_keys);
+    } else {
+      _keygen->create_galois_keys(galoisSteps(), _gal_keys);
+    }
+    size_t bytes = _gal_keys.save_size(seal::compr_mode_type::none);
+    AS_LOG_INFO << "galois keys: " << _gal_keys.size() << " keys, "
+                << to_mb(bytes) << " MB" << std::endl;
+    if (!_rotation_steps.empty() && _gal_keys.size() != 0) {
+      // SEAL generates 2 keys per power of two plus one for the conjugation
+      const size_t degree = _internal_context.key_context_data()
+                                ->parms()
+                                .poly_modulus_degree();
+      size_t all_keys = 1;
+      for (size_t n = 2; n < degree; n *= 2) {
+        all_keys += 2;
+      }
+      AS_LOG_INFO << "all power of two galois keys: " << all_keys << " keys, "
+                  << to_mb(bytes / _gal_keys.size() * all_keys) << " MB"
+                  << std::endl;
+    }
   }
   _encryptor = std::make_unique<seal::Encryptor>(_internal_context, _pub_key);
   _evaluator = std::make_unique<seal::Evaluator>(_internal_context);
@@ -139,28 +244,407 @@ void SEALContext::createPublicKey() {
 // automaticlaly generates the pubkey as well.
 void SEALContext::createPrivateKey() {
   BACKEND_LOG << "generating secret key" << std::endl;
-  // _sec_key = _keygen.secret_key();
+  // _sec_key = _keygen->secret_key();
   BACKEND_LOG << "Creating decryptor" << std::endl;
   _decryptor = std::make_unique<seal::Decryptor>(_internal_context, _sec_key);
   _sec_key_ready = true;
 }
 
-// save public key to file
+std::vector<int> SEALContext::rotationPlan(int steps) const {
+  const int slots = static_cast<int>(_slot_count);
+  _used_rotation_steps.record(((steps % slots) + slots) % slots);
+  if (steps % slots == 0) {
+    return {};
+  }
+  std::vector<int> plan;
+  {
+    // plans are only added and replaced by loaded keys, lookups share the lock
+    std::shared_lock<std::shared_mutex> lock(_rotation_mutex);
+    if (_rotation_steps.empty()) {
+      // all power of two keys are available. SEAL composes the step itself
+      return {steps};
+    }
+    auto it = _rotation_plans.find(steps);
+    if (it != _rotation_plans.end()) {
+      return it->second;
+    }
+    if (!compose_rotation(steps, slots, _rotation_steps, plan)) {
+      AS_LOG_CRITICAL << "no galois keys for a rotation by " << steps
+                      << ". add it to `rotation_steps`" << std::endl;
+      throw std::runtime_error("missing galois key for rotation by " +
+                               std::to_string(steps));
+    }
+  }
+  if (plan.size() > 1) {
+    AS_LOG_INFO << "rotation by " << steps << " is composed of "
+                << plan.size() << " rotations" << std::endl;
+  }
+  std::lock_guard<std::shared_mutex> lock(_rotation_mutex);
+  _rotation_plans.emplace(steps, plan);
+  return plan;
+}
+
+std::vector<int> SEALContext::usedRotationSteps() const {
+  std::vector<int> result;
+  for (int step : _used_rotation_steps.steps()) {
+    if (step != 0) {
+      result.push_back(step);
+    }
+  }
+  return result;
+}
+
+void SEALContext::logRotationSteps() const {
+  std::vector<int> steps = usedRotationSteps();
+  if (steps.empty()) {
+    return;
+  }
+  std::stringstream ss;
+  ss << "[";
+  for (size_t i = 0; i < steps.size(); ++i) {
+    ss << (i == 0 ? "" : ", ") << steps[i];
+  }
+  ss << "]";
+  AS_LOG_INFO << "rotation steps used: " << ss.str() << std::endl;
+}
+
+std::vector<int> SEALContext::galoisSteps() const {
+  // rotations by multiples of the slot count are no-ops and SEAL treats step 0
+  // as the conjugation
+  std::vector<int> steps;
+  for (int step : _rotation_steps) {
+    if (step % static_cast<int>(_slot_count) != 0) {
+      steps.push_back(step);
+    }
+  }
+  return steps;
+}
+
+void SEALContext::saveParameters(SectionWriter& writer) const {
+  const seal::EncryptionParameters& parms =
+      _internal_context.key_context_data()->parms();
+  writer.add(Section::PARAMETERS, [&parms](std::ostream& out) {
+    parms.save(out, seal::compr_mode_type::none);
+  });
+  writer.add(Section::SCALE, &_scale, sizeof(_scale));
+  writer.add(Section::ROTATION_STEPS, _rotation_steps.data(),
+             _rotation_steps.size() * sizeof(int));
+}
+
+void SEALContext::loadParameters(const SectionReader& reader) {
+  auto section = reader.get(Section::PARAMETERS);
+  seal::EncryptionParameters parms;
+  parms.load(reinterpret_cast<const seal::seal_byte*>(section.first),
+             section.second);
+  if (parms != _internal_context.key_context_data()->parms()) {
+    AS_LOG_CRITICAL << "encryption parameters of the keys don't match the "
+                       "context"
+                    << std::endl;
+    throw std::runtime_error("encryption parameters don't match");
+  }
+  section = reader.get(Section::SCALE);
+  double scale;
+  std::memcpy(&scale, section.first, sizeof(scale));
+  if (is_ckks() && scale != _scale) {
+    AS_LOG_INFO << "keys were saved from a context with scale " << scale
+                << " this context uses " << _scale << std::endl;
+  }
+  section = reader.get(Section::ROTATION_STEPS);
+  std::vector<int> steps(section.second / sizeof(int));
+  std::memcpy(steps.data(), section.first, steps.size() * sizeof(int));
+  std::lock_guard<std::shared_mutex> lock(_rotation_mutex);
+  _rotation_steps = std::move(steps);
+  _rotation_plans.clear();
+}
+
+// save public key to file. the file contains the encryption parameters, the
+// public, relinearization and galois keys
 void SEALContext::savePublicKey(const std::string& file) {
-  BACKEND_LOG << "saving keys not implemented yet" << std::endl;
+  if (!_pub_key_ready) {
+    AS_LOG_CRITICAL << "no public key to save" << std::endl;
+    throw std::runtime_error("no public key to save");
+  }
+  auto start = std::chrono::steady_clock::now();
+  SectionWriter writer(file, BACKEND_NAME);
+  saveParameters(writer);
+  auto save = [](const auto& obj) {
+    return [&obj](std::ostream& out) { obj.save(out, key_compression()); };
+  };
+  if (seeded_keys) {
+    // only freshly generated keys can be saved seeded. they are as valid as
+    // the keys in use since they belong to the same secret key
+    writer.add(Section::PUBLIC_KEY, save(_keygen->create_public_key()));
+    writer.add(Section::RELIN_KEYS, save(_keygen->create_relin_keys()));
+    if (_gal_keys.size() != 0) {
+      writer.add(Section::GALOIS_KEYS,
+                 save(_rotation_steps.empty()
+                          ? _keygen->create_galois_keys()
+                          : _keygen->create_galois_keys(galoisSteps())));
+    }
+  } else {
+    writer.add(Section::PUBLIC_KEY, save(_pub_key));
+    writer.add(Section::RELIN_KEYS, save(_relin_keys));
+    if (_gal_keys.size() != 0) {
+      writer.add(Section::GALOIS_KEYS, save(_gal_keys));
+    }
+  }
+  writer.close();
+  AS_LOG_INFO << "saved public keys to " << file << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
 }
-// save private key ot file
+
+// save private key ot file. the file contains the encryption parameters and
+// the secret key. it is only readable by the owner
 void SEALContext::savePrivateKey(const std::string& file) {
-  BACKEND_LOG << "saving keys not implemented yet" << std::endl;
+  SectionWriter writer(file, BACKEND_NAME, true);
+  saveParameters(writer);
+  writer.add(Section::SECRET_KEY, [this](std::ostream& out) {
+    _sec_key.save(out, key_compression());
+  });
+  writer.close();
+  AS_LOG_INFO << "saved secret key to " << file << std::endl;
 }
 
-// load public key from file
+// load public key from file. replaces the public, relinearization and galois
+// keys
 void SEALContext::loadPublicKey(const std::string& file) {
-  BACKEND_LOG << "loading keys not implemented yet" << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  SectionReader reader(file, BACKEND_NAME);
+  loadParameters(reader);
+  auto load = [&reader, this](Section tag, auto& obj) {
+    auto section = reader.get(tag);
+    obj.load(_internal_context,
+             reinterpret_cast<const seal::seal_byte*>(section.first),
+             section.second);
+  };
+  load(Section::PUBLIC_KEY, _pub_key);
+  load(Section::RELIN_KEYS, _relin_keys);
+  _gen_galois_keys = reader.has(Section::GALOIS_KEYS);
+  if (_gen_galois_keys) {
+    load(Section::GALOIS_KEYS, _gal_keys);
+  } else {
+    _gal_keys = seal::GaloisKeys();
+  }
+  _encryptor = std::make_unique<seal::Encryptor>(_internal_context, _pub_key);
+  _evaluator = std::make_unique<seal::Evaluator>(_internal_context);
+  _pub_key_ready = true;
+  _pub_key_loaded = true;
+  AS_LOG_INFO << "loaded public keys from " << file << " in "
+              << std::chrono::duration<double, std::milli>(
+                     std::chrono::steady_clock::now() - start)
+                     .count()
+              << " ms" << std::endl;
 }
-// load private key from file
+
+// load private key from file. the public keys need to be loaded as well or
+// created after this
 void SEALContext::loadPrivateKey(const std::string& file) {
-  BACKEND_LOG << "loading keys not implemented yet" << std::endl;
+  SectionReader reader(file, BACKEND_NAME);
+  loadParameters(reader);
+  auto section = reader.get(Section::SECRET_KEY);
+  _sec_key.load(_internal_context,
+                reinterpret_cast<const seal::seal_byte*>(section.first),
+                section.second);
+  // new keys need to be derived from the loaded secret key
+  _keygen = std::make_unique<seal::KeyGenerator>(_internal_context, _sec_key);
+  _decryptor = std::make_unique<seal::Decryptor>(_internal_context, _sec_key);
+  _sec_key_ready = true;
+  if (_pub_key_ready && !_pub_key_loaded) {
+    AS_LOG_CRITICAL << "the public keys belong to a different secret key. "
+                       "load or create them again"
+                    << std::endl;
+  }
+  AS_LOG_INFO << "loaded secret key from " << file << std::endl;
+}
+
+std::shared_ptr<HECtxt> SEALContext::linearCombination(
+    const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+    const std::vector<std::shared_ptr<HEPtxt>>& ptxts,
+    std::shared_ptr<HEPtxt> bias) const {
+  if (ctxts.empty() || ctxts.size() != ptxts.size()) {
+    AS_LOG_CRITICAL << "linear combination of " << ctxts.size()
+                    << " ciphertexts and " << ptxts.size() << " plaintexts"
+                    << std::endl;
+    throw std::invalid_argument(
+        "need the same number of ciphertexts and plaintexts");
+  }
+  // apply pending operations and find the lowest level
+  std::vector<seal::Ciphertext> scratch(ctxts.size());
+  std::vector<const seal::Ciphertext*> inputs;
+  std::vector<std::shared_ptr<SEALPtxt>> weights;
+  inputs.reserve(ctxts.size());
+  weights.reserve(ctxts.size());
+  std::shared_ptr<const SEALCtxt> first =
+      std::dynamic_pointer_cast<const SEALCtxt>(ctxts[0]);
+  size_t min_chain_index = std::numeric_limits<size_t>::max();
+  seal::parms_id_type target = first->shape().first;
+  for (size_t i = 0; i < ctxts.size(); ++i) {
+    auto ptxt = std::dynamic_pointer_cast<SEALPtxt>(ptxts[i]);
+    if (ptxt->isAllZero()) {
+      // SEAL refuses to create transparent ciphertexts
+      continue;
+    }
+    auto ctxt = std::dynamic_pointer_cast<const SEALCtxt>(ctxts[i]);
+    if (ctxt->is_zero()) {
+      // the product adds nothing, the zero isn't encrypted
+      SEALCtxt::count_skipped_mult();
+      continue;
+    }
+    const seal::Ciphertext& flushed = ctxt->flushed(scratch[i]);
+    size_t chain_index =
+        _internal_context.get_context_data(flushed.parms_id())->chain_index();
+    if (chain_index < min_chain_index) {
+      min_chain_index = chain_index;
+      target = flushed.parms_id();
+    }
+    inputs.push_back(&flushed);
+    weights.push_back(ptxt);
+  }
+
+  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
+      first->name() + " linear combination", first->content_type(), *this);
+  seal::Ciphertext& dst = result->sealCiphertext();
+  try {
+    // scale of all products. the plaintexts make up for different ciphertext
+    // scales. if the products can be rescaled they are placed on the planned
+    // scale of the target level
+    const bool planned = is_ckks() && !inputs.empty() && min_chain_index > 0;
+    double product_scale = inputs.empty()
+                               ? _scale * _scale
+                               : inputs[0]->scale() * inputs[0]->scale();
+    if (planned) {
+      product_scale = _scale_plan.product_scale(min_chain_index);
+    }
+    std::vector<std::shared_ptr<const seal::Plaintext>> encoded;
+    std::vector<const seal::Plaintext*> encoded_ptrs;
+    std::vector<seal::Ciphertext> switched(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (inputs[i]->parms_id() != target) {
+        _evaluator->mod_switch_to(*inputs[i], target, switched[i]);
+        inputs[i] = &switched[i];
+      }
+      double plain_scale =
+          planned ? _scale_plan.plain_scale(min_chain_index, inputs[i]->scale())
+                  : product_scale / inputs[i]->scale();
+      encoded.push_back(weights[i]->encoded(plain_scale, target));
+      encoded_ptrs.push_back(encoded.back().get());
+      SEALCtxt::count_ctxt_ptxt_mult();
+      if (i != 0) {
+        SEALCtxt::count_ctxt_ctxt_add();
+      }
+    }
+    if (inputs.empty()) {
+      _encryptor->encrypt_zero(target, dst);
+      dst.scale() = product_scale;
+    } else if (is_ckks()) {
+      multiply_plain_accumulate(_internal_context, inputs, encoded_ptrs, dst);
+    } else {
+      seal::Ciphertext product;
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        seal::Ciphertext& out = i == 0 ? dst : product;
+        _evaluator->multiply_plain(*inputs[i], *encoded_ptrs[i], out);
+        if (i != 0) {
+          _evaluator->add_inplace(dst, product);
+        }
+      }
+    }
+    if (bias) {
+      auto bias_ptxt = std::dynamic_pointer_cast<SEALPtxt>(bias);
+      if (!bias_ptxt->isAllZero()) {
+        _evaluator->add_plain_inplace(
+            dst, *bias_ptxt->encoded(dst.scale(), dst.parms_id()));
+        SEALCtxt::count_ctxt_ptxt_add();
+      }
+    }
+  } catch (const std::exception& e) {
+    logComputationError(dst, dst, "linearCombination", __FILE__, __LINE__, &e,
+                        &_internal_context);
+    throw;
+  }
+  if (is_ckks()) {
+    // single rescale for all products
+    result->multiplied(false);
+  }
+  result->track_bytes();
+  return result;
+}
+
+void SEALContext::saveCiphertexts(
+    const std::string& file, const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+    const std::vector<size_t>& shape) const {
+  auto start = std::chrono::steady_clock::now();
+  int content_type =
+      ctxts.empty()
+          ? CONTENT_TYPE::invalid
+          : std::dynamic_pointer_cast<SEALCtxt>(ctxts[0])->content_type();
+  CtxtFileWriter writer(file, BACKEND_NAME, content_type,
+                        static_cast<uint32_t>(ctxt_compression()), shape,
+                        ctxts.size());
+  size_t bytes = 0;
+  for (const auto& ctxt : ctxts) {
+    auto seal_ctxt = std::dynamic_pointer_cast<const SEALCtxt>(ctxt);
+    uint32_t flags = (seal_ctxt->_needs_relin ? FLAG_NEEDS_RELIN : 0) |
+                     (seal_ctxt->_needs_rescale ? FLAG_NEEDS_RESCALE : 0);
+    write_ciphertext(writer, _internal_context, seal_ctxt->sealCiphertext(),
+                     ctxt_compression(), flags);
+    bytes += seal_ctxt->sealCiphertext().dyn_array().size() *
+             sizeof(seal::Ciphertext::ct_coeff_type);
+  }
+  writer.close();
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  AS_LOG_INFO << "saved " << ctxts.size() << " ciphertexts to " << file
+              << " at " << to_mb(bytes) / seconds << " MB/s" << std::endl;
+}
+
+std::vector<std::shared_ptr<HECtxt>> SEALContext::loadCiphertexts(
+    const std::string& file, std::vector<size_t>* shape) const {
+  auto start = std::chrono::steady_clock::now();
+  CtxtFileReader reader(file, BACKEND_NAME);
+  std::vector<std::shared_ptr<HECtxt>> result;
+  result.reserve(reader.count());
+  size_t bytes = 0;
+  for (size_t i = 0; i < reader.count(); ++i) {
+    auto ctxt = std::make_shared<SEALCtxt>(
+        file + "[" + std::to_string(i) + "]",
+        static_cast<CONTENT_TYPE>(reader.content_type()), *this);
+    uint32_t flags = read_ciphertext(reader, i, _internal_context,
+                                     ctxt->sealCiphertext());
+    ctxt->_needs_relin = flags & FLAG_NEEDS_RELIN;
+    ctxt->_needs_rescale = flags & FLAG_NEEDS_RESCALE;
+    ctxt->track_bytes();
+    bytes += ctxt->sealCiphertext().dyn_array().size() *
+             sizeof(seal::Ciphertext::ct_coeff_type);
+    result.push_back(ctxt);
+  }
+  if (shape != nullptr) {
+    *shape = reader.shape();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  AS_LOG_INFO << "loaded " << result.size() << " ciphertexts from " << file
+              << " at " << to_mb(bytes) / seconds << " MB/s" << std::endl;
+  return result;
+}
+
+void SEALContext::saveCiphertext(const std::string& file,
+                                 const std::shared_ptr<HECtxt>& ctxt) const {
+  saveCiphertexts(file, {ctxt});
+}
+
+std::shared_ptr<HECtxt> SEALContext::loadCiphertext(
+    const std::string& file) const {
+  auto ctxts = loadCiphertexts(file);
+  if (ctxts.size() != 1) {
+    throw std::runtime_error(file + " contains " +
+                             std::to_string(ctxts.size()) + " ciphertexts");
+  }
+  return ctxts[0];
 }
 
 // Ciphertext related
@@ -201,13 +685,17 @@ std::shared_ptr<HECtxt> SEALContext::encrypt(std::shared_ptr<HEPtxt> ptxt,
       std::make_shared<SEALCtxt>(name, seal_ptxt->content_type(), *this);
   _encryptor->encrypt(seal_ptxt->sealPlaintext(), ctxt_ptr->sealCiphertext(),
                       ctxt_ptr->sealCiphertext().pool());
+  ctxt_ptr->track_bytes();
   return ctxt_ptr;
 }
 
 // decryption functions
+// ciphertexts with pending relinearization or rescaling (lazy evaluation) can
+// be decrypted as is. SEAL decrypts ciphertexts of size > 2 and the decoder
+// takes the scale of the (not rescaled) ciphertext into account.
 std::vector<long> SEALContext::decryptLong(std::shared_ptr<HECtxt> ctxt) const {
-  std::shared_ptr<SEALCtxt> seal_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(ctxt);
+  std::shared_ptr<const SEALCtxt> seal_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(ctxt);
   std::shared_ptr<SEALPtxt> result =
       std::make_shared<SEALPtxt>(seal::Plaintext(), CONTENT_TYPE::LONG, *this);
   _decryptor->decrypt(seal_ctxt->sealCiphertext(), result->sealPlaintext());
@@ -216,8 +704,8 @@ std::vector<long> SEALContext::decryptLong(std::shared_ptr<HECtxt> ctxt) const {
 
 std::vector<double> SEALContext::decryptDouble(
     std::shared_ptr<HECtxt> ctxt) const {
-  std::shared_ptr<SEALCtxt> seal_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(ctxt);
+  std::shared_ptr<const SEALCtxt> seal_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(ctxt);
   BACKEND_LOG << "decrypting " << std::endl;
   std::shared_ptr<SEALPtxt> result = std::make_shared<SEALPtxt>(
       seal::Plaintext(), CONTENT_TYPE::DOUBLE, *this);
@@ -228,6 +716,44 @@ std::vector<double> SEALContext::decryptDouble(
   return decodeDouble(result);
 }
 
+// batch encryption. the encoders, the encryptor and the decryptor only read
+// shared state, the workers allocate from the memory pool of the ciphertexts
+void SEALContext::encryptBatch(const double* values, const BatchLayout& layout,
+                               std::shared_ptr<HECtxt>* out,
+                               const std::string& name, size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    std::vector<double> plain;
+    layout.gather(values, i, plain);
+    out[i] = encrypt(plain, name + "[" + std::to_string(i) + "]");
+  });
+}
+
+void SEALContext::encryptBatch(const long* values, const BatchLayout& layout,
+                               std::shared_ptr<HECtxt>* out,
+                               const std::string& name, size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    std::vector<long> plain;
+    layout.gather(values, i, plain);
+    out[i] = encrypt(plain, name + "[" + std::to_string(i) + "]");
+  });
+}
+
+void SEALContext::decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                               const BatchLayout& layout, double* values,
+                               size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    layout.scatter(decryptDouble(ctxts[i]), i, values);
+  });
+}
+
+void SEALContext::decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                               const BatchLayout& layout, long* values,
+                               size_t threads) const {
+  parallel_for(layout.count, threads, [&](size_t i) {
+    layout.scatter(decryptLong(ctxts[i]), i, values);
+  });
+}
+
 // Plaintext related
 
 // encoding
@@ -241,7 +767,7 @@ std::shared_ptr<HEPtxt> SEALContext::encode(
   } else {
     // create plaintext
     if (plain.size() == 1) {
-      _batchencoder->encode(std::vector<long>(plain[0], _slot_count),
+      _batchencoder->encode(std::vector<long>(_slot_count, plain[0]),
                             ptxt_ptr->sealPlaintext());
     } else {
       _batchencoder->encode(plain, ptxt_ptr->sealPlaintext());
@@ -251,6 +777,7 @@ std::shared_ptr<HEPtxt> SEALContext::encode(
     ptxt_ptr->_allZero = zero_one.first;
     ptxt_ptr->_allOne = zero_one.second;
   }
+  ptxt_ptr->track_bytes();
   return ptxt_ptr;
 }
 
@@ -286,6 +813,7 @@ std::shared_ptr<HEPtxt> SEALContext::encode(const std::vector<long>& plain,
     ptxt_ptr->_allZero = zero_one.first;
     ptxt_ptr->_allOne = zero_one.second;
   }
+  ptxt_ptr->track_bytes();
   return ptxt_ptr;
 }
 std::shared_ptr<HEPtxt> SEALContext::encode(const std::vector<double>& plain,
@@ -316,6 +844,7 @@ std::shared_ptr<HEPtxt> SEALContext::encode(const std::vector<double>& plain,
   auto zero_one = all_zero_or_one(plain);
   ptxt_ptr->_allZero = zero_one.first;
   ptxt_ptr->_allOne = zero_one.second;
+  ptxt_ptr->track_bytes();
   return ptxt_ptr;
 }
 
@@ -331,12 +860,13 @@ void SEALContext::encode(SEALPtxt& ptxt, seal::parms_id_type params_id,
     }
   } else {
     if (ptxt.long_values.size() == 1) {
-      _batchencoder->encode(std::vector<long>(ptxt.long_values[0], _slot_count),
+      _batchencoder->encode(std::vector<long>(_slot_count, ptxt.long_values[0]),
                             ptxt._internal_ptxt);
     } else {
       _batchencoder->encode(ptxt.long_values, ptxt._internal_ptxt);
     }
   }
+  ptxt.track_bytes();
 }
 
 std::shared_ptr<HEPtxt> SEALContext::createPtxt(
@@ -351,6 +881,12 @@ std::shared_ptr<HEPtxt> SEALContext::createPtxt(
                                       *this);
   }
   ptxt->long_values = vec;
+  auto zero_one = all_zero_or_one(vec);
+  ptxt->_allZero = zero_one.first;
+  ptxt->_allOne = zero_one.second;
+  if (precompute_ptxt) {
+    precomputeEncodings({ptxt});
+  }
   return ptxt;
 }
 
@@ -367,6 +903,12 @@ std::shared_ptr<HEPtxt> SEALContext::createPtxt(
   }
 
   ptxt->double_values = vec;
+  auto zero_one = all_zero_or_one(vec);
+  ptxt->_allZero = zero_one.first;
+  ptxt->_allOne = zero_one.second;
+  if (precompute_ptxt) {
+    precomputeEncodings({ptxt});
+  }
   return ptxt;
 }
 
@@ -382,9 +924,73 @@ std::shared_ptr<HEPtxt> SEALContext::createPtxt(
                                       *this);
   }
   ptxt->double_values = vec;
+  auto zero_one = all_zero_or_one(vec);
+  ptxt->_allZero = zero_one.first;
+  ptxt->_allOne = zero_one.second;
+  if (precompute_ptxt) {
+    precomputeEncodings({ptxt});
+  }
   return ptxt;
 }
 
+void SEALContext::precomputeEncodings(
+    const std::vector<std::shared_ptr<HEPtxt>>& ptxts) const {
+  std::lock_guard<std::mutex> lock(_precompute_mutex);
+  if (_precompute_stop) {
+    return;
+  }
+  for (const auto& ptxt : ptxts) {
+    _precompute_queue.push_back(std::dynamic_pointer_cast<SEALPtxt>(ptxt));
+  }
+  if (!_precompute_thread.joinable()) {
+    _precompute_thread = std::thread(&SEALContext::precomputeLoop, this);
+  }
+  _precompute_cv.notify_one();
+}
+
+void SEALContext::precomputeLoop() const {
+  size_t count = 0;
+  while (true) {
+    std::shared_ptr<const SEALPtxt> ptxt;
+    {
+      std::unique_lock<std::mutex> lock(_precompute_mutex);
+      _precompute_cv.wait(lock, [this]() {
+        return _precompute_stop || !_precompute_queue.empty();
+      });
+      if (_precompute_stop) {
+        break;
+      }
+      ptxt = _precompute_queue.front().lock();
+      _precompute_queue.pop_front();
+    }
+    // plaintexts that are gone already are skipped
+    if (!ptxt) {
+      continue;
+    }
+    try {
+      ptxt->precompute();
+      ++count;
+    } catch (const std::exception& e) {
+      AS_LOG_CRITICAL << "precomputing plaintext encodings failed: "
+                      << e.what() << std::endl;
+    }
+  }
+  BACKEND_LOG << "precomputed the encodings of " << count << " plaintexts"
+              << std::endl;
+}
+
+void SEALContext::stopPrecompute() {
+  {
+    std::lock_guard<std::mutex> lock(_precompute_mutex);
+    _precompute_stop = true;
+    _precompute_queue.clear();
+  }
+  _precompute_cv.notify_one();
+  if (_precompute_thread.joinable()) {
+    _precompute_thread.join();
+  }
+}
+
 HE_SCHEME SEALContext::scheme() const {
   BACKEND_LOG << "getting scheme type: "
               << (is_ckks() ? HE_SCHEME::CKKS : HE_SCHEME::BFV) << std::endl;
@@ -2,13 +2,26 @@
 #define ALUMINUM_SHARK_SEAL_BACKEND_CONTEXT_H
 
 #include <atomic>
+#include <condition_variable>
+#include <deque>
 #include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "backend.h"
 #include "backend_logging.h"
+#include "ctxt_pool.h"
 #include "he_backend/he_backend.h"
 #include "object_count.h"
+#include "parallel.h"
+#include "ptxt_cache.h"
+#include "rotation_keys.h"
+#include "scale_plan.h"
+#include "section_file.h"
 
 namespace aluminum_shark {
 
@@ -58,7 +71,17 @@ class SEALContext : public HEContext {
                 << std::endl;
       std::cout << "  total destroyed ctxt: " << get_ctxt_destructions()
                 << std::endl;
+
+      std::cout << "  ptxt bytes still alive: " << get_ptxt_bytes()
+                << std::endl;
+      std::cout << "  ctxt bytes still alive: " << get_ctxt_bytes()
+                << std::endl;
+      std::cout << "  max alive bytes: " << get_max_bytes() << std::endl;
     }
+    stopPrecompute();
+    logRotationSteps();
+    // the buffers are sized for the parameters of this context
+    CiphertextFreelist::trim();
   };
 
   virtual const std::string& to_string() const override;
@@ -146,7 +169,9 @@ class SEALContext : public HEContext {
 
   // SEAL specific API
   SEALContext(seal::SEALContext context, const SEALBackend& backend,
-              double scale = -1, bool galois_keys = true);
+              double scale = -1, bool galois_keys = true,
+              bool lazy_evaluation = false,
+              const std::vector<int>& rotation_steps = {});
 
   template <class T>
   std::vector<T> decode(const SEALPtxt& ptxt) const;
@@ -161,6 +186,74 @@ class SEALContext : public HEContext {
 
   int64_t get_mem_mode() const { return memory_mode; };
 
+  // if true relinearization and rescaling after a multiplication are deferred
+  // until an operation requires them. see `SEALCtxt::flush`
+  bool lazy_evaluation() const { return _lazy_evaluation; };
+
+  PlaintextCache& plaintextCache() const { return _ptxt_cache; };
+
+  // planned scale of every level for CKKS (see ScalePlan). empty for BFV
+  const ScalePlan& scalePlan() const { return _scale_plan; };
+
+  // encodes `ptxts` at all levels (see SEALPtxt::precompute) on a background
+  // thread. operations that need an encoding before it is ready encode it
+  // themselves. with ALUMINUM_SHARK_PRECOMPUTE_PTXT=1 every plaintext created
+  // through `createPtxt` is queued
+  void precomputeEncodings(
+      const std::vector<std::shared_ptr<HEPtxt>>& ptxts) const;
+
+  // computes sum_i ctxts[i] * ptxts[i] + bias. CKKS products are accumulated
+  // at the lowest level of the inputs and rescaled once (see
+  // multiply_plain_accumulate). `bias` is optional. the result has the same
+  // scale and level as `*ctxts[0] * ptxts[0]`
+  std::shared_ptr<HECtxt> linearCombination(
+      const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+      const std::vector<std::shared_ptr<HEPtxt>>& ptxts,
+      std::shared_ptr<HEPtxt> bias = nullptr) const;
+
+  // encrypts the vectors of a batch stored in `values` at the positions given
+  // by `layout`. encoding and encryption are spread over `threads` workers (0
+  // selects ALUMINUM_SHARK_BATCH_THREADS). `out` needs room for `layout.count`
+  // ciphertexts. ciphertext i is named `name[i]`
+  void encryptBatch(const double* values, const BatchLayout& layout,
+                    std::shared_ptr<HECtxt>* out, const std::string& name = "",
+                    size_t threads = 0) const;
+  void encryptBatch(const long* values, const BatchLayout& layout,
+                    std::shared_ptr<HECtxt>* out, const std::string& name = "",
+                    size_t threads = 0) const;
+  // decrypts `layout.count` ciphertexts in parallel and writes their first
+  // `layout.slots` values to `values` at the positions given by `layout`
+  void decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                    const BatchLayout& layout, double* values,
+                    size_t threads = 0) const;
+  void decryptBatch(const std::shared_ptr<HECtxt>* ctxts,
+                    const BatchLayout& layout, long* values,
+                    size_t threads = 0) const;
+
+  // ciphertext serialization. a batch of ciphertexts is stored together with
+  // its shape in a single file (see CtxtFileWriter). pending lazy operations
+  // are stored with the ciphertexts. ALUMINUM_SHARK_CTXT_COMPRESSION selects
+  // the compression
+  void saveCiphertexts(const std::string& file,
+                       const std::vector<std::shared_ptr<HECtxt>>& ctxts,
+                       const std::vector<size_t>& shape = {}) const;
+  // `shape` is set to the stored shape if it is not null
+  std::vector<std::shared_ptr<HECtxt>> loadCiphertexts(
+      const std::string& file, std::vector<size_t>* shape = nullptr) const;
+  void saveCiphertext(const std::string& file,
+                      const std::shared_ptr<HECtxt>& ctxt) const;
+  std::shared_ptr<HECtxt> loadCiphertext(const std::string& file) const;
+
+  // steps of the galois keys used to rotate by `steps`. the list is empty if
+  // no rotation is needed. if only the keys for `rotation_steps` were
+  // generated a missing step is composed from the available keys. throws if
+  // that is not possible. records `steps` as used
+  std::vector<int> rotationPlan(int steps) const;
+
+  // all rotation steps used so far. passing them as `rotation_steps` to a new
+  // context generates only the keys the computation needs
+  std::vector<int> usedRotationSteps() const;
+
  private:
   friend class SEALPtxt;
   friend class SEALCtxt;
@@ -168,10 +261,20 @@ class SEALContext : public HEContext {
   const seal::SEALContext _internal_context;
   const SEALBackend& _backend;
   const double _scale;
+  ScalePlan _scale_plan;
   bool _gen_galois_keys = true;
+  bool _lazy_evaluation = false;
+  // steps to generate galois keys for. empty means all power of two steps
+  std::vector<int> _rotation_steps;
+  mutable std::shared_mutex _rotation_mutex;
+  mutable std::unordered_map<int, std::vector<int>> _rotation_plans;
+  mutable RotationStepLog _used_rotation_steps;
+  // encoded plaintexts shared by all SEALPtxt created by this context
+  mutable PlaintextCache _ptxt_cache;
   std::unique_ptr<seal::BatchEncoder> _batchencoder;
   std::unique_ptr<seal::CKKSEncoder> _ckksencoder;
-  seal::KeyGenerator _keygen;
+  // replaced when a secret key is loaded
+  std::unique_ptr<seal::KeyGenerator> _keygen;
   seal::PublicKey _pub_key;
   seal::SecretKey _sec_key;
   seal::RelinKeys _relin_keys;
@@ -180,6 +283,7 @@ class SEALContext : public HEContext {
   std::unique_ptr<seal::Evaluator> _evaluator;
   std::unique_ptr<seal::Decryptor> _decryptor;
   bool _pub_key_ready = false;
+  bool _pub_key_loaded = false;
   bool _sec_key_ready = false;
   bool _is_ckks = false;
   bool _is_bfv = false;
@@ -187,31 +291,41 @@ class SEALContext : public HEContext {
   std::string _string_representation;
   int64_t memory_mode;
 
+  // background encoding of plaintexts. the thread is started with the first
+  // request and stopped by the destructor
+  mutable std::mutex _precompute_mutex;
+  mutable std::condition_variable _precompute_cv;
+  mutable std::deque<std::weak_ptr<const SEALPtxt>> _precompute_queue;
+  mutable std::thread _precompute_thread;
+  mutable bool _precompute_stop = false;
+
   bool is_ckks() const;
   bool is_bfv() const;
 
+  void logRotationSteps() const;
+
+  void precomputeLoop() const;
+  void stopPrecompute();
+
+  // `_rotation_steps` without the steps that don't need a key
+  std::vector<int> galoisSteps() const;
+
+  // parameters, scale and rotation steps stored with the keys. loading checks
+  // that the parameters match the context
+  void saveParameters(SectionWriter& writer) const;
+  void loadParameters(const SectionReader& reader);
+
   // checks if all values in a vector are 0 or 1. return std::pair<all_zero,
-  // all_one>
+  // all_one>. both are false for an empty vector
   template <class T>
   std::pair<bool, bool> all_zero_or_one(const std::vector<T>& in) const {
-    bool all_one = true;
-    bool all_zero = true;
-    if (in.size() == 1) {
-      all_zero = in[0] == 0;
-      all_one = in[0] == 1;
-
-    } else {
-      for (auto i : in) {
-        if (i != 0) {
-          all_zero = false;
-          break;
-        }
-      }
-      for (auto i : in) {
-        if (i != 1) {
-          all_one = true;
-          break;
-        }
+    bool all_zero = !in.empty();
+    bool all_one = !in.empty();
+    for (auto i : in) {
+      all_zero = all_zero && i == 0;
+      all_one = all_one && i == 1;
+      if (!all_zero && !all_one) {
+        break;
       }
     }
     return std::pair<bool, bool>(all_zero, all_one);
@@ -2,12 +2,22 @@
 
 #include <cxxabi.h>
 
+#include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <typeinfo>
 
+#include "backend_logging.h"
+#include "hoisted_rotation.h"
 #include "logging.h"
 #include "object_count.h"
+#include "op_capture.h"
+#include "op_trace.h"
+#include "phase_timing.h"
 #include "ptxt.h"
+#include "seal/util/iterator.h"
+#include "seal/util/polyarithsmallmod.h"
+#include "seal/util/uintarithsmallmod.h"
 #include "utils.h"
 #include "utils/macros.h"
 
@@ -15,6 +25,8 @@
 //   0 : off
 //  -1 : off
 //  -2 : everyone gets their own mempool
+//  -3 : every thread gets its own mempool. results of ciphertext operations
+//       reuse the buffers of destroyed ciphertexts (see CiphertextFreelist)
 namespace {
 const int64_t agressive_memory_cleanup =
     std::getenv("ALUMINUM_SHARK_AGRESSIVE_MEMORY_CLEANUP") == nullptr
@@ -26,6 +38,40 @@ const int64_t agressive_memory_cleanup =
 // guideline
 int64_t instance_counter = 0;
 std::mutex memory_cleaunp_mutex;
+
+// every n-th operation on a BFV ciphertext samples its invariant noise budget
+// while the ressource monitor is enabled. 0 disables sampling. sampling costs
+// about as much as a decryption
+const int64_t noise_budget_interval =
+    std::getenv("ALUMINUM_SHARK_NOISE_BUDGET_INTERVAL") == nullptr
+        ? 100
+        : std::stoi(std::getenv("ALUMINUM_SHARK_NOISE_BUDGET_INTERVAL"));
+std::atomic<int64_t> noise_budget_counter{0};
+
+// returns `value` mod `modulus` for signed values
+uint64_t reduce_signed(int64_t value, const seal::Modulus& modulus) {
+  uint64_t abs_value =
+      value < 0 ? -static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  uint64_t reduced = seal::util::barrett_reduce_64(abs_value, modulus);
+  return value < 0 ? seal::util::negate_uint_mod(reduced, modulus) : reduced;
+}
+
+// multiplies every coefficient of `ctxt` with `value`. for ciphertexts in NTT
+// form this is the product with the constant polynomial `value`
+void multiply_coefficients(seal::Ciphertext& ctxt, int64_t value,
+                           const seal::SEALContext& context) {
+  const auto& coeff_modulus =
+      context.get_context_data(ctxt.parms_id())->parms().coeff_modulus();
+  const size_t n = ctxt.poly_modulus_degree();
+  for (size_t i = 0; i < coeff_modulus.size(); ++i) {
+    const uint64_t scalar = reduce_signed(value, coeff_modulus[i]);
+    for (size_t j = 0; j < ctxt.size(); ++j) {
+      seal::util::CoeffIter poly(ctxt.data(j) + i * n);
+      seal::util::multiply_poly_scalar_coeffmod(poly, n, scalar,
+                                                coeff_modulus[i], poly);
+    }
+  }
+}
 }  // namespace
 
 namespace aluminum_shark {
@@ -36,6 +82,13 @@ void update_memory_manager(const std::string& group) {
     seal::MemoryManager::SwitchProfile(std::make_unique<seal::MMProfNew>());
     return;
   }
+  if (agressive_memory_cleanup == -3) {
+    // groups don't change anything. the pools are kept for the lifetime of
+    // the threads
+    seal::MemoryManager::SwitchProfile(std::make_unique<MMProfPerThread>());
+    CiphertextFreelist::enable(true);
+    return;
+  }
   AS_LOG_INFO << "creating new Memory Pool for " << group << std::endl;
   seal::MemoryPoolHandle my_pool = seal::MemoryPoolHandle::New();
   seal::MemoryManager::SwitchProfile(
@@ -53,8 +106,9 @@ SEALCtxt::SEALCtxt(seal::Ciphertext&& ctxt, const std::string& name,
     : _name(name),
       _content_type(content_type),
       _context(context),
-      _internal_ctxt(std::move(ctxt)) {
+      _shared(std::make_shared<Shared>(std::move(ctxt))) {
   count_ctxt(1);
+  track_bytes();
   if (agressive_memory_cleanup > 0) {
     // check if we reached the threshold
     if (instance_counter > agressive_memory_cleanup) {
@@ -74,9 +128,9 @@ SEALCtxt::SEALCtxt(seal::Ciphertext&& ctxt, const std::string& name,
 };
 
 const seal::Ciphertext& SEALCtxt::sealCiphertext() const {
-  return _internal_ctxt;
+  return ciphertext();
 }
-seal::Ciphertext& SEALCtxt::sealCiphertext() { return _internal_ctxt; }
+seal::Ciphertext& SEALCtxt::sealCiphertext() { return mutable_ciphertext(); }
 
 CONTENT_TYPE SEALCtxt::content_type() const { return _content_type; }
 
@@ -85,29 +139,130 @@ const std::string& SEALCtxt::name() const { return _name; }
 // TODO: more info
 std::string SEALCtxt::to_string() const {
   std::stringstream ss;
-  ss << "SEAL Ctxt: " << _name << "scale " << _internal_ctxt.scale();
+  ss << "SEAL Ctxt: " << _name << "scale " << shape().second;
   return ss.str();
 }
 
 const HEContext* SEALCtxt::getContext() const { return &_context; }
 
+// the copy shares the ciphertext until one of them is modified
 std::shared_ptr<HECtxt> SEALCtxt::deepCopy() {
+  OpCapture captured = capture(CAPTURE_OP::COPY, false);
   // work around since the copy constructor is private
   SEALCtxt* raw = new SEALCtxt(*this);
   std::shared_ptr<SEALCtxt> result = std::shared_ptr<SEALCtxt>(raw);
-  std::stringstream ss;
-  ss << "this " << static_cast<void*>(this) << " copy "
-     << static_cast<void*>(result.get()) << std::endl;
-  AS_LOG_DEBUG << ss.str();
+  BACKEND_LOG_DEBUG << "this " << static_cast<void*>(this) << " copy "
+                    << static_cast<void*>(result.get()) << std::endl;
+  captured.result(result.get());
   return result;
 }
 
+SEALCtxt::Shared::~Shared() {
+  count_ctxt_bytes(-counted_bytes);
+  CiphertextFreelist::release(ctxt);
+}
+
+void SEALCtxt::track_bytes() {
+  if (!AS_OBJECT_COUNT) {
+    return;
+  }
+  // the buffer holds all polynomials, the same number of bytes as size()
+  // without reading the parameters. a zero that isn't materialized has no
+  // buffer. shared ciphertexts are counted once
+  int64_t bytes = _shared->ctxt.dyn_array().size() *
+                  sizeof(seal::Ciphertext::ct_coeff_type);
+  count_ctxt_bytes(bytes - _shared->counted_bytes);
+  _shared->counted_bytes = bytes;
+}
+
+size_t SEALCtxt::timed_level(const seal::Ciphertext& ctxt) const {
+  if (!phase_timing_enabled()) {
+    return 0;
+  }
+  return _context._internal_context.get_context_data(ctxt.parms_id())
+      ->chain_index();
+}
+
+int SEALCtxt::chain_index(const seal::Ciphertext& ctxt) const {
+  return chain_index(ctxt.parms_id());
+}
+
+int SEALCtxt::chain_index(const seal::parms_id_type& parms_id) const {
+  return _context._internal_context.get_context_data(parms_id)->chain_index();
+}
+
+TraceSpan SEALCtxt::trace(const char* op, const SEALCtxt* rhs) const {
+  if (!tracing_enabled()) {
+    return TraceSpan(op);
+  }
+  return TraceSpan(op, chain_index(shape().first),
+                   rhs ? chain_index(rhs->shape().first) : -1);
+}
+
+OpCapture SEALCtxt::capture(CAPTURE_OP op, bool inplace) const {
+  OpCapture captured(op, inplace);
+  if (captured.active()) {
+    auto lhs = shape();
+    captured.lhs(this, chain_index(lhs.first), lhs.second);
+  }
+  return captured;
+}
+
+OpCapture SEALCtxt::capture(CAPTURE_OP op, bool inplace,
+                            const SEALCtxt& rhs) const {
+  OpCapture captured = capture(op, inplace);
+  if (captured.active()) {
+    auto rhs_shape = rhs.shape();
+    captured.rhs(&rhs, chain_index(rhs_shape.first), rhs_shape.second);
+  }
+  return captured;
+}
+
+OpCapture SEALCtxt::capture(CAPTURE_OP op, bool inplace,
+                            const std::shared_ptr<HEPtxt>& rhs) const {
+  OpCapture captured = capture(op, inplace);
+  if (captured.active()) {
+    const SEALPtxt& ptxt = dynamic_cast<const SEALPtxt&>(*rhs);
+    captured.plain(ptxt.n_values(), ptxt.values_hash(),
+                   ptxt.content_type() == CONTENT_TYPE::DOUBLE,
+                   ptxt.isAllZero(), ptxt.isAllOne());
+  }
+  return captured;
+}
+
+template <class T>
+OpCapture SEALCtxt::capture(CAPTURE_OP op, bool inplace, T rhs) const {
+  OpCapture captured = capture(op, inplace);
+  captured.scalar(rhs);
+  return captured;
+}
+
+seal::Ciphertext& SEALCtxt::mutable_ciphertext() {
+  // a count of one can't go up behind our back, only this object can hand out
+  // new references. the fence orders our writes after the reads of the owners
+  // that let go of the ciphertext
+  if (_shared.use_count() == 1) {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    ciphertext();
+    _shared->zero = false;
+    _shared->levels.invalidate();
+    return _shared->ctxt;
+  }
+  const seal::Ciphertext& shared = ciphertext();
+  auto detached = std::make_shared<Shared>(
+      CiphertextFreelist::acquire(shared.size(), shared.coeff_modulus_size()));
+  detached->ctxt = shared;
+  _shared = std::move(detached);
+  track_bytes();
+  return _shared->ctxt;
+}
+
 // returns the size of the ciphertext in bytes
 size_t SEALCtxt::size() {
   // see: https://github.com/microsoft/SEAL/issues/88#issuecomment-564342477
   auto context_data =
-      _context._internal_context.get_context_data(_internal_ctxt.parms_id());
-  size_t size = _internal_ctxt.size();
+      _context._internal_context.get_context_data(ciphertext().parms_id());
+  size_t size = ciphertext().size();
   size *= context_data->parms().coeff_modulus().size();
   size *= context_data->parms().poly_modulus_degree();
   size *= 8;
@@ -120,219 +275,552 @@ size_t SEALCtxt::size() {
 
 // Addintion
 
+// lazy evaluation
+
+void SEALCtxt::flush() {
+  relinearize();
+  rescale();
+}
+
+void SEALCtxt::relinearize() {
+  if (_needs_relin) {
+    PhaseTimer timer(PHASE::RELINEARIZE, timed_level(ciphertext()));
+    _context._evaluator->relinearize_inplace(mutable_ciphertext(),
+                                             _context.relinKeys());
+    _needs_relin = false;
+  }
+}
+
+// rescaling works for ciphertexts of any size. so products can be rescaled
+// while the relinearization stays pending
+void SEALCtxt::rescale() {
+  if (_needs_rescale) {
+    PhaseTimer timer(PHASE::RESCALE, timed_level(ciphertext()));
+    seal::Ciphertext& ctxt = mutable_ciphertext();
+    _context._evaluator->rescale_to_next_inplace(ctxt);
+    _context.scalePlan().snap(ctxt, chain_index(ctxt));
+    _needs_rescale = false;
+  }
+}
+
+const seal::Ciphertext& SEALCtxt::flushed(seal::Ciphertext& scratch) const {
+  if (!_needs_relin && !_needs_rescale) {
+    return ciphertext();
+  }
+  if (_needs_relin) {
+    PhaseTimer timer(PHASE::RELINEARIZE, timed_level(ciphertext()));
+    _context._evaluator->relinearize(ciphertext(), _context.relinKeys(),
+                                     scratch);
+  } else {
+    scratch = ciphertext();
+  }
+  if (_needs_rescale) {
+    PhaseTimer timer(PHASE::RESCALE, timed_level(scratch));
+    _context._evaluator->rescale_to_next_inplace(scratch);
+    _context.scalePlan().snap(scratch, chain_index(scratch));
+  }
+  return scratch;
+}
+
+void SEALCtxt::multiplied(bool relin) {
+  _needs_relin = _needs_relin || relin;
+  _needs_rescale = true;
+  if (!_context.lazy_evaluation()) {
+    flush();
+  }
+}
+
+bool SEALCtxt::needs_relinearization() const { return _needs_relin; }
+
+bool SEALCtxt::needs_rescale() const { return _needs_rescale; }
+
+// zeros
+
+void SEALCtxt::materialize() const {
+  std::call_once(_shared->materialized, [this] {
+    seal::Ciphertext& ctxt = _shared->ctxt;
+    _context._encryptor->encrypt_zero(_shared->parms_id, ctxt);
+    ctxt.scale() = _shared->scale;
+    // only counts the bytes of the shared ciphertext
+    const_cast<SEALCtxt*>(this)->track_bytes();
+    _shared->placeholder.store(false, std::memory_order_release);
+    count_zero_materialization();
+  });
+}
+
+void SEALCtxt::become_zero(
+    const std::pair<seal::parms_id_type, double>& shape) {
+  // no polynomials are allocated until the zero is materialized
+  seal::Ciphertext placeholder;
+  placeholder.parms_id() = shape.first;
+  placeholder.scale() = shape.second;
+  _shared = std::make_shared<Shared>(std::move(placeholder));
+  _shared->zero = true;
+  _shared->parms_id = shape.first;
+  _shared->scale = shape.second;
+  _shared->placeholder.store(true, std::memory_order_relaxed);
+  _needs_relin = false;
+  _needs_rescale = false;
+  track_bytes();
+}
+
+void SEALCtxt::take(const SEALCtxt& other) {
+  _shared = other._shared;
+  _needs_relin = other._needs_relin;
+  _needs_rescale = other._needs_rescale;
+}
+
+std::pair<seal::parms_id_type, double> SEALCtxt::rescaled_shape(
+    const seal::parms_id_type& parms_id, double scale) const {
+  auto context_data = _context._internal_context.get_context_data(parms_id);
+  auto next = context_data->next_context_data();
+  if (!_context.is_ckks() || !next) {
+    return {parms_id, scale};
+  }
+  // same computation as rescale_to_next
+  scale /= static_cast<double>(
+      context_data->parms().coeff_modulus().back().value());
+  return {next->parms_id(),
+          _context.scalePlan().snapped(next->chain_index(), scale)};
+}
+
+std::pair<seal::parms_id_type, double> SEALCtxt::flushed_shape() const {
+  auto current = shape();
+  if (_needs_rescale) {
+    return rescaled_shape(current.first, current.second);
+  }
+  return current;
+}
+
+std::pair<seal::parms_id_type, double> SEALCtxt::plain_product_shape() const {
+  auto lhs = flushed_shape();
+  const double plain_scale =
+      _context.scalePlan().plain_scale(chain_index(lhs.first), lhs.second);
+  return rescaled_shape(lhs.first, lhs.second * plain_scale);
+}
+
+std::pair<seal::parms_id_type, double> SEALCtxt::product_shape(
+    const SEALCtxt& other) const {
+  auto lhs = flushed_shape();
+  auto rhs = other.flushed_shape();
+  // the operand at the higher level is mod switched down
+  const seal::parms_id_type& parms_id =
+      chain_index(lhs.first) <= chain_index(rhs.first) ? lhs.first : rhs.first;
+  return rescaled_shape(parms_id, lhs.second * rhs.second);
+}
+
+bool SEALCtxt::multiply_by_one() {
+  if (!_context.is_ckks()) {
+    // BFV plaintexts have no scale, the product is this ciphertext
+    return true;
+  }
+  auto product = plain_product_shape();
+  if (product.first == flushed_shape().first) {
+    // nothing can be rescaled, the scale can't be brought to the product's
+    return false;
+  }
+  if (is_zero()) {
+    become_zero(product);
+    return true;
+  }
+  rescale();
+  if (shape().second == product.second) {
+    seal::Ciphertext& ctxt = mutable_ciphertext();
+    _context._evaluator->mod_switch_to_inplace(ctxt, product.first);
+  } else {
+    // the planned scales of neighbouring levels differ, the scale is
+    // corrected by an integer multiplication (see `match_to`)
+    seal::Ciphertext& ctxt = mutable_ciphertext();
+    match_to(ctxt, product.first, product.second, ctxt);
+  }
+  track_bytes();
+  return true;
+}
+
 void SEALCtxt::match_scale_and_parms(const SEALCtxt& other) {
+  // scales and parameters are only meaningful once everything pending has
+  // been applied
+  flush();
+  seal::Ciphertext other_scratch;
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  match_to(ctxt, other.flushed(other_scratch), ctxt);
+}
+
+void SEALCtxt::match_to(const seal::Ciphertext& src,
+                        const seal::Ciphertext& target,
+                        seal::Ciphertext& dst) const {
+  match_to(src, target.parms_id(), target.scale(), dst);
+}
+
+void SEALCtxt::match_to(const seal::Ciphertext& src,
+                        const seal::parms_id_type& parms_id, double scale,
+                        seal::Ciphertext& dst) const {
+  PhaseTimer timer(PHASE::MATCH_SCALE, timed_level(src));
   const seal::SEALContext& seal_context = _context.context();
+  const seal::Ciphertext* current = &src;
+  if (src.scale() != scale && _context.is_ckks() &&
+      chain_index(src) > chain_index(parms_id)) {
+    // the correction is applied one level above the target and removed by
+    // the rescale to it. the primes above that level are dropped first and a
+    // constant needs no encoding, it multiplies the coefficients
+    auto above = seal_context.get_context_data(parms_id)->prev_context_data();
+    const double factor = std::round(
+        scale / src.scale() *
+        static_cast<double>(above->parms().coeff_modulus().back().value()));
+    // smaller factors lose precision, larger ones don't fit
+    if (factor >= 0x1p30 && factor < 0x1p62) {
+      if (src.parms_id() != above->parms_id()) {
+        _context._evaluator->mod_switch_to(src, above->parms_id(), dst);
+        count_match_mod_switch();
+      } else if (&src != &dst) {
+        dst = src;
+      }
+      multiply_coefficients(dst, static_cast<int64_t>(factor), seal_context);
+      count_ctxt_ptxt_mult();
+      count_match_mult();
+      _context._evaluator->rescale_to_next_inplace(dst);
+      count_match_rescale();
+      // the rounding of the factor is far below the precision of the values
+      dst.scale() = scale;
+      return;
+    }
+  }
   // do we need to match scales?
-  seal::Ciphertext& this_ctxt = _internal_ctxt;
-  const seal::Ciphertext& other_ctxt = other.sealCiphertext();
-  if (this_ctxt.scale() != other_ctxt.scale()) {
+  if (src.scale() != scale) {
     // calculate scale
     double last_prime =
-        static_cast<double>(seal_context.get_context_data(this_ctxt.parms_id())
+        static_cast<double>(seal_context.get_context_data(src.parms_id())
                                 ->parms()
                                 .coeff_modulus()
                                 .back()
                                 .value());
 
-    double temp_scale = other_ctxt.scale() / this_ctxt.scale() * last_prime;
+    double temp_scale = scale / src.scale() * last_prime;
     // create temporary plaintext
-    seal::Plaintext plaintext =
-        std::dynamic_pointer_cast<SEALPtxt>(
-            _context.encode(std::vector<double>{1.}, this_ctxt.parms_id(),
-                            temp_scale))
-            ->sealPlaintext();
-    _context._evaluator->multiply_plain_inplace(_internal_ctxt, plaintext);
+    std::shared_ptr<HEPtxt> one = _context.encode(
+        std::vector<double>{1.}, src.parms_id(), temp_scale);
+    _context._evaluator->multiply_plain(
+        src, std::dynamic_pointer_cast<SEALPtxt>(one)->sealPlaintext(), dst);
     count_ctxt_ptxt_mult();
-    _context._evaluator->relinearize_inplace(_internal_ctxt,
-                                             _context.relinKeys());
-    _context._evaluator->rescale_to_next_inplace(_internal_ctxt);
+    count_match_mult();
+    _context._evaluator->rescale_to_next_inplace(dst);
+    count_match_rescale();
+    current = &dst;
   }
   // check if the params id match now
-  if (seal_context.get_context_data(_internal_ctxt.parms_id())->chain_index() ==
-      seal_context.get_context_data(other_ctxt.parms_id())->chain_index()) {
+  if (seal_context.get_context_data(current->parms_id())->chain_index() ==
+      seal_context.get_context_data(parms_id)->chain_index()) {
+    if (current != &dst) {
+      dst = *current;
+    }
     return;
   }
-  _context._evaluator->mod_switch_to_inplace(_internal_ctxt,
-                                             other_ctxt.parms_id());
+  _context._evaluator->mod_switch_to(*current, parms_id, dst);
+  count_match_mod_switch();
+}
+
+std::shared_ptr<const seal::Ciphertext> SEALCtxt::lowered(
+    const SEALCtxt& other, const seal::Ciphertext& target,
+    bool match_scale) const {
+  const seal::Ciphertext& src = other.ciphertext();
+  auto target_data =
+      _context._internal_context.get_context_data(target.parms_id());
+  const size_t bytes = src.size() * src.poly_modulus_degree() *
+                       target_data->parms().coeff_modulus().size() *
+                       sizeof(seal::Ciphertext::ct_coeff_type);
+  return other._shared->levels.get(
+      target_data->chain_index(), match_scale ? target.scale() : src.scale(),
+      bytes, [&] {
+        auto version = std::make_shared<seal::Ciphertext>();
+        if (match_scale) {
+          match_to(src, target, *version);
+        } else {
+          _context._evaluator->mod_switch_to(src, target.parms_id(), *version);
+          count_match_mod_switch();
+        }
+        return std::shared_ptr<const seal::Ciphertext>(std::move(version));
+      });
 }
 
 std::shared_ptr<HECtxt> SEALCtxt::operator+(
     const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<SEALCtxt> other_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(other);
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + " + other_ctxt->name(), _content_type, _context);
+  record_level();
+  const std::shared_ptr<const SEALCtxt> other_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(other);
+  TraceSpan span = trace("add", other_ctxt.get());
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, *other_ctxt);
+  if (is_zero() || other_ctxt->is_zero()) {
+    // the sum is the other operand
+    const SEALCtxt& kept = other_ctxt->is_zero() ? *this : *other_ctxt;
+    std::shared_ptr<SEALCtxt> result =
+        kept.copy(_name + " + " + other_ctxt->name());
+    count_skipped_add();
+    captured.result(result.get());
+    return result;
+  }
+  std::shared_ptr<SEALCtxt> result =
+      new_result(_name + " + " + other_ctxt->name());
   try {
-    _context._evaluator->add(_internal_ctxt, other_ctxt->sealCiphertext(),
-                             result->sealCiphertext());
+    // pending operations can be carried over if both sides are in the same
+    // state. otherwise we need to apply them first
+    if (_needs_rescale == other_ctxt->_needs_rescale) {
+      _context._evaluator->add(ciphertext(), other_ctxt->sealCiphertext(),
+                               result->sealCiphertext());
+      result->_needs_relin = _needs_relin || other_ctxt->_needs_relin;
+      result->_needs_rescale = _needs_rescale;
+    } else {
+      seal::Ciphertext lhs_scratch, rhs_scratch;
+      _context._evaluator->add(flushed(lhs_scratch),
+                               other_ctxt->flushed(rhs_scratch),
+                               result->sealCiphertext());
+    }
     count_ctxt_ctxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, other_ctxt->sealCiphertext(),
+    logComputationError(ciphertext(), other_ctxt->sealCiphertext(),
                         "operator+(std::shared_ptr<HECtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
-  std::stringstream ss;
-  ss << "ctxt + ctxt this " << (void*)this << " other " << other << " result "
-     << result << std::endl;
+  BACKEND_LOG_DEBUG << "ctxt + ctxt this " << (void*)this << " other " << other
+                    << " result " << result << std::endl;
+  result->track_bytes();
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::addInPlace(const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<SEALCtxt> other_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(other);
+  record_level();
+  const std::shared_ptr<const SEALCtxt> other_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(other);
+  TraceSpan span = trace("add_inplace", other_ctxt.get());
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, *other_ctxt);
+  if (is_zero() || other_ctxt->is_zero()) {
+    if (is_zero()) {
+      take(*other_ctxt);
+    }
+    count_skipped_add();
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  // pending operations can only be carried along if both sides are in the
+  // same state. otherwise apply them before matching scales and levels
+  seal::Ciphertext rhs_scratch;
+  const seal::Ciphertext* rhs = &other_ctxt->sealCiphertext();
   try {
-    AS_LOG_DEBUG << "adding. lhs scale " << std::log2(_internal_ctxt.scale())
-                 << " rhs scale "
-                 << std::log2(other_ctxt->sealCiphertext().scale())
-                 << std::endl;
-    AS_LOG_DEBUG << "\t lhs params index: "
-                 << _context._internal_context
-                        .get_context_data(_internal_ctxt.parms_id())
-                        ->chain_index()
-                 << " \n\t rhs params index "
-                 << _context._internal_context
-                        .get_context_data(
-                            other_ctxt->sealCiphertext().parms_id())
-                        ->chain_index()
-                 << std::endl;
-    std::stringstream ss;
-    ss << " ctxt += ctxt  this " << static_cast<void*>(this) << " other "
-       << other << std::endl;
-    ss << "adding. lhs scale " << std::log2(_internal_ctxt.scale())
-       << " rhs scale " << std::log2(other_ctxt->sealCiphertext().scale())
-       << std::endl;
-    ss << "\t lhs params index: "
-       << _context._internal_context
-              .get_context_data(_internal_ctxt.parms_id())
-              ->chain_index()
-       << " \n\t rhs params index "
-       << _context._internal_context
-              .get_context_data(other_ctxt->sealCiphertext().parms_id())
-              ->chain_index()
-       << std::endl;
-    AS_LOG_DEBUG << ss.str();
+    bool rhs_needs_relin = other_ctxt->_needs_relin;
+    if (_needs_rescale != other_ctxt->_needs_rescale ||
+        ctxt.parms_id() != rhs->parms_id()) {
+      flush();
+      rhs = &other_ctxt->flushed(rhs_scratch);
+      rhs_needs_relin = false;
+    }
+    BACKEND_LOG_DEBUG
+        << " ctxt += ctxt  this " << static_cast<void*>(this) << " other "
+        << other << std::endl
+        << "adding. lhs scale " << std::log2(ctxt.scale())
+        << " rhs scale " << std::log2(rhs->scale()) << std::endl
+        << "\t lhs params index: "
+        << _context._internal_context.get_context_data(ctxt.parms_id())
+               ->chain_index()
+        << " \n\t rhs params index "
+        << _context._internal_context.get_context_data(rhs->parms_id())
+               ->chain_index()
+        << std::endl;
     // params id are mismatch we need to bring them to the same parameters
-    if (_internal_ctxt.parms_id() != other_ctxt->sealCiphertext().parms_id()) {
-      auto context_data_lhs = _context._internal_context.get_context_data(
-          _internal_ctxt.parms_id());
-      auto context_data_rhs = _context._internal_context.get_context_data(
-          other_ctxt->sealCiphertext().parms_id());
+    if (ctxt.parms_id() != rhs->parms_id()) {
+      auto context_data_lhs =
+          _context._internal_context.get_context_data(ctxt.parms_id());
+      auto context_data_rhs =
+          _context._internal_context.get_context_data(rhs->parms_id());
       // other has a higher modulus. need to scale it down
       if (context_data_lhs->chain_index() < context_data_rhs->chain_index()) {
-        std::stringstream ss;
-        ss << "parameters mismatch. rescaling other. scales lhs "
-           << _internal_ctxt.scale() << " lhs "
-           << other_ctxt->sealCiphertext().scale() << std::endl;
-        AS_LOG_DEBUG << ss.str();
-
-        auto rescaled_ctxt =
-            std::dynamic_pointer_cast<SEALCtxt>(other_ctxt->deepCopy());
-        rescaled_ctxt->match_scale_and_parms(*this);
-        ss << "after scale matching rhs " << _internal_ctxt.scale() << " lhs "
-           << rescaled_ctxt->sealCiphertext().scale()
-           << "\n\t lhs params index: "
-           << _context._internal_context
-                  .get_context_data(_internal_ctxt.parms_id())
-                  ->chain_index()
-           << " parms_id: [ ";
-        for (auto i : _internal_ctxt.parms_id()) {
-          ss << i << ", ";
+        BACKEND_LOG_DEBUG << "parameters mismatch. rescaling other. scales lhs "
+                          << ctxt.scale() << " lhs " << rhs->scale()
+                          << std::endl;
+
+        // the matched copy is written straight into a temporary unless
+        // `other` caches its lower level versions
+        seal::Ciphertext temporary;
+        std::shared_ptr<const seal::Ciphertext> cached;
+        if (rhs == &other_ctxt->ciphertext()) {
+          cached = lowered(*other_ctxt, ctxt, true);
+        } else {
+          match_to(*rhs, ctxt, temporary);
         }
-        ss << "] \n\t rhs params index "
-           << _context._internal_context
-                  .get_context_data(rescaled_ctxt->sealCiphertext().parms_id())
-                  ->chain_index()
-           << "parms_id: [ ";
-        for (auto i : rescaled_ctxt->sealCiphertext().parms_id()) {
-          ss << i << ", ";
+        const seal::Ciphertext& matched = cached ? *cached : temporary;
+        if (BACKEND_LOG_ENABLED(BACKEND_LOG_LEVEL_DEBUG)) {
+          std::stringstream ss;
+          ss << "after scale matching rhs " << ctxt.scale()
+             << " lhs " << matched.scale()
+             << "\n\t lhs params index: "
+             << _context._internal_context
+                    .get_context_data(ctxt.parms_id())
+                    ->chain_index()
+             << " parms_id: [ ";
+          for (auto i : ctxt.parms_id()) {
+            ss << i << ", ";
+          }
+          ss << "] \n\t rhs params index "
+             << _context._internal_context
+                    .get_context_data(matched.parms_id())
+                    ->chain_index()
+             << "parms_id: [ ";
+          for (auto i : matched.parms_id()) {
+            ss << i << ", ";
+          }
+          ss << "]" << std::endl;
+          BACKEND_LOG_DEBUG << ss.str();
         }
-        ss << "]" << std::endl;
 
-        AS_LOG_DEBUG << ss.str();
-
-        _context._evaluator->add_inplace(_internal_ctxt,
-                                         rescaled_ctxt->sealCiphertext());
+        _context._evaluator->add_inplace(ctxt, matched);
       } else {
         // this has a higher moduls
-        match_scale_and_parms(*other_ctxt);
-        _context._evaluator->add_inplace(_internal_ctxt,
-                                         other_ctxt->sealCiphertext());
+        match_to(ctxt, *rhs, ctxt);
+        _context._evaluator->add_inplace(ctxt, *rhs);
       }
     } else {
       // scales and everything match. just add
-      _context._evaluator->add_inplace(_internal_ctxt,
-                                       other_ctxt->sealCiphertext());
+      _context._evaluator->add_inplace(ctxt, *rhs);
     }
+    _needs_relin = _needs_relin || rhs_needs_relin;
     count_ctxt_ctxt_add();
   } catch (const std::exception& e) {
     std::cout << e.what() << std::endl;
-    logComputationError(_internal_ctxt, other_ctxt->sealCiphertext(),
+    logComputationError(ctxt, *rhs,
                         "addInplace(std::shared_ptr<HECtxt>)", __FILE__,
                         __LINE__, &e, &_context._internal_context);
     throw;
   }
+  track_bytes();
 }
 
 // subtraction
 std::shared_ptr<HECtxt> SEALCtxt::operator-(
     const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<SEALCtxt> other_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(other);
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " * " + other_ctxt->name(), _content_type, _context);
+  record_level();
+  const std::shared_ptr<const SEALCtxt> other_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(other);
+  TraceSpan span = trace("sub", other_ctxt.get());
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, *other_ctxt);
+  if (other_ctxt->is_zero()) {
+    std::shared_ptr<SEALCtxt> result = copy(_name + " - " + other_ctxt->name());
+    count_skipped_add();
+    captured.result(result.get());
+    return result;
+  }
+  if (is_zero()) {
+    // the difference is the negated other operand
+    std::shared_ptr<SEALCtxt> result =
+        other_ctxt->copy(_name + " - " + other_ctxt->name());
+    _context._evaluator->negate_inplace(result->mutable_ciphertext());
+    result->track_bytes();
+    count_skipped_add();
+    captured.result(result.get());
+    return result;
+  }
+  std::shared_ptr<SEALCtxt> result =
+      new_result(_name + " * " + other_ctxt->name());
   try {
-    _context._evaluator->sub(_internal_ctxt, other_ctxt->sealCiphertext(),
-                             result->sealCiphertext());
+    if (_needs_rescale == other_ctxt->_needs_rescale) {
+      _context._evaluator->sub(ciphertext(), other_ctxt->sealCiphertext(),
+                               result->sealCiphertext());
+      result->_needs_relin = _needs_relin || other_ctxt->_needs_relin;
+      result->_needs_rescale = _needs_rescale;
+    } else {
+      seal::Ciphertext lhs_scratch, rhs_scratch;
+      _context._evaluator->sub(flushed(lhs_scratch),
+                               other_ctxt->flushed(rhs_scratch),
+                               result->sealCiphertext());
+    }
     count_ctxt_ctxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, other_ctxt->sealCiphertext(),
+    logComputationError(ciphertext(), other_ctxt->sealCiphertext(),
                         "operator-(std::shared_ptr<HECtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
 
+  result->track_bytes();
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::subInPlace(const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<SEALCtxt> other_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(other);
+  record_level();
+  const std::shared_ptr<const SEALCtxt> other_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(other);
+  TraceSpan span = trace("sub_inplace", other_ctxt.get());
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, *other_ctxt);
+  if (other_ctxt->is_zero()) {
+    count_skipped_add();
+    return;
+  }
+  if (is_zero()) {
+    take(*other_ctxt);
+    _context._evaluator->negate_inplace(mutable_ciphertext());
+    track_bytes();
+    count_skipped_add();
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
   try {
-    _context._evaluator->sub_inplace(_internal_ctxt,
-                                     other_ctxt->sealCiphertext());
+    if (_needs_rescale == other_ctxt->_needs_rescale) {
+      _context._evaluator->sub_inplace(ctxt, other_ctxt->sealCiphertext());
+      _needs_relin = _needs_relin || other_ctxt->_needs_relin;
+    } else {
+      flush();
+      seal::Ciphertext rhs_scratch;
+      _context._evaluator->sub_inplace(ctxt, other_ctxt->flushed(rhs_scratch));
+    }
     count_ctxt_ctxt_add();
 
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, other_ctxt->sealCiphertext(),
+    logComputationError(ctxt, other_ctxt->sealCiphertext(),
                         "subInPlace(std::shared_ptr<HECtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
 // multiplication
 
 std::shared_ptr<HECtxt> SEALCtxt::operator*(
     const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<SEALCtxt> other_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(other);
+  record_level();
+  const std::shared_ptr<const SEALCtxt> other_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(other);
+  TraceSpan span = trace("mult", other_ctxt.get());
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, *other_ctxt);
+  if (is_zero() || other_ctxt->is_zero()) {
+    std::shared_ptr<SEALCtxt> result = copy(_name + " * " + other_ctxt->name());
+    result->become_zero(product_shape(*other_ctxt));
+    count_skipped_mult();
+    captured.result(result.get());
+    return result;
+  }
 
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " * " + other_ctxt->name(), _content_type, _context);
+  std::shared_ptr<SEALCtxt> result =
+      new_result(_name + " * " + other_ctxt->name());
   try {
-    _context._evaluator->multiply(_internal_ctxt, other_ctxt->sealCiphertext(),
-                                  result->sealCiphertext());
-    _context._evaluator->relinearize_inplace(result->sealCiphertext(),
-                                             _context.relinKeys());
-    _context._evaluator->rescale_to_next_inplace(result->sealCiphertext());
+    // multiplying requires size 2 inputs at the same scale
+    seal::Ciphertext lhs_scratch, rhs_scratch;
+    const seal::Ciphertext& lhs = flushed(lhs_scratch);
+    const seal::Ciphertext& rhs = other_ctxt->flushed(rhs_scratch);
+    {
+      PhaseTimer timer(PHASE::TENSOR_PRODUCT, timed_level(lhs));
+      _context._evaluator->multiply(lhs, rhs, result->sealCiphertext());
+    }
+    result->multiplied(true);
     count_ctxt_ctxt_mult();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, other_ctxt->sealCiphertext(),
+    logComputationError(ciphertext(), other_ctxt->sealCiphertext(),
                         "operatir*(std::shared_ptr<HECtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
+  result->track_bytes();
+  captured.result(result.get());
   return result;
 }
 
@@ -344,465 +832,687 @@ void mult_check(seal::Ciphertext& one, seal::Ciphertext& two,
                          ->total_coeff_modulus_bit_count();
 
   while (std::log2(one.scale() * two.scale()) > max_scale) {
-    std::stringstream ss;
-    ss << "rescaling from: " << one.scale() << " chain_index: "
-       << context.context().get_context_data(one.parms_id())->chain_index()
-       << std::endl;
-    AS_LOG_DEBUG << ss.str();
+    BACKEND_LOG_DEBUG
+        << "rescaling from: " << one.scale() << " chain_index: "
+        << context.context().get_context_data(one.parms_id())->chain_index()
+        << std::endl;
     context.evaluator().rescale_to_next_inplace(one);
     context.evaluator().rescale_to_next_inplace(two);
+    SEALCtxt::count_match_rescale();
+    SEALCtxt::count_match_rescale();
     max_scale = context.context()
                     .get_context_data(one.parms_id())
                     ->total_coeff_modulus_bit_count();
-    ss << "rescaled to: " << one.scale() << " chain_index: "
-       << context.context().get_context_data(one.parms_id())->chain_index()
-       << std::endl;
-    AS_LOG_DEBUG << ss.str();
+    BACKEND_LOG_DEBUG
+        << "rescaled to: " << one.scale() << " chain_index: "
+        << context.context().get_context_data(one.parms_id())->chain_index()
+        << std::endl;
   }
 }
 
 void SEALCtxt::multInPlace(const std::shared_ptr<HECtxt> other) {
-  const std::shared_ptr<SEALCtxt> other_ctxt =
-      std::dynamic_pointer_cast<SEALCtxt>(other);
+  record_level();
+  const std::shared_ptr<const SEALCtxt> other_ctxt =
+      std::dynamic_pointer_cast<const SEALCtxt>(other);
+  TraceSpan span = trace("mult_inplace", other_ctxt.get());
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, *other_ctxt);
+  if (is_zero() || other_ctxt->is_zero()) {
+    become_zero(product_shape(*other_ctxt));
+    count_skipped_mult();
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
   try {
-    std::stringstream ss;
-    ss << "ctxt *= ctxt this " << (void*)this << " other " << other
-       << std::endl;
-    AS_LOG_DEBUG << ss.str();
-    auto& lhs_parms = _internal_ctxt.parms_id();
-    auto& rhs_parms = other_ctxt->sealCiphertext().parms_id();
+    BACKEND_LOG_DEBUG << "ctxt *= ctxt this " << (void*)this << " other "
+                      << other << std::endl;
+    flush();
+    seal::Ciphertext rhs_scratch;
+    const seal::Ciphertext& rhs = other_ctxt->flushed(rhs_scratch);
+    auto& lhs_parms = ctxt.parms_id();
+    auto& rhs_parms = rhs.parms_id();
+    const seal::Ciphertext* operand = &rhs;
+    // only the primes of the lower level are written
+    seal::Ciphertext switched;
+    std::shared_ptr<const seal::Ciphertext> cached;
     if (lhs_parms != rhs_parms) {
-      seal::Ciphertext ctxt;
+      PhaseTimer timer(PHASE::MATCH_SCALE, timed_level(ctxt));
       auto& s_context = _context._internal_context;
       // mod switch this
       if (s_context.get_context_data(lhs_parms)->chain_index() >
           s_context.get_context_data(rhs_parms)->chain_index()) {
-        AS_LOG_DEBUG << "modswitching `this` from " +
-                            std::to_string(_internal_ctxt.scale())
-                     << std::endl;
-        _context._evaluator->mod_switch_to_inplace(_internal_ctxt, rhs_parms);
-        AS_LOG_DEBUG << "modswitched `this` to " +
-                            std::to_string(_internal_ctxt.scale())
-                     << std::endl;
-        _context._evaluator->multiply_inplace(_internal_ctxt,
-                                              other_ctxt->sealCiphertext());
+        BACKEND_LOG_DEBUG << "modswitching `this` from "
+                          << std::to_string(ctxt.scale()) << std::endl;
+        _context._evaluator->mod_switch_to_inplace(ctxt, rhs_parms);
+        count_match_mod_switch();
+        BACKEND_LOG_DEBUG << "modswitched `this` to "
+                          << std::to_string(ctxt.scale()) << std::endl;
       } else {  // mod switch other
-        ctxt = other_ctxt->sealCiphertext();
-        AS_LOG_DEBUG << "modswitching `other` from " +
-                            std::to_string(ctxt.scale())
-                     << std::endl;
-        _context._evaluator->mod_switch_to_inplace(ctxt, lhs_parms);
-        AS_LOG_DEBUG << "modswitching `other` to " +
-                            std::to_string(ctxt.scale())
-                     << std::endl;
-        _context._evaluator->multiply_inplace(_internal_ctxt, ctxt);
+        BACKEND_LOG_DEBUG << "modswitching `other` from "
+                          << std::to_string(rhs.scale()) << std::endl;
+        if (&rhs == &other_ctxt->ciphertext()) {
+          cached = lowered(*other_ctxt, ctxt, false);
+          operand = cached.get();
+        } else {
+          _context._evaluator->mod_switch_to(rhs, lhs_parms, switched);
+          count_match_mod_switch();
+          operand = &switched;
+        }
+        BACKEND_LOG_DEBUG << "modswitching `other` to "
+                          << std::to_string(operand->scale()) << std::endl;
       }
-    } else {
-      _context._evaluator->multiply_inplace(_internal_ctxt,
-                                            other_ctxt->sealCiphertext());
     }
-    _context._evaluator->relinearize_inplace(_internal_ctxt,
-                                             _context.relinKeys());
-    _context._evaluator->rescale_to_next_inplace(_internal_ctxt);
+    {
+      PhaseTimer timer(PHASE::TENSOR_PRODUCT, timed_level(ctxt));
+      _context._evaluator->multiply_inplace(ctxt, *operand);
+    }
+    multiplied(true);
     count_ctxt_ctxt_mult();
 
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, other_ctxt->sealCiphertext(),
+    logComputationError(ctxt, other_ctxt->sealCiphertext(),
                         "multInPlace(std::shared_ptr<HECtxt>)", __FILE__,
                         __LINE__, &e, &_context._internal_context);
     throw;
   }
+  track_bytes();
 }
 
 // ctxt and plain
 
 // addition
 std::shared_ptr<HECtxt> SEALCtxt::operator+(std::shared_ptr<HEPtxt> other) {
+  record_level();
+  TraceSpan span = trace("add_plain");
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, other);
   std::shared_ptr<SEALPtxt> ptxt = std::dynamic_pointer_cast<SEALPtxt>(other);
 
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + plaintext", _content_type, _context);
-  SEALPtxt rescaled = ptxt->scaleToMatch(*this);
+  std::shared_ptr<SEALCtxt> result = new_result(_name + " + plaintext");
+  std::shared_ptr<const seal::Plaintext> rescaled = ptxt->encodedToMatch(*this);
   try {
-    _context._evaluator->add_plain(_internal_ctxt, rescaled.sealPlaintext(),
+    _context._evaluator->add_plain(ciphertext(), *rescaled,
                                    result->sealCiphertext());
+    result->_needs_relin = _needs_relin;
+    result->_needs_rescale = _needs_rescale;
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, rescaled.sealPlaintext(),
+    logComputationError(ciphertext(), *rescaled,
                         "opertator+(std::shared_ptr<HEPtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
-  std::stringstream ss;
-  ss << "ctxt + ptxt this " << (void*)this << " result " << result << std::endl;
-  AS_LOG_DEBUG << ss.str();
+  BACKEND_LOG_DEBUG << "ctxt + ptxt this " << (void*)this << " result "
+                    << result << std::endl;
+  result->track_bytes();
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::addInPlace(std::shared_ptr<HEPtxt> other) {
+  record_level();
+  TraceSpan span = trace("add_plain_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, other);
+  seal::Ciphertext& ctxt = mutable_ciphertext();
   std::shared_ptr<SEALPtxt> ptxt = std::dynamic_pointer_cast<SEALPtxt>(other);
-  SEALPtxt rescaled = ptxt->scaleToMatch(*this);
+  std::shared_ptr<const seal::Plaintext> rescaled = ptxt->encodedToMatch(*this);
 
-  std::stringstream ss;
-  ss << "ctxt += ptxt this " << (void*)this << std::endl;
-  AS_LOG_DEBUG << ss.str();
+  BACKEND_LOG_DEBUG << "ctxt += ptxt this " << (void*)this << std::endl;
   try {
-    _context._evaluator->add_plain_inplace(_internal_ctxt,
-                                           rescaled.sealPlaintext());
+    _context._evaluator->add_plain_inplace(ctxt, *rescaled);
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
     double scale_factor = std::max<double>(
-        {std::fabs(_internal_ctxt.scale()),
-         std::fabs(rescaled.sealPlaintext().scale()), double{1.0}});
-    bool are_close =
-        std::fabs(_internal_ctxt.scale() - rescaled.sealPlaintext().scale()) <
-        epsilon<double> * scale_factor;
+        {std::fabs(ctxt.scale()), std::fabs(rescaled->scale()), double{1.0}});
+    bool are_close = std::fabs(ctxt.scale() - rescaled->scale()) <
+                     epsilon<double> * scale_factor;
     BACKEND_LOG << "scales equal: "
-                << std::to_string(_internal_ctxt.scale() ==
-                                  rescaled.sealPlaintext().scale())
+                << std::to_string(ctxt.scale() == rescaled->scale())
                 << " scale difference: "
-                << std::to_string(std::fabs(_internal_ctxt.scale() -
-                                            rescaled.sealPlaintext().scale()))
+                << std::to_string(std::fabs(ctxt.scale() - rescaled->scale()))
                 << " are close: " << are_close << std::endl;
-    logComputationError(_internal_ctxt, rescaled.sealPlaintext(),
+    logComputationError(ctxt, *rescaled,
                         "addInPlace(std::shared_ptr<HEPtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
 // subtraction
 std::shared_ptr<HECtxt> SEALCtxt::operator-(std::shared_ptr<HEPtxt> other) {
+  record_level();
+  TraceSpan span = trace("sub_plain");
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, other);
   const std::shared_ptr<SEALPtxt> ptxt =
       std::dynamic_pointer_cast<SEALPtxt>(other);
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + plaintext", _content_type, _context);
-  SEALPtxt rescaled = ptxt->scaleToMatch(*this);
+  std::shared_ptr<SEALCtxt> result = new_result(_name + " + plaintext");
+  std::shared_ptr<const seal::Plaintext> rescaled = ptxt->encodedToMatch(*this);
   try {
-    _context._evaluator->sub_plain(_internal_ctxt, rescaled.sealPlaintext(),
+    _context._evaluator->sub_plain(ciphertext(), *rescaled,
                                    result->sealCiphertext());
+    result->_needs_relin = _needs_relin;
+    result->_needs_rescale = _needs_rescale;
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, rescaled.sealPlaintext(),
+    logComputationError(ciphertext(), *rescaled,
                         "operator-(std::shared_ptr<HEPtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
+  result->track_bytes();
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::subInPlace(std::shared_ptr<HEPtxt> other) {
+  record_level();
+  TraceSpan span = trace("sub_plain_inplace");
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, other);
+  seal::Ciphertext& ctxt = mutable_ciphertext();
   const std::shared_ptr<SEALPtxt> ptxt =
       std::dynamic_pointer_cast<SEALPtxt>(other);
-  SEALPtxt rescaled = ptxt->rescale(_internal_ctxt.scale());
+  std::shared_ptr<const seal::Plaintext> rescaled = ptxt->encodedToMatch(*this);
   try {
-    _context._evaluator->sub_plain_inplace(_internal_ctxt,
-                                           rescaled.sealPlaintext());
+    _context._evaluator->sub_plain_inplace(ctxt, *rescaled);
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, rescaled.sealPlaintext(),
+    logComputationError(ctxt, *rescaled,
                         "subInplace-(std::shared_ptr<HEPtxt>)", __FILE__,
                         __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
 // multiplication
 std::shared_ptr<HECtxt> SEALCtxt::operator*(std::shared_ptr<HEPtxt> other) {
+  record_level();
+  TraceSpan span = trace("mult_plain");
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, other);
   std::shared_ptr<SEALPtxt> ptxt = std::dynamic_pointer_cast<SEALPtxt>(other);
-  // if (ptxt->isAllZero()) {
-  //   // if we multiplied here the scale would the ciphertext scale *
-  //   plainscale
-  //   // butt since we specifically rescale the plaintext to be the same
-  //   scale
-  //   // as the ciphertext we can just square the scale and for rescaling the
-  //   // the plaintext before encryption
-  //   // TODO: be smarter about the scale. we should really look at the scale
-  //   and
-  //   // what the next scale down would lead to and use that scale during
-  //   encoding BACKEND_LOG << "circumventing transparent ciphertext" <<
-  //   std::endl; SEALPtxt temp = ptxt->rescale(
-  //       this->_internal_ctxt.scale() * this->_internal_ctxt.scale(),
-  //       _internal_ctxt.parms_id());
-  //   std::shared_ptr<SEALCtxt> res =
-  //   static_cast<std::shared_ptr<SEALCtxt((_context.encrypt(&temp));
-  //   res->_name = _name + " * plaintext";
-  //   _context._evaluator->relinearize_inplace(res->sealCiphertext(),
-  //                                            _context.relinKeys());
-  //   _context._evaluator->rescale_to_next_inplace(res->sealCiphertext());
-  //   return res;
-  // }
-
-  // TODO: shortcut evalution for special case 1
-  ptxt->mutex.lock();
-  if (!are_close(_internal_ctxt.scale(), ptxt->sealPlaintext().scale())) {
-    ptxt->scaleToMatchInPlace(*this);
-  }
-  ptxt->mutex.unlock();
+  // masks, padding and pruned weights. the result has the level and scale
+  // of the product, a product with zeros is a zero
+  if (ptxt->isAllZero() || is_zero()) {
+    std::shared_ptr<SEALCtxt> result = copy(_name + " * plaintext");
+    result->become_zero(plain_product_shape());
+    count_skipped_mult();
+    captured.result(result.get());
+    return result;
+  }
+  if (ptxt->isAllOne()) {
+    std::shared_ptr<SEALCtxt> result = copy(_name + " * plaintext");
+    if (result->multiply_by_one()) {
+      count_skipped_mult();
+      captured.result(result.get());
+      return result;
+    }
+  }
+
+  // a pending rescale needs to happen before the plaintext multiplication. a
+  // pending relinearization can stay pending
+  seal::Ciphertext lhs_scratch;
+  const seal::Ciphertext* lhs = &ciphertext();
+  if (_needs_rescale) {
+    PhaseTimer timer(PHASE::RESCALE, timed_level(ciphertext()));
+    _context._evaluator->rescale_to_next(ciphertext(), lhs_scratch);
+    _context.scalePlan().snap(lhs_scratch, chain_index(lhs_scratch));
+    lhs = &lhs_scratch;
+  }
+  // encoded so that the rescaled product has the planned scale
+  std::shared_ptr<const seal::Plaintext> encoded = ptxt->encoded(
+      _context.scalePlan().plain_scale(chain_index(*lhs), lhs->scale()),
+      lhs->parms_id());
   BACKEND_LOG << "creating result ctxt" << std::endl;
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " * plaintext", _content_type, _context);
+  std::shared_ptr<SEALCtxt> result = new_result(_name + " * plaintext");
   try {
     BACKEND_LOG << "running multiplication" << std::endl;
-    _context._evaluator->multiply_plain(_internal_ctxt, ptxt->sealPlaintext(),
-                                        result->sealCiphertext());
-    BACKEND_LOG << "running relin" << std::endl;
-    _context._evaluator->relinearize_inplace(result->sealCiphertext(),
-                                             _context.relinKeys());
-    BACKEND_LOG << "running rescale" << std::endl;
-    _context._evaluator->rescale_to_next_inplace(result->sealCiphertext());
+    {
+      PhaseTimer timer(PHASE::PLAIN_PRODUCT, timed_level(*lhs));
+      _context._evaluator->multiply_plain(*lhs, *encoded,
+                                          result->sealCiphertext());
+    }
+    BACKEND_LOG << "running relin and rescale" << std::endl;
+    result->_needs_relin = _needs_relin;
+    result->multiplied(false);
     count_ctxt_ptxt_mult();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "operator*(std::shared_ptr<HEPtxt>)", __FILE__,
-                        __LINE__, &e);
+    logComputationError(*lhs, *encoded, "operator*(std::shared_ptr<HEPtxt>)",
+                        __FILE__, __LINE__, &e);
     throw;
   }
 
   BACKEND_LOG << "mutlplication done" << std::endl;
-  std::stringstream ss;
-  ss << "ctxt * ptxt this: " << (void*)this << " result " << result
-     << std::endl;
-  AS_LOG_DEBUG << ss.str();
+  BACKEND_LOG_DEBUG << "ctxt * ptxt this: " << (void*)this << " result "
+                    << result << std::endl;
+  result->track_bytes();
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::multInPlace(std::shared_ptr<HEPtxt> other) {
+  record_level();
+  TraceSpan span = trace("mult_plain_inplace");
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, other);
   const std::shared_ptr<SEALPtxt> ptxt =
       std::dynamic_pointer_cast<SEALPtxt>(other);
-  // if (ptxt->isAllZero()) {
-  //   // if we multiplied here the scale would the ciphertext scale *
-  //   plainscale
-  //   // butt since we specifically rescale the plaintext to be the same scale
-  //   // as the ciphertext we can just square the scale and for rescaling the
-  //   // the plaintext before encryption
-  //   // TODO: same as operator*(std::shared_ptr<HEPtxt>). use the proper scale
-  //   // during encoding
-  //   std::shared_ptr<SEALPtxt> temp = std::make_shared<SEALPtxt>(
-  //       std::move(ptxt->rescale(std::log2(this->_internal_ctxt.scale() *
-  //                                         this->_internal_ctxt.scale()),
-  //                               _internal_ctxt.parms_id())));
-
-  //   std::shared_ptr<SEALCtxt> res =
-  //       std::dynamic_pointer_cast<SEALCtxt>(_context.encrypt(temp));
-  //   res->_name = _name + " * plaintext";
-  //   _internal_ctxt = res->sealCiphertext();
-  //   _context._evaluator->relinearize_inplace(_internal_ctxt,
-  //                                            _context.relinKeys());
-  //   _context._evaluator->rescale_to_next_inplace(_internal_ctxt);
-  // }
-
-  SEALPtxt rescaled = ptxt->scaleToMatch(*this);
+  // see operator*(std::shared_ptr<HEPtxt>)
+  if (ptxt->isAllZero() || is_zero()) {
+    become_zero(plain_product_shape());
+    count_skipped_mult();
+    return;
+  }
+  if (ptxt->isAllOne() && multiply_by_one()) {
+    count_skipped_mult();
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  rescale();
+  // encoded so that the rescaled product has the planned scale
+  std::shared_ptr<const seal::Plaintext> rescaled = ptxt->encoded(
+      _context.scalePlan().plain_scale(chain_index(ctxt), ctxt.scale()),
+      ctxt.parms_id());
   try {
-    _context._evaluator->multiply_plain_inplace(_internal_ctxt,
-                                                rescaled.sealPlaintext());
-    _context._evaluator->relinearize_inplace(_internal_ctxt,
-                                             _context.relinKeys());
-    _context._evaluator->rescale_to_next_inplace(_internal_ctxt);
-    std::stringstream ss;
-
-    ss << "ctxt *= ptxt. this: " << (void*)this << "\n\tresult scale "
-       << std::log2(_internal_ctxt.scale()) << std::endl;
-    ss << "\t params index: "
-       << _context._internal_context
-              .get_context_data(_internal_ctxt.parms_id())
-              ->chain_index()
-       << std::endl;
-    AS_LOG_DEBUG << ss.str();
+    {
+      PhaseTimer timer(PHASE::PLAIN_PRODUCT, timed_level(ctxt));
+      _context._evaluator->multiply_plain_inplace(ctxt, *rescaled);
+    }
+    multiplied(false);
+    BACKEND_LOG_DEBUG << "ctxt *= ptxt. this: " << (void*)this
+                      << "\n\tresult scale "
+                      << std::log2(ctxt.scale()) << std::endl
+                      << "\t params index: "
+                      << _context._internal_context
+                             .get_context_data(ctxt.parms_id())
+                             ->chain_index()
+                      << std::endl;
     count_ctxt_ptxt_mult();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, rescaled.sealPlaintext(),
+    logComputationError(ctxt, *rescaled,
                         "multInPlace(std::shared_ptr<HEPtxt>)", __FILE__,
                         __LINE__, &e, &_context._internal_context);
     throw;
   }
+  track_bytes();
 }
 
 // scalar ops
 
-std::shared_ptr<HECtxt> SEALCtxt::operator*(long other) {
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " * " + std::to_string(other), _content_type, _context);
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
-  result->multInPlace(ptxt);
-  count_ctxt_ptxt_mult();
+// scalars are never encoded into full plaintexts. additions write the scaled
+// constant into the ciphertext directly and integer multiplications multiply
+// the coefficients without consuming a level. none of them requires pending
+// operations to be performed first.
+
+std::shared_ptr<SEALCtxt> SEALCtxt::copy(const std::string& name) const {
+  // shares the ciphertext until one of them is modified
+  std::shared_ptr<SEALCtxt> result(new SEALCtxt(*this));
+  result->_name = name;
   return result;
 }
 
-void SEALCtxt::multInPlace(long other) {
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
-  multInPlace(ptxt);
-  count_ctxt_ptxt_mult();
+std::shared_ptr<SEALCtxt> SEALCtxt::new_result(const std::string& name,
+                                               size_t size) const {
+  return std::make_shared<SEALCtxt>(
+      CiphertextFreelist::acquire(size == 0 ? ciphertext().size() : size,
+                                  ciphertext().coeff_modulus_size()),
+      name, _content_type, _context);
 }
 
-std::shared_ptr<HECtxt> SEALCtxt::operator*(double other) {
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " * " + std::to_string(other), _content_type, _context);
-  std::vector<double> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
-  result->multInPlace(ptxt);
-  count_ctxt_ptxt_mult();
-  return result;
+void SEALCtxt::add_scalar_inplace(long value) {
+  if (value == 0) {
+    return;
+  }
+  if (_context.is_ckks()) {
+    add_scalar_inplace(static_cast<double>(value));
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  // a constant slot vector is a constant polynomial. SEAL takes care of the
+  // scaling by q/t
+  const seal::Modulus& plain_modulus =
+      _context._internal_context.first_context_data()->parms().plain_modulus();
+  seal::Plaintext ptxt(1);
+  ptxt[0] = reduce_signed(value, plain_modulus);
+  _context._evaluator->add_plain_inplace(ctxt, ptxt);
 }
 
-void SEALCtxt::multInPlace(double other) {
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
-  multInPlace(ptxt);
+void SEALCtxt::add_scalar_inplace(double value) {
+  if (value == 0) {
+    return;
+  }
+  if (!_context.is_ckks()) {
+    add_scalar_inplace(static_cast<long>(value));
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  // a constant slot vector encodes to the constant polynomial round(value *
+  // scale). in NTT form that constant is added to every coefficient of c0
+  double scaled = std::round(value * ctxt.scale());
+  if (std::fabs(scaled) >= 0x1p63) {
+    // does not fit into 64 bits. the encoder handles the multi precision case
+    seal::Plaintext ptxt;
+    _context._ckksencoder->encode(value, ctxt.parms_id(), ctxt.scale(), ptxt);
+    _context._evaluator->add_plain_inplace(ctxt, ptxt);
+    return;
+  }
+  const int64_t constant = static_cast<int64_t>(scaled);
+  const auto& coeff_modulus =
+      _context._internal_context.get_context_data(ctxt.parms_id())
+          ->parms()
+          .coeff_modulus();
+  const size_t n = ctxt.poly_modulus_degree();
+  for (size_t i = 0; i < coeff_modulus.size(); ++i) {
+    seal::util::CoeffIter c0(ctxt.data(0) + i * n);
+    seal::util::add_poly_scalar_coeffmod(
+        c0, n, reduce_signed(constant, coeff_modulus[i]), coeff_modulus[i],
+        c0);
+  }
 }
 
-std::shared_ptr<HECtxt> SEALCtxt::operator-(long other) {
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + " + std::to_string(other), _content_type, _context);
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
+void SEALCtxt::multiply_scalar_inplace(long value) {
+  if (value == 1 || is_zero()) {
+    count_skipped_mult();
+    return;
+  }
+  if (value == 0) {
+    become_zero(flushed_shape());
+    count_skipped_mult();
+    return;
+  }
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  // multiplying every coefficient with an integer leaves scale and level
+  // untouched. works for both schemes and for ciphertexts of any size
+  PhaseTimer timer(PHASE::PLAIN_PRODUCT, timed_level(ctxt));
+  multiply_coefficients(ctxt, value, _context._internal_context);
+}
+
+void SEALCtxt::multiply_scalar_inplace(double value) {
+  if (!_context.is_ckks() ||
+      (std::nearbyint(value) == value && std::fabs(value) < 0x1p62)) {
+    multiply_scalar_inplace(static_cast<long>(value));
+    return;
+  }
+  if (is_zero()) {
+    become_zero(plain_product_shape());
+    count_skipped_mult();
+    return;
+  }
+  rescale();
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  // the constant is encoded at the level of the ciphertext and the scale that
+  // puts the rescaled product on the planned scale. constants are shared
+  // through the plaintext cache
+  const std::vector<double> values{value};
+  const double scale =
+      _context.scalePlan().plain_scale(chain_index(ctxt), ctxt.scale());
+  const seal::parms_id_type parms_id = ctxt.parms_id();
+  std::shared_ptr<const seal::Plaintext> constant =
+      _context.plaintextCache().get(
+          values, PlaintextCache::hash(values), parms_id, scale,
+          [&](seal::Plaintext& ptxt) {
+            _context._ckksencoder->encode(value, parms_id, scale, ptxt);
+          });
+  {
+    PhaseTimer timer(PHASE::PLAIN_PRODUCT, timed_level(ctxt));
+    _context._evaluator->multiply_plain_inplace(ctxt, *constant);
+  }
+  multiplied(false);
+}
+
+std::shared_ptr<HECtxt> SEALCtxt::operator*(long other) {
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, other);
+  std::shared_ptr<SEALCtxt> result =
+      copy(_name + " * " + std::to_string(other));
+  result->multInPlace(other);
+  captured.result(result.get());
+  return result;
+}
+
+void SEALCtxt::multInPlace(long other) {
+  record_level();
+  TraceSpan span = trace("mult_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, other);
   try {
-    _context._evaluator->sub_plain(_internal_ctxt, ptxt->sealPlaintext(),
-                                   result->sealCiphertext());
-    count_ctxt_ptxt_add();
+    multiply_scalar_inplace(other);
+    count_ctxt_ptxt_mult();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "operator-(long)", __FILE__, __LINE__, &e);
+    logComputationError(ciphertext(), seal::Plaintext(), "multInPlace(long)",
+                        __FILE__, __LINE__, &e);
     throw;
   }
+  track_bytes();
+}
 
+std::shared_ptr<HECtxt> SEALCtxt::operator*(double other) {
+  OpCapture captured = capture(CAPTURE_OP::MULT, false, other);
+  std::shared_ptr<SEALCtxt> result =
+      copy(_name + " * " + std::to_string(other));
+  result->multInPlace(other);
+  captured.result(result.get());
   return result;
 }
 
-void SEALCtxt::subInPlace(long other) {
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
+void SEALCtxt::multInPlace(double other) {
+  record_level();
+  TraceSpan span = trace("mult_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::MULT, true, other);
   try {
-    _context._evaluator->sub_plain_inplace(_internal_ctxt,
-                                           ptxt->sealPlaintext());
-    count_ctxt_ptxt_add();
+    multiply_scalar_inplace(other);
+    count_ctxt_ptxt_mult();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "subInPlace(long)", __FILE__, __LINE__, &e);
+    logComputationError(ciphertext(), seal::Plaintext(),
+                        "multInPlace(double)", __FILE__, __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
-std::shared_ptr<HECtxt> SEALCtxt::operator-(double other) {
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + " + std::to_string(other), _content_type, _context);
-  std::vector<double> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
+std::shared_ptr<HECtxt> SEALCtxt::operator-(long other) {
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, other);
+  std::shared_ptr<SEALCtxt> result =
+      copy(_name + " - " + std::to_string(other));
+  result->subInPlace(other);
+  captured.result(result.get());
+  return result;
+}
+
+void SEALCtxt::subInPlace(long other) {
+  record_level();
+  TraceSpan span = trace("sub_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, other);
   try {
-    _context._evaluator->sub_plain(_internal_ctxt, ptxt->sealPlaintext(),
-                                   result->sealCiphertext());
+    add_scalar_inplace(-other);
     count_ctxt_ptxt_add();
-
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "operator-(double)", __FILE__, __LINE__, &e);
+    logComputationError(ciphertext(), seal::Plaintext(), "subInPlace(long)",
+                        __FILE__, __LINE__, &e);
     throw;
   }
+  track_bytes();
+}
 
+std::shared_ptr<HECtxt> SEALCtxt::operator-(double other) {
+  OpCapture captured = capture(CAPTURE_OP::SUB, false, other);
+  std::shared_ptr<SEALCtxt> result =
+      copy(_name + " - " + std::to_string(other));
+  result->subInPlace(other);
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::subInPlace(double other) {
-  std::vector<double> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
+  record_level();
+  TraceSpan span = trace("sub_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::SUB, true, other);
   try {
-    _context._evaluator->sub_plain_inplace(_internal_ctxt,
-                                           ptxt->sealPlaintext());
+    add_scalar_inplace(-other);
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "subInPlace(double)", __FILE__, __LINE__, &e);
+    logComputationError(ciphertext(), seal::Plaintext(), "subInPlace(double)",
+                        __FILE__, __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
 std::shared_ptr<HECtxt> SEALCtxt::operator+(long other) {
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + " + std::to_string(other), _content_type, _context);
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
-  try {
-    _context._evaluator->add_plain(_internal_ctxt, ptxt->sealPlaintext(),
-                                   result->sealCiphertext());
-    count_ctxt_ptxt_add();
-  } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "opertator+(long)", __FILE__, __LINE__, &e);
-    throw;
-  }
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, other);
+  std::shared_ptr<SEALCtxt> result =
+      copy(_name + " + " + std::to_string(other));
+  result->addInPlace(other);
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::addInPlace(long other) {
-  std::vector<long> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
+  record_level();
+  TraceSpan span = trace("add_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, other);
   try {
-    _context._evaluator->add_plain_inplace(_internal_ctxt,
-                                           ptxt->sealPlaintext());
+    add_scalar_inplace(other);
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "addInPlace(long)", __FILE__, __LINE__, &e);
+    logComputationError(ciphertext(), seal::Plaintext(), "addInPlace(long)",
+                        __FILE__, __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
 std::shared_ptr<HECtxt> SEALCtxt::operator+(double other) {
-  std::shared_ptr<SEALCtxt> result = std::make_shared<SEALCtxt>(
-      _name + " + " + std::to_string(other), _content_type, _context);
-  std::vector<double> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
-  try {
-    _context._evaluator->add_plain(_internal_ctxt, ptxt->sealPlaintext(),
-                                   result->sealCiphertext());
-    count_ctxt_ptxt_add();
-  } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "operator+(double)", __FILE__, __LINE__, &e);
-    throw;
-  }
+  OpCapture captured = capture(CAPTURE_OP::ADD, false, other);
+  std::shared_ptr<SEALCtxt> result =
+      copy(_name + " + " + std::to_string(other));
+  result->addInPlace(other);
+  captured.result(result.get());
   return result;
 }
 
 void SEALCtxt::addInPlace(double other) {
-  std::vector<double> vec(_context.numberOfSlots(), other);
-  std::shared_ptr<SEALPtxt> ptxt =
-      std::dynamic_pointer_cast<SEALPtxt>(_context.encode(vec));
+  record_level();
+  TraceSpan span = trace("add_scalar_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ADD, true, other);
   try {
-    _context._evaluator->add_plain_inplace(_internal_ctxt,
-                                           ptxt->sealPlaintext());
+    add_scalar_inplace(other);
     count_ctxt_ptxt_add();
   } catch (const std::exception& e) {
-    logComputationError(_internal_ctxt, ptxt->sealPlaintext(),
-                        "addInPlace(double)", __FILE__, __LINE__, &e);
+    logComputationError(ciphertext(), seal::Plaintext(), "addInPlace(double)",
+                        __FILE__, __LINE__, &e);
     throw;
   }
+  track_bytes();
 }
 
 // Rotation
 void SEALCtxt::rotInPlace(int steps) {
-  _context._evaluator->rotate_vector_inplace(_internal_ctxt, steps,
-                                             _context._gal_keys);
+  record_level();
+  TraceSpan span = trace("rotate_inplace");
+  OpCapture captured = capture(CAPTURE_OP::ROTATE, true);
+  captured.steps(steps);
+  seal::Ciphertext& ctxt = mutable_ciphertext();
+  // rotations commute with rescaling. only the relinearization is needed
+  relinearize();
+  PhaseTimer timer(PHASE::ROTATE, timed_level(ctxt));
+  for (int step : _context.rotationPlan(steps)) {
+    _context._evaluator->rotate_vector_inplace(ctxt, step, _context._gal_keys);
+  }
   count_ctxt_rot();
+  track_bytes();
 }
 
 std::shared_ptr<HECtxt> SEALCtxt::rotate(int steps) {
-  std::shared_ptr<HECtxt> copy = this->deepCopy();
-  copy->rotInPlace(steps);
-  return copy;
+  record_level();
+  TraceSpan span = trace("rotate");
+  OpCapture captured = capture(CAPTURE_OP::ROTATE, false);
+  captured.steps(steps);
+  // the first rotation writes straight into the result instead of rotating a
+  // copy of this
+  seal::Ciphertext scratch;
+  const seal::Ciphertext* source = &ciphertext();
+  if (_needs_relin) {
+    PhaseTimer timer(PHASE::RELINEARIZE, timed_level(ciphertext()));
+    _context._evaluator->relinearize(ciphertext(), _context.relinKeys(),
+                                     scratch);
+    source = &scratch;
+  }
+  std::shared_ptr<SEALCtxt> result =
+      new_result(_name + " rotated " + std::to_string(steps), source->size());
+  result->_needs_rescale = _needs_rescale;
+  try {
+    PhaseTimer timer(PHASE::ROTATE, timed_level(*source));
+    std::vector<int> plan = _context.rotationPlan(steps);
+    seal::Ciphertext& dst = result->sealCiphertext();
+    if (plan.empty()) {
+      dst = *source;
+    } else {
+      _context._evaluator->rotate_vector(*source, plan[0], _context._gal_keys,
+                                         dst);
+      for (size_t i = 1; i < plan.size(); ++i) {
+        _context._evaluator->rotate_vector_inplace(dst, plan[i],
+                                                   _context._gal_keys);
+      }
+    }
+  } catch (const std::exception& e) {
+    logComputationError(*source, *source, "rotate", __FILE__, __LINE__, &e,
+                        &_context._internal_context);
+    throw;
+  }
+  count_ctxt_rot();
+  result->track_bytes();
+  captured.result(result.get());
+  return result;
+}
+
+std::vector<std::shared_ptr<HECtxt>> SEALCtxt::rotateMany(
+    const std::vector<int>& steps) {
+  TraceSpan span = trace("rotate_many");
+  std::vector<std::shared_ptr<HECtxt>> result;
+  result.reserve(steps.size());
+  // rotations need a relinearized ciphertext. a pending rescale is carried
+  // over to the results
+  seal::Ciphertext scratch;
+  const seal::Ciphertext* source = &ciphertext();
+  if (_needs_relin) {
+    PhaseTimer timer(PHASE::RELINEARIZE, timed_level(ciphertext()));
+    _context._evaluator->relinearize(ciphertext(), _context.relinKeys(),
+                                     scratch);
+    source = &scratch;
+  }
+  std::unique_ptr<HoistedRotator> rotator;
+  if (steps.size() > 1 &&
+      HoistedRotator::supported(_context._internal_context, *source)) {
+    rotator = std::make_unique<HoistedRotator>(_context._internal_context,
+                                               *source);
+  }
+  for (int step : steps) {
+    record_level();
+    OpCapture captured = capture(CAPTURE_OP::ROTATE, false);
+    captured.steps(step);
+    std::shared_ptr<SEALCtxt> rotated =
+        new_result(_name + " rotated " + std::to_string(step));
+    rotated->_needs_rescale = _needs_rescale;
+    try {
+      PhaseTimer timer(PHASE::ROTATE, timed_level(*source));
+      std::vector<int> plan = _context.rotationPlan(step);
+      seal::Ciphertext& dst = rotated->sealCiphertext();
+      if (plan.size() != 1 || !rotator ||
+          !rotator->rotate(plan[0], _context._gal_keys, dst)) {
+        // no hoisting or the step needs to be composed from multiple keys
+        dst = *source;
+        for (int p : plan) {
+          _context._evaluator->rotate_vector_inplace(dst, p,
+                                                     _context._gal_keys);
+        }
+      }
+    } catch (const std::exception& e) {
+      logComputationError(*source, *source, "rotateMany", __FILE__, __LINE__,
+                          &e, &_context._internal_context);
+      throw;
+    }
+    count_ctxt_rot();
+    rotated->track_bytes();
+    captured.result(rotated.get());
+    result.push_back(rotated);
+  }
+  return result;
 }
 
 // static ressource looging code
@@ -820,6 +1530,19 @@ std::atomic_ulong SEALCtxt::add_ptxt_count = 0;
 
 std::atomic_ulong SEALCtxt::rot_count = 0;
 
+std::atomic_ulong SEALCtxt::match_mod_switch_count = 0;
+std::atomic_ulong SEALCtxt::match_rescale_count = 0;
+std::atomic_ulong SEALCtxt::match_mult_count = 0;
+std::atomic_ulong SEALCtxt::skipped_mult_count = 0;
+std::atomic_ulong SEALCtxt::skipped_add_count = 0;
+std::atomic_ulong SEALCtxt::zero_materialize_count = 0;
+
+std::atomic_ulong SEALCtxt::level_op_count[MONITORED_LEVELS] = {};
+
+std::atomic_long SEALCtxt::noise_budget_min = -1;
+std::atomic_long SEALCtxt::noise_budget_last = -1;
+std::atomic_ulong SEALCtxt::noise_budget_samples = 0;
+
 // resource logging
 void SEALCtxt::count_ctxt_ctxt_mult() {
   if (LIKELY_FALSE(count_ops)) {
@@ -851,4 +1574,63 @@ void SEALCtxt::count_ctxt_rot() {
   }
 }
 
+void SEALCtxt::count_match_mod_switch() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++match_mod_switch_count;
+  }
+}
+
+void SEALCtxt::count_match_rescale() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++match_rescale_count;
+  }
+}
+
+void SEALCtxt::count_match_mult() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++match_mult_count;
+  }
+}
+
+void SEALCtxt::count_skipped_mult() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++skipped_mult_count;
+  }
+}
+
+void SEALCtxt::count_skipped_add() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++skipped_add_count;
+  }
+}
+
+void SEALCtxt::count_zero_materialization() {
+  if (LIKELY_FALSE(count_ops)) {
+    ++zero_materialize_count;
+  }
+}
+
+void SEALCtxt::record_level() const {
+  if (LIKELY_FALSE(count_ops)) {
+    size_t level = chain_index(shape().first);
+    ++level_op_count[std::min(level, MONITORED_LEVELS - 1)];
+    // a zero has no noise. without the secret key (only the public keys were
+    // loaded) the budget can't be measured
+    if (!_context.is_ckks() && !is_zero() && _context._decryptor &&
+        noise_budget_interval > 0 &&
+        noise_budget_counter.fetch_add(1, std::memory_order_relaxed) %
+                noise_budget_interval ==
+            0) {
+      long budget =
+          _context._decryptor->invariant_noise_budget(ciphertext());
+      noise_budget_last = budget;
+      long current = noise_budget_min.load();
+      while ((current < 0 || budget < current) &&
+             !noise_budget_min.compare_exchange_weak(current, budget)) {
+      }
+      ++noise_budget_samples;
+    }
+  }
+}
+
 }  // namespace aluminum_shark
\ No newline at end of file
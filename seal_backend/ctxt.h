@@ -1,10 +1,18 @@
 #ifndef ALUMINUM_SHARK_SEAL_BACKEND_CTXT_H
 #define ALUMINUM_SHARK_SEAL_BACKEND_CTXT_H
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 
 #include "context.h"
+#include "ctxt_pool.h"
 #include "he_backend/he_backend.h"
+#include "level_cache.h"
+#include "op_capture.h"
+#include "op_trace.h"
 #include "seal/seal.h"
 
 namespace aluminum_shark {
@@ -15,6 +23,7 @@ class SEALCtxt : public HECtxt {
   // Plugin API
   virtual ~SEALCtxt() {
     count_ctxt(-1);
+    capture_release(this);
     // std::cout << "destroying " << _name
     //           << " pool references: " << _internal_ctxt.pool().use_count()
     //           << std::endl;
@@ -30,7 +39,7 @@ class SEALCtxt : public HECtxt {
   // returns information about the ctxt
   std::string info() override {
     return " pool references: " +
-           std::to_string(_internal_ctxt.pool().use_count());
+           std::to_string(ciphertext().pool().use_count());
   };
 
   // arithmetic operations
@@ -83,6 +92,11 @@ class SEALCtxt : public HECtxt {
   // Rotation
   virtual std::shared_ptr<HECtxt> rotate(int steps) override;
   virtual void rotInPlace(int steps) override;
+  // rotates this ciphertext by each of `steps`. the key switching
+  // decomposition is computed once and shared by all rotations (see
+  // HoistedRotator)
+  std::vector<std::shared_ptr<HECtxt>> rotateMany(
+      const std::vector<int>& steps);
 
   // SEAL specific API
   SEALCtxt(const std::string& name, CONTENT_TYPE content_type,
@@ -99,6 +113,21 @@ class SEALCtxt : public HECtxt {
   // since we can only to lower levels this means that this is the ciphertext at
   // the lower level
   void match_scale_and_parms(const SEALCtxt& other);
+  // writes `src` matched to the scale and level of `target` into `dst`. `dst`
+  // may be `src`
+  void match_to(const seal::Ciphertext& src, const seal::Ciphertext& target,
+                seal::Ciphertext& dst) const;
+  // writes `src` matched to `scale` at `parms_id` into `dst`
+  void match_to(const seal::Ciphertext& src,
+                const seal::parms_id_type& parms_id, double scale,
+                seal::Ciphertext& dst) const;
+
+  // lazy evaluation. if the context has lazy evaluation enabled
+  // multiplications only mark the ciphertext as needing relinearization and
+  // rescaling. `flush` performs all pending operations in place.
+  void flush();
+  bool needs_relinearization() const;
+  bool needs_rescale() const;
 
   const std::string& name() const;
 
@@ -108,6 +137,19 @@ class SEALCtxt : public HECtxt {
   static void count_ctxt_ctxt_add();
   static void count_ctxt_ptxt_add();
   static void count_ctxt_rot();
+  // operations performed to match the scale and level of operands
+  static void count_match_mod_switch();
+  static void count_match_rescale();
+  static void count_match_mult();
+  // operations skipped because an operand is zero or one and zeros that had
+  // to be encrypted after all (see Shared::zero)
+  static void count_skipped_mult();
+  static void count_skipped_add();
+  static void count_zero_materialization();
+
+  // the distribution of chain indices is recorded for this many levels. higher
+  // chain indices are recorded in the last one
+  static constexpr size_t MONITORED_LEVELS = 16;
 
  private:
   // SEAL specific API
@@ -117,7 +159,132 @@ class SEALCtxt : public HECtxt {
   std::string _name;
   CONTENT_TYPE _content_type;
   const SEALContext& _context;
-  seal::Ciphertext _internal_ctxt;
+  // the ciphertext is shared between copies of this (deepCopy, copy) until
+  // one of them is modified. the bytes are counted and the buffer is returned
+  // to the freelist once per shared ciphertext
+  struct Shared {
+    seal::Ciphertext ctxt;
+    // bytes reported to the object counter
+    int64_t counted_bytes = 0;
+    // lower level versions of `ctxt` (see `lowered`)
+    LevelCache<seal::Ciphertext> levels;
+    // `ctxt` is known to encrypt zero. a product with it is zero and adding it
+    // changes nothing, so these operations are skipped. products with all
+    // zero plaintexts create zeros instead of transparent ciphertexts
+    bool zero = false;
+    // `ctxt` of a zero only has the parameters and scale, no polynomials. a
+    // fresh encryption of zero is written into it when it is read by an
+    // operation that can't be skipped (see `ciphertext`)
+    std::atomic<bool> placeholder{false};
+    std::once_flag materialized;
+    // parameters and scale of a zero. `materialize` writes `ctxt` while other
+    // threads may read the shape of the zero, so `shape` reads them from here
+    seal::parms_id_type parms_id = seal::parms_id_zero;
+    double scale = 0;
+
+    explicit Shared(seal::Ciphertext&& c) : ctxt(std::move(c)) {}
+    ~Shared();
+  };
+  std::shared_ptr<Shared> _shared;
+  // lazy evaluation state
+  bool _needs_relin = false;
+  bool _needs_rescale = false;
+
+  // reports the change of the size of the ciphertext to the object counter.
+  // needs to be called after the ciphertext was modified
+  void track_bytes();
+
+  // chain index of `ctxt` for the phase timers. 0 if timing is disabled
+  size_t timed_level(const seal::Ciphertext& ctxt) const;
+  int chain_index(const seal::Ciphertext& ctxt) const;
+  int chain_index(const seal::parms_id_type& parms_id) const;
+  // span of an operation on this ciphertext for the trace. records the chain
+  // indices of this and `rhs` if tracing is enabled
+  TraceSpan trace(const char* op, const SEALCtxt* rhs = nullptr) const;
+
+  // capture of an operation on this ciphertext with the operand `rhs` (see
+  // op_capture.h)
+  OpCapture capture(CAPTURE_OP op, bool inplace) const;
+  OpCapture capture(CAPTURE_OP op, bool inplace, const SEALCtxt& rhs) const;
+  OpCapture capture(CAPTURE_OP op, bool inplace,
+                    const std::shared_ptr<HEPtxt>& rhs) const;
+  template <class T>
+  OpCapture capture(CAPTURE_OP op, bool inplace, T rhs) const;
+
+  // the ciphertext for reading
+  const seal::Ciphertext& ciphertext() const {
+    if (_shared->placeholder.load(std::memory_order_acquire)) {
+      materialize();
+    }
+    return _shared->ctxt;
+  }
+  // parameters and scale of the ciphertext. the polynomials of a zero are not
+  // computed
+  std::pair<seal::parms_id_type, double> shape() const {
+    if (_shared->zero) {
+      return {_shared->parms_id, _shared->scale};
+    }
+    return {_shared->ctxt.parms_id(), _shared->ctxt.scale()};
+  }
+  // encrypts the zero of a placeholder
+  void materialize() const;
+  bool is_zero() const { return _shared->zero; }
+  // shares the ciphertext and pending operations of `other`, the sum of a
+  // zero and `other`
+  void take(const SEALCtxt& other);
+  // replaces the ciphertext with a zero at `shape` (see Shared::zero)
+  void become_zero(const std::pair<seal::parms_id_type, double>& shape);
+  // parameters and scale after a rescale of a ciphertext at `parms_id` and
+  // `scale`. unchanged if nothing can be rescaled
+  std::pair<seal::parms_id_type, double> rescaled_shape(
+      const seal::parms_id_type& parms_id, double scale) const;
+  // parameters and scale of this with all pending operations applied
+  std::pair<seal::parms_id_type, double> flushed_shape() const;
+  // parameters and scale of the product of this with a plaintext (see
+  // operator*(std::shared_ptr<HEPtxt>))
+  std::pair<seal::parms_id_type, double> plain_product_shape() const;
+  // parameters and scale of the product of this with `other`
+  std::pair<seal::parms_id_type, double> product_shape(
+      const SEALCtxt& other) const;
+  // multiplies this with a plaintext of ones. brings this to the level and
+  // scale of the product without encoding and multiplying the plaintext.
+  // returns false if the product can't be formed that way
+  bool multiply_by_one();
+  // the ciphertext for writing. if it is shared with another copy it is
+  // copied into a buffer from the freelist first
+  seal::Ciphertext& mutable_ciphertext();
+
+  // the ciphertext of `other`, which has no pending operations, mod switched
+  // to the level of `target`. with `match_scale` it is also brought to the
+  // scale of `target` (see `match_to`). the versions are cached by `other`
+  // until it is modified
+  std::shared_ptr<const seal::Ciphertext> lowered(
+      const SEALCtxt& other, const seal::Ciphertext& target,
+      bool match_scale) const;
+
+  // only perform a pending relinearization or rescale respectively
+  void relinearize();
+  void rescale();
+  // returns the ciphertext with all pending operations applied without
+  // modifying this. if nothing is pending the internal ciphertext is returned,
+  // otherwise the result is written into `scratch`.
+  const seal::Ciphertext& flushed(seal::Ciphertext& scratch) const;
+  // needs to be called after the internal ciphertext has been multiplied.
+  // relinearizes and rescales or marks them as pending
+  void multiplied(bool relin);
+
+  // copy of this ciphertext including pending operations
+  std::shared_ptr<SEALCtxt> copy(const std::string& name) const;
+  // empty ciphertext for the result of an operation on this ciphertext. takes
+  // a buffer for `size` polynomials (the size of this by default) at the level
+  // of this from the freelist of the thread
+  std::shared_ptr<SEALCtxt> new_result(const std::string& name,
+                                       size_t size = 0) const;
+  // scalar fast paths. see ctxt.cc
+  void add_scalar_inplace(long value);
+  void add_scalar_inplace(double value);
+  void multiply_scalar_inplace(long value);
+  void multiply_scalar_inplace(double value);
 
   static bool count_ops;
 
@@ -133,11 +300,36 @@ class SEALCtxt : public HECtxt {
 
   static std::atomic_ulong rot_count;
 
+  // matching of scales and levels
+  static std::atomic_ulong match_mod_switch_count;
+  static std::atomic_ulong match_rescale_count;
+  static std::atomic_ulong match_mult_count;
+
+  // shortcuts for zero and one
+  static std::atomic_ulong skipped_mult_count;
+  static std::atomic_ulong skipped_add_count;
+  static std::atomic_ulong zero_materialize_count;
+
+  // number of operations per chain index of the input
+  static std::atomic_ulong level_op_count[MONITORED_LEVELS];
+
+  // sampled invariant noise budget of BFV ciphertexts in bits. -1 until the
+  // first sample
+  static std::atomic_long noise_budget_min;
+  static std::atomic_long noise_budget_last;
+  static std::atomic_ulong noise_budget_samples;
+
+  // records the chain index this ciphertext is used at by an operation. for
+  // BFV the noise budget of every n-th input is sampled (see ctxt.cc)
+  void record_level() const;
+
   SEALCtxt(const SEALCtxt& other)
       : _name(other._name),
         _content_type(other._content_type),
         _context(other._context),
-        _internal_ctxt(other._internal_ctxt) {
+        _shared(other._shared),  // shared until one of them is modified
+        _needs_relin(other._needs_relin),
+        _needs_rescale(other._needs_rescale) {
     count_ctxt(1);
   };
 };
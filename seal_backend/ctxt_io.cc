@@ -0,0 +1,70 @@
+#include "ctxt_io.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace aluminum_shark {
+
+void write_ciphertext(CtxtFileWriter& writer, const seal::SEALContext& context,
+                      const seal::Ciphertext& ctxt,
+                      seal::compr_mode_type compression, uint32_t user_flags) {
+  CtxtEntry entry;
+  std::memcpy(entry.parms_id, ctxt.parms_id().data(), sizeof(entry.parms_id));
+  auto context_data = context.get_context_data(ctxt.parms_id());
+  entry.level = context_data ? context_data->chain_index() : 0;
+  entry.scale = ctxt.scale();
+  entry.size = ctxt.size();
+  entry.flags = (user_flags << CTXT_FLAG_USER_SHIFT) |
+                (ctxt.is_ntt_form() ? CTXT_FLAG_NTT_FORM : 0);
+  if (compression == seal::compr_mode_type::none) {
+    size_t bytes =
+        ctxt.dyn_array().size() * sizeof(seal::Ciphertext::ct_coeff_type);
+    writer.add(entry, ctxt.data(), bytes);
+  } else {
+    writer.add(entry, [&ctxt, compression](std::ostream& out) {
+      ctxt.save(out, compression);
+    });
+  }
+}
+
+uint32_t read_ciphertext(const CtxtFileReader& reader, size_t i,
+                         const seal::SEALContext& context,
+                         seal::Ciphertext& ctxt) {
+  const CtxtEntry& entry = reader.entry(i);
+  const char* data = reader.data(i);
+  if (reader.compression() !=
+      static_cast<uint32_t>(seal::compr_mode_type::none)) {
+    // SEAL validates the ciphertext
+    ctxt.load(context, reinterpret_cast<const seal::seal_byte*>(data),
+              entry.bytes);
+    return entry.flags >> CTXT_FLAG_USER_SHIFT;
+  }
+
+  seal::parms_id_type parms_id;
+  std::memcpy(parms_id.data(), entry.parms_id, sizeof(entry.parms_id));
+  auto context_data = context.get_context_data(parms_id);
+  if (!context_data) {
+    throw std::runtime_error("ciphertext " + std::to_string(i) +
+                             " doesn't belong to the context");
+  }
+  const auto& parms = context_data->parms();
+  size_t expected = entry.size * parms.coeff_modulus().size() *
+                    parms.poly_modulus_degree() *
+                    sizeof(seal::Ciphertext::ct_coeff_type);
+  if (entry.size < SEAL_CIPHERTEXT_SIZE_MIN ||
+      entry.size > SEAL_CIPHERTEXT_SIZE_MAX || entry.bytes != expected) {
+    throw std::runtime_error("ciphertext " + std::to_string(i) +
+                             " has an invalid size");
+  }
+  ctxt.resize(context, parms_id, entry.size);
+  std::memcpy(ctxt.data(), data, expected);
+  ctxt.is_ntt_form() = entry.flags & CTXT_FLAG_NTT_FORM;
+  ctxt.scale() = entry.scale;
+  if (!seal::is_metadata_valid_for(ctxt, context)) {
+    throw std::runtime_error("ciphertext " + std::to_string(i) +
+                             " is invalid for the context");
+  }
+  return entry.flags >> CTXT_FLAG_USER_SHIFT;
+}
+
+}  // namespace aluminum_shark
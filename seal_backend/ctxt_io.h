@@ -0,0 +1,34 @@
+#ifndef ALUMINUM_SHARK_SEAL_BACKEND_CTXT_IO_H
+#define ALUMINUM_SHARK_SEAL_BACKEND_CTXT_IO_H
+
+#include <cstdint>
+
+#include "ctxt_file.h"
+#include "seal/seal.h"
+
+namespace aluminum_shark {
+
+// flags stored with SEAL ciphertexts. the lower 16 bits are reserved for the
+// ciphertext, the upper bits are passed through for the caller
+constexpr uint32_t CTXT_FLAG_NTT_FORM = 1;
+constexpr uint32_t CTXT_FLAG_USER_SHIFT = 16;
+
+// appends `ctxt` to `writer`. without compression the polynomial data is
+// written as is, otherwise SEAL's serialization with `compression` is used.
+// `compression` needs to match the one the writer was created with
+void write_ciphertext(CtxtFileWriter& writer, const seal::SEALContext& context,
+                      const seal::Ciphertext& ctxt,
+                      seal::compr_mode_type compression,
+                      uint32_t user_flags = 0);
+
+// reads the `i`th ciphertext of `reader` into `ctxt`. uncompressed data is
+// copied from the mapped file straight into the polynomial buffer of `ctxt`.
+// returns the user flags. throws std::runtime_error if the ciphertext doesn't
+// belong to `context`
+uint32_t read_ciphertext(const CtxtFileReader& reader, size_t i,
+                         const seal::SEALContext& context,
+                         seal::Ciphertext& ctxt);
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_CTXT_IO_H */
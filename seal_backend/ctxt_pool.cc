@@ -0,0 +1,151 @@
+#include "ctxt_pool.h"
+
+#include <cstdlib>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+std::atomic_bool freelist_enabled{false};
+
+const size_t budget_bytes =
+    (std::getenv("ALUMINUM_SHARK_FREELIST_MB") == nullptr
+         ? size_t{256}
+         : std::stoul(std::getenv("ALUMINUM_SHARK_FREELIST_MB")))
+    << 20;
+
+// bytes held by the buffers of all threads
+std::atomic<size_t> held_bytes{0};
+// incremented by trim(). threads whose lists are older drop them
+std::atomic<uint64_t> generation{0};
+
+using lists_type = std::unordered_map<size_t, std::vector<seal::Ciphertext>>;
+
+// set once the lists of the thread are destroyed. ciphertexts can still be
+// destroyed after that, e.g. during the interpreter shutdown
+thread_local bool thread_exiting = false;
+
+size_t buffer_bytes(const seal::Ciphertext& ctxt) {
+  return ctxt.dyn_array().capacity() * sizeof(seal::Ciphertext::ct_coeff_type);
+}
+
+struct ThreadLists {
+  lists_type lists;
+  // bytes held by `lists`
+  size_t bytes = 0;
+  uint64_t generation = 0;
+
+  void clear() {
+    lists.clear();
+    held_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    bytes = 0;
+  }
+
+  ~ThreadLists() {
+    thread_exiting = true;
+    clear();
+  }
+};
+
+// buffers of the calling thread by (size, coeff_modulus_size). nullptr if the
+// thread is exiting
+ThreadLists* freelist() {
+  if (thread_exiting) {
+    return nullptr;
+  }
+  thread_local ThreadLists lists;
+  const uint64_t current = generation.load(std::memory_order_relaxed);
+  if (lists.generation != current) {
+    lists.clear();
+    lists.generation = current;
+  }
+  return &lists;
+}
+
+size_t key(size_t size, size_t coeff_modulus_size) {
+  return (size << 32) | coeff_modulus_size;
+}
+
+}  // namespace
+
+namespace aluminum_shark {
+
+seal::MemoryPoolHandle MMProfPerThread::get_pool(seal::mm_prof_opt_t) {
+  thread_local seal::MemoryPoolHandle pool = seal::MemoryPoolHandle::New();
+  return pool;
+}
+
+std::atomic_ulong CiphertextFreelist::hits = 0;
+std::atomic_ulong CiphertextFreelist::misses = 0;
+
+void CiphertextFreelist::enable(bool enabled) {
+  freelist_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool CiphertextFreelist::enabled() {
+  return freelist_enabled.load(std::memory_order_relaxed);
+}
+
+seal::Ciphertext CiphertextFreelist::acquire(size_t size,
+                                             size_t coeff_modulus_size) {
+  if (!enabled()) {
+    return seal::Ciphertext();
+  }
+  ThreadLists* lists = freelist();
+  if (!lists) {
+    return seal::Ciphertext();
+  }
+  auto it = lists->lists.find(key(size, coeff_modulus_size));
+  if (it == lists->lists.end() || it->second.empty()) {
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return seal::Ciphertext();
+  }
+  hits.fetch_add(1, std::memory_order_relaxed);
+  seal::Ciphertext ctxt = std::move(it->second.back());
+  it->second.pop_back();
+  const size_t bytes = buffer_bytes(ctxt);
+  lists->bytes -= bytes;
+  held_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  return ctxt;
+}
+
+void CiphertextFreelist::release(seal::Ciphertext& ctxt) {
+  ThreadLists* lists = enabled() ? freelist() : nullptr;
+  const size_t bytes = buffer_bytes(ctxt);
+  if (!lists || bytes == 0) {
+    return;
+  }
+  auto& list = lists->lists[key(ctxt.size(), ctxt.coeff_modulus_size())];
+  if (list.size() >= max_per_key) {
+    return;
+  }
+  if (held_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes >
+      budget_bytes) {
+    // over budget. the buffers of this thread are released to its memory
+    // pool where the next allocation can reuse them
+    held_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    lists->clear();
+    return;
+  }
+  lists->bytes += bytes;
+  list.push_back(std::move(ctxt));
+}
+
+void CiphertextFreelist::clear() {
+  ThreadLists* lists = freelist();
+  if (lists) {
+    lists->clear();
+  }
+}
+
+void CiphertextFreelist::trim() {
+  generation.fetch_add(1, std::memory_order_relaxed);
+  clear();
+}
+
+size_t CiphertextFreelist::bytes() {
+  return held_bytes.load(std::memory_order_relaxed);
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,59 @@
+#ifndef ALUMINUM_SHARK_SEAL_BACKEND_CTXT_POOL_H
+#define ALUMINUM_SHARK_SEAL_BACKEND_CTXT_POOL_H
+
+#include <atomic>
+#include <cstddef>
+
+#include "seal/seal.h"
+
+namespace aluminum_shark {
+
+// memory profile that hands every thread its own memory pool. unlike
+// seal::MMProfThreadLocal the pools are thread safe, memory allocated by one
+// thread can be released by another one. the pools only contend if a thread
+// frees memory of another thread
+class MMProfPerThread : public seal::MMProf {
+ public:
+  seal::MemoryPoolHandle get_pool(seal::mm_prof_opt_t) override;
+};
+
+// per thread freelists of ciphertext buffers keyed by (size, number of
+// primes). results of ciphertext operations take a buffer from the list of the
+// calling thread and SEAL reuses its memory when it resizes the ciphertext.
+// destroyed ciphertexts return their buffer to the list of the destroying
+// thread. all functions are no-ops unless the freelists are enabled.
+//
+// the buffers of all threads share a byte budget set by
+// ALUMINUM_SHARK_FREELIST_MB (default 256). a thread that would exceed it drops
+// its own buffers instead of storing more
+class CiphertextFreelist {
+ public:
+  // maximum number of buffers per key and thread
+  static constexpr size_t max_per_key = 16;
+
+  static void enable(bool enabled);
+  static bool enabled();
+
+  // returns a buffer for a ciphertext of `size` polynomials with
+  // `coeff_modulus_size` primes or an empty ciphertext
+  static seal::Ciphertext acquire(size_t size, size_t coeff_modulus_size);
+  // stores the buffer of `ctxt`. `ctxt` is left empty
+  static void release(seal::Ciphertext& ctxt);
+
+  // drops all buffers of the calling thread
+  static void clear();
+  // drops the buffers of all threads. other threads drop theirs the next time
+  // they acquire or release a buffer
+  static void trim();
+
+  // bytes held by the buffers of all threads
+  static size_t bytes();
+
+  // statistics. shared by all threads
+  static std::atomic_ulong hits;
+  static std::atomic_ulong misses;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_CTXT_POOL_H */
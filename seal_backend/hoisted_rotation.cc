@@ -0,0 +1,161 @@
+#include "hoisted_rotation.h"
+
+#include <algorithm>
+
+#include "seal/util/galois.h"
+#include "seal/util/iterator.h"
+#include "seal/util/ntt.h"
+#include "seal/util/polyarithsmallmod.h"
+#include "seal/util/rns.h"
+#include "seal/util/uintarithsmallmod.h"
+
+using seal::util::CoeffIter;
+using seal::util::ConstCoeffIter;
+
+namespace aluminum_shark {
+
+bool HoistedRotator::supported(const seal::SEALContext& context,
+                               const seal::Ciphertext& ctxt) {
+  auto context_data = context.get_context_data(ctxt.parms_id());
+  return context_data &&
+         context_data->parms().scheme() == seal::scheme_type::ckks &&
+         context.using_keyswitching() && ctxt.size() == 2 &&
+         ctxt.is_ntt_form() && ctxt.parms_id() != context.key_parms_id();
+}
+
+HoistedRotator::HoistedRotator(const seal::SEALContext& context,
+                               const seal::Ciphertext& ctxt)
+    : _context(context), _ctxt(ctxt) {
+  auto context_data = context.get_context_data(ctxt.parms_id());
+  auto key_context_data = context.key_context_data();
+  const auto& key_modulus = key_context_data->parms().coeff_modulus();
+  const seal::util::NTTTables* key_ntt_tables =
+      key_context_data->small_ntt_tables();
+  const size_t key_modulus_size = key_modulus.size();
+  _decomp_modulus_size = context_data->parms().coeff_modulus().size();
+  _coeff_count = ctxt.poly_modulus_degree();
+  const size_t n = _coeff_count;
+  const size_t rns_modulus_size = _decomp_modulus_size + 1;
+  _digits.resize(_decomp_modulus_size * rns_modulus_size * n);
+
+  // c1 in coefficient form. digit j is c1 mod q_j
+  std::vector<uint64_t> target(ctxt.data(1),
+                               ctxt.data(1) + _decomp_modulus_size * n);
+  for (size_t j = 0; j < _decomp_modulus_size; ++j) {
+    seal::util::inverse_ntt_negacyclic_harvey(CoeffIter(target.data() + j * n),
+                                              key_ntt_tables[j]);
+  }
+  // extend every digit to all primes and convert it into NTT form
+  for (size_t j = 0; j < _decomp_modulus_size; ++j) {
+    for (size_t i = 0; i < rns_modulus_size; ++i) {
+      uint64_t* dst = _digits.data() + (j * rns_modulus_size + i) * n;
+      if (i == j) {
+        // already available in NTT form
+        std::copy_n(ctxt.data(1) + j * n, n, dst);
+        continue;
+      }
+      size_t key_index = i == _decomp_modulus_size ? key_modulus_size - 1 : i;
+      seal::util::modulo_poly_coeffs(ConstCoeffIter(target.data() + j * n), n,
+                                     key_modulus[key_index], CoeffIter(dst));
+      seal::util::ntt_negacyclic_harvey(CoeffIter(dst),
+                                        key_ntt_tables[key_index]);
+    }
+  }
+}
+
+bool HoistedRotator::rotate(int steps, const seal::GaloisKeys& keys,
+                            seal::Ciphertext& destination) const {
+  auto context_data = _context.get_context_data(_ctxt.parms_id());
+  auto key_context_data = _context.key_context_data();
+  const seal::util::GaloisTool* galois_tool = context_data->galois_tool();
+  const uint32_t galois_elt = galois_tool->get_elt_from_step(steps);
+  if (!keys.has_key(galois_elt)) {
+    return false;
+  }
+  const auto& key_vector =
+      keys.data()[seal::GaloisKeys::get_index(galois_elt)];
+  const auto& key_modulus = key_context_data->parms().coeff_modulus();
+  const seal::util::NTTTables* key_ntt_tables =
+      key_context_data->small_ntt_tables();
+  const size_t key_modulus_size = key_modulus.size();
+  const size_t n = _coeff_count;
+  const size_t rns_modulus_size = _decomp_modulus_size + 1;
+
+  // inner product of the rotated digits and the key. products are at most
+  // 120 bits so they can be accumulated without reduction
+  std::vector<uint64_t> prod(2 * rns_modulus_size * n);
+  std::vector<uint64_t> rotated(n);
+  std::vector<unsigned __int128> acc(2 * n);
+  for (size_t i = 0; i < rns_modulus_size; ++i) {
+    size_t key_index = i == _decomp_modulus_size ? key_modulus_size - 1 : i;
+    std::fill(acc.begin(), acc.end(), 0);
+    for (size_t j = 0; j < _decomp_modulus_size; ++j) {
+      galois_tool->apply_galois_ntt(ConstCoeffIter(digit(j, i)), galois_elt,
+                                    CoeffIter(rotated.data()));
+      const seal::Ciphertext& key = key_vector[j].data();
+      for (size_t k = 0; k < 2; ++k) {
+        const uint64_t* key_poly = key.data(k) + key_index * n;
+        unsigned __int128* a = acc.data() + k * n;
+        for (size_t c = 0; c < n; ++c) {
+          a[c] += static_cast<unsigned __int128>(rotated[c]) * key_poly[c];
+        }
+      }
+    }
+    for (size_t k = 0; k < 2; ++k) {
+      uint64_t* p = prod.data() + (k * rns_modulus_size + i) * n;
+      const unsigned __int128* a = acc.data() + k * n;
+      for (size_t c = 0; c < n; ++c) {
+        const uint64_t words[2] = {static_cast<uint64_t>(a[c]),
+                                   static_cast<uint64_t>(a[c] >> 64)};
+        p[c] = seal::util::barrett_reduce_128(words, key_modulus[key_index]);
+      }
+    }
+  }
+
+  // rotate c0. c1 only consists of the key switching result
+  destination = _ctxt;
+  for (size_t j = 0; j < _decomp_modulus_size; ++j) {
+    galois_tool->apply_galois_ntt(ConstCoeffIter(_ctxt.data(0) + j * n),
+                                  galois_elt,
+                                  CoeffIter(destination.data(0) + j * n));
+  }
+  std::fill_n(destination.data(1), _decomp_modulus_size * n, 0);
+
+  // divide by the special prime with rounding. same as
+  // `Evaluator::switch_key_inplace`
+  const seal::Modulus& special_prime = key_modulus[key_modulus_size - 1];
+  const uint64_t qk_half = special_prime.value() >> 1;
+  auto modswitch_factors = key_context_data->rns_tool()->inv_q_last_mod_q();
+  std::vector<uint64_t> t_ntt(n);
+  for (size_t k = 0; k < 2; ++k) {
+    uint64_t* t_last =
+        prod.data() + (k * rns_modulus_size + _decomp_modulus_size) * n;
+    seal::util::inverse_ntt_negacyclic_harvey(
+        CoeffIter(t_last), key_ntt_tables[key_modulus_size - 1]);
+    for (size_t c = 0; c < n; ++c) {
+      t_last[c] = seal::util::barrett_reduce_64(t_last[c] + qk_half,
+                                                special_prime);
+    }
+    for (size_t j = 0; j < _decomp_modulus_size; ++j) {
+      const seal::Modulus& qi = key_modulus[j];
+      seal::util::modulo_poly_coeffs(ConstCoeffIter(t_last), n, qi,
+                                     CoeffIter(t_ntt.data()));
+      const uint64_t fix =
+          qi.value() - seal::util::barrett_reduce_64(qk_half, qi);
+      for (size_t c = 0; c < n; ++c) {
+        t_ntt[c] = seal::util::barrett_reduce_64(t_ntt[c] + fix, qi);
+      }
+      seal::util::ntt_negacyclic_harvey(CoeffIter(t_ntt.data()),
+                                        key_ntt_tables[j]);
+      CoeffIter p(prod.data() + (k * rns_modulus_size + j) * n);
+      CoeffIter dst(destination.data(k) + j * n);
+      seal::util::sub_poly_coeffmod(p, ConstCoeffIter(t_ntt.data()), n, qi, p);
+      seal::util::multiply_poly_scalar_coeffmod(p, n, modswitch_factors[j], qi,
+                                                p);
+      seal::util::add_poly_coeffmod(p, dst, n, qi, dst);
+    }
+  }
+  return true;
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,52 @@
+#ifndef ALUMINUM_SHARK_SEAL_BACKEND_HOISTED_ROTATION_H
+#define ALUMINUM_SHARK_SEAL_BACKEND_HOISTED_ROTATION_H
+
+#include <cstdint>
+#include <vector>
+
+#include "seal/seal.h"
+
+namespace aluminum_shark {
+
+// Rotates a single CKKS ciphertext by many different steps. SEAL's
+// `rotate_vector` decomposes c1 into its RNS digits and converts every digit
+// into NTT form for every key switch. The digit decomposition commutes with
+// the Galois automorphism (it only permutes the NTT slots) so it is computed
+// once in the constructor and reused for every rotation ("hoisting").
+// Only the automorphism, the inner product with the key and the final
+// division by the special prime are paid per rotation.
+class HoistedRotator {
+ public:
+  // `ctxt` needs to be a CKKS ciphertext of size 2
+  HoistedRotator(const seal::SEALContext& context,
+                 const seal::Ciphertext& ctxt);
+
+  // rotates the ciphertext by `steps` and writes the result into
+  // `destination`. returns false if `keys` don't contain the galois key
+  // needed for `steps`. `destination` is not modified in that case.
+  bool rotate(int steps, const seal::GaloisKeys& keys,
+              seal::Ciphertext& destination) const;
+
+  // returns true if hoisting can be used for `ctxt`
+  static bool supported(const seal::SEALContext& context,
+                        const seal::Ciphertext& ctxt);
+
+ private:
+  const seal::SEALContext& _context;
+  const seal::Ciphertext& _ctxt;
+  // number of primes of the ciphertext
+  size_t _decomp_modulus_size;
+  size_t _coeff_count;
+  // NTT form of the digits of c1. digit j reduced modulo the prime i is
+  // stored at (j * (_decomp_modulus_size + 1) + i) * _coeff_count. the last
+  // prime is the special prime
+  std::vector<uint64_t> _digits;
+
+  const uint64_t* digit(size_t j, size_t i) const {
+    return _digits.data() + (j * (_decomp_modulus_size + 1) + i) * _coeff_count;
+  }
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_HOISTED_ROTATION_H */
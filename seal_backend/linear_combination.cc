@@ -0,0 +1,80 @@
+#include "linear_combination.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "seal/util/uintarithsmallmod.h"
+
+namespace aluminum_shark {
+
+void multiply_plain_accumulate(
+    const seal::SEALContext& context,
+    const std::vector<const seal::Ciphertext*>& ctxts,
+    const std::vector<const seal::Plaintext*>& ptxts,
+    seal::Ciphertext& destination) {
+  if (ctxts.empty() || ctxts.size() != ptxts.size()) {
+    throw std::invalid_argument("need the same number of ciphertexts and "
+                                "plaintexts");
+  }
+  const seal::Ciphertext& first = *ctxts[0];
+  auto context_data = context.get_context_data(first.parms_id());
+  if (!context_data) {
+    throw std::invalid_argument("ciphertext is not valid for the context");
+  }
+  const auto& coeff_modulus = context_data->parms().coeff_modulus();
+  const size_t n = first.poly_modulus_degree();
+  const size_t k = coeff_modulus.size();
+  const size_t size = first.size();
+  for (size_t i = 0; i < ctxts.size(); ++i) {
+    if (ctxts[i]->parms_id() != first.parms_id() ||
+        ptxts[i]->parms_id() != first.parms_id() ||
+        ctxts[i]->size() != size || !ctxts[i]->is_ntt_form() ||
+        !ptxts[i]->is_ntt_form()) {
+      throw std::invalid_argument("term " + std::to_string(i) +
+                                  " doesn't match the first term");
+    }
+  }
+
+  // every product is below 2^120. reduce before 2^128 could overflow
+  const size_t max_terms = 255;
+  std::vector<unsigned __int128> acc(size * k * n, 0);
+  auto reduce = [&]() {
+    for (size_t p = 0; p < size; ++p) {
+      for (size_t j = 0; j < k; ++j) {
+        unsigned __int128* a = acc.data() + (p * k + j) * n;
+        for (size_t c = 0; c < n; ++c) {
+          const uint64_t words[2] = {static_cast<uint64_t>(a[c]),
+                                     static_cast<uint64_t>(a[c] >> 64)};
+          a[c] = seal::util::barrett_reduce_128(words, coeff_modulus[j]);
+        }
+      }
+    }
+  };
+  size_t pending = 1;
+  for (size_t i = 0; i < ctxts.size(); ++i) {
+    if (pending == max_terms) {
+      reduce();
+      pending = 1;
+    }
+    for (size_t p = 0; p < size; ++p) {
+      for (size_t j = 0; j < k; ++j) {
+        const uint64_t* ct = ctxts[i]->data(p) + j * n;
+        const uint64_t* pt = ptxts[i]->data() + j * n;
+        unsigned __int128* a = acc.data() + (p * k + j) * n;
+        for (size_t c = 0; c < n; ++c) {
+          a[c] += static_cast<unsigned __int128>(ct[c]) * pt[c];
+        }
+      }
+    }
+    ++pending;
+  }
+  reduce();
+
+  destination.resize(context, first.parms_id(), size);
+  destination.is_ntt_form() = true;
+  destination.scale() = first.scale() * ptxts[0]->scale();
+  std::transform(acc.begin(), acc.end(), destination.data(),
+                 [](unsigned __int128 v) { return static_cast<uint64_t>(v); });
+}
+
+}  // namespace aluminum_shark
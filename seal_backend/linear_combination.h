@@ -0,0 +1,24 @@
+#ifndef ALUMINUM_SHARK_SEAL_BACKEND_LINEAR_COMBINATION_H
+#define ALUMINUM_SHARK_SEAL_BACKEND_LINEAR_COMBINATION_H
+
+#include <vector>
+
+#include "seal/seal.h"
+
+namespace aluminum_shark {
+
+// computes sum_i ctxts[i] * ptxts[i] for CKKS ciphertexts and plaintexts in
+// NTT form. all ciphertexts need to be at the same level and of the same size,
+// the plaintexts at the same level as the ciphertexts. the products are
+// accumulated in 128 bit and reduced once per coefficient instead of once per
+// product. the scale of the result is the scale of the first product, the
+// caller needs to make sure all products have the same scale.
+void multiply_plain_accumulate(
+    const seal::SEALContext& context,
+    const std::vector<const seal::Ciphertext*>& ctxts,
+    const std::vector<const seal::Plaintext*>& ptxts,
+    seal::Ciphertext& destination);
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_LINEAR_COMBINATION_H */
@@ -8,15 +8,31 @@ namespace aluminum_shark {
 
 SEALPtxt::SEALPtxt(seal::Plaintext ptxt, CONTENT_TYPE content_type,
                    const SEALContext& context)
-    : _internal_ptxt(ptxt), _content_type(content_type), _context(context) {
+    : _internal_ptxt(ptxt),
+      _content_type(content_type),
+      _context(context),
+      _encodings(
+          context._internal_context.first_context_data()->chain_index() + 1) {
   count_ptxt(1);
+  track_bytes();
+}
+
+void SEALPtxt::track_bytes() {
+  if (!AS_OBJECT_COUNT) {
+    return;
+  }
+  int64_t bytes = _internal_ptxt.dyn_array().size() *
+                  sizeof(seal::Plaintext::pt_coeff_type);
+  count_ptxt_bytes(bytes - _counted_bytes);
+  _counted_bytes = bytes;
 }
 
 SEALPtxt::SEALPtxt(SEALPtxt&& other)
     : _content_type(std::move(other._content_type)),
       _context(other._context),
       _allZero(std::move(other._allZero)),
-      _allOne(std::move(other._allOne)) {}
+      _allOne(std::move(other._allOne)),
+      _encodings(other._encodings.levels()) {}
 
 // SEALPtxt& SEALPtxt::operator=(SEALPtxt&& other) {
 //   _content_type = std::move(other._content_type);
@@ -78,6 +94,9 @@ SEALPtxt SEALPtxt::rescale(double scale) const {
 SEALPtxt SEALPtxt::rescale(double scale, seal::parms_id_type params_id) const {
   BACKEND_LOG << "resacling plaintext from " << _internal_ptxt.scale() << " to "
               << scale << std::endl;
+  if (_context.is_ckks()) {
+    return SEALPtxt(*encoded(scale, params_id), _content_type, _context);
+  }
   if (_content_type == CONTENT_TYPE::LONG) {
     return SEALPtxt(std::dynamic_pointer_cast<SEALPtxt>(
                         _context.encode(long_values, params_id, scale))
@@ -94,6 +113,11 @@ SEALPtxt SEALPtxt::rescale(double scale, seal::parms_id_type params_id) const {
 void SEALPtxt::rescaleInPalce(double scale, seal::parms_id_type params_id) {
   BACKEND_LOG << "resacling plaintext from " << _internal_ptxt.scale() << " to "
               << scale << std::endl;
+  if (_context.is_ckks()) {
+    _internal_ptxt = *encoded(scale, params_id);
+    track_bytes();
+    return;
+  }
   _context.encode(*this, params_id, scale);
 }
 
@@ -111,16 +135,90 @@ void SEALPtxt::scaleToMatchInPlace(const SEALCtxt& ctxt) {
                  ctxt.sealCiphertext().parms_id());
 }
 
+const std::vector<double>& SEALPtxt::cache_values() const {
+  std::call_once(_cache_key_flag, [this]() {
+    if (double_values.size() == 0) {
+      if (long_values.size() != 0) {
+        _cache_values =
+            std::vector<double>(long_values.begin(), long_values.end());
+      } else {
+        // created through `encode`. only the encoded plaintext is available
+        _cache_values = _context.decode<double>(*this);
+      }
+    }
+    _cache_hash = PlaintextCache::hash(
+        double_values.size() != 0 ? double_values : _cache_values);
+  });
+  return double_values.size() != 0 ? double_values : _cache_values;
+}
+
+std::shared_ptr<const seal::Plaintext> SEALPtxt::encoded(
+    double scale, seal::parms_id_type params_id) const {
+  if (!_context.is_ckks()) {
+    // encoding does not depend on scale and parameters
+    std::shared_ptr<const seal::Plaintext> ptxt =
+        std::atomic_load(&_bfv_encoding);
+    if (ptxt) {
+      return ptxt;
+    }
+    // racing threads encode the same values, any of them may be kept
+    ptxt = std::make_shared<const seal::Plaintext>(
+        rescale(scale, params_id).sealPlaintext());
+    std::atomic_store(&_bfv_encoding, ptxt);
+    return ptxt;
+  }
+  auto context_data = _context._internal_context.get_context_data(params_id);
+  // parameters outside of the chain are not stored
+  size_t level =
+      context_data ? context_data->chain_index() : _encodings.levels();
+  std::shared_ptr<const seal::Plaintext> ptxt = _encodings.find(level, scale);
+  if (ptxt) {
+    return ptxt;
+  }
+  const std::vector<double>& values = cache_values();
+  ptxt = _context.plaintextCache().get(
+      values, _cache_hash, params_id, scale, [&](seal::Plaintext& ptxt) {
+        BACKEND_LOG << "encoding plaintext with scale " << scale << std::endl;
+        if (values.size() == 1) {
+          _context._ckksencoder->encode(values[0], params_id, scale, ptxt);
+        } else {
+          _context._ckksencoder->encode(values, params_id, scale, ptxt);
+        }
+      });
+  return _encodings.publish(level, scale, std::move(ptxt));
+}
+
+void SEALPtxt::precompute() const {
+  const seal::SEALContext& context = _context._internal_context;
+  if (!_context.is_ckks()) {
+    encoded(0, context.first_parms_id());
+    return;
+  }
+  // the scale a plaintext is multiplied with at a level in the plan
+  const ScalePlan& plan = _context.scalePlan();
+  for (auto data = context.first_context_data(); data;
+       data = data->next_context_data()) {
+    const size_t level = data->chain_index();
+    encoded(plan.plain_scale(level, plan.scale(level)), data->parms_id());
+  }
+}
+
+std::shared_ptr<const seal::Plaintext> SEALPtxt::encodedToMatch(
+    const SEALCtxt& ctxt) const {
+  return encoded(ctxt.sealCiphertext().scale(),
+                 ctxt.sealCiphertext().parms_id());
+}
+
 bool SEALPtxt::isValidMask() const {
   if (_content_type == CONTENT_TYPE::DOUBLE) {
     for (const auto& v : double_values) {
-      if (v != 0 || v != 1) {
+      if (v != 0 && v != 1) {
         return false;
       }
     }
   } else if (_content_type == CONTENT_TYPE::LONG) {
     for (const auto& v : long_values) {
-      if (v != 0 || v != 1) {
+      if (v != 0 && v != 1) {
         return false;
       }
     }
@@ -135,6 +233,11 @@ std::shared_ptr<HEPtxt> SEALPtxt::deepCopy() {
   return std::shared_ptr<SEALPtxt>(raw);
 }
 
+size_t SEALPtxt::values_hash() const {
+  cache_values();
+  return _cache_hash;
+}
+
 bool SEALPtxt::isAllZero() const { return _allZero; }
 bool SEALPtxt::isAllOne() const { return _allOne; }
 
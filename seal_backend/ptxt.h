@@ -2,10 +2,13 @@
 #define ALUMINUM_SHARK_SEAL_BACKEND_PTXT_H
 
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "context.h"
+#include "encoding_table.h"
 #include "he_backend/he_backend.h"
 #include "seal/seal.h"
 
@@ -15,7 +18,10 @@ namespace aluminum_shark {
 class SEALPtxt : public HEPtxt {
  public:
   // Plugin API
-  virtual ~SEALPtxt() { count_ptxt(-1); };
+  virtual ~SEALPtxt() {
+    count_ptxt(-1);
+    count_ptxt_bytes(-_counted_bytes);
+  };
 
   virtual std::string to_string() const override;
 
@@ -50,12 +56,33 @@ class SEALPtxt : public HEPtxt {
   SEALPtxt scaleToMatch(const SEALCtxt& ctxt) const;
   void scaleToMatchInPlace(const SEALCtxt& ctxt);
 
+  // returns the values encoded at `scale` and `params_id` without modifying
+  // this plaintext. encodings are looked up per (level, scale) in this
+  // plaintext without blocking. CKKS encodings are owned by the plaintext
+  // cache of the context and shared with other plaintexts
+  std::shared_ptr<const seal::Plaintext> encoded(
+      double scale, seal::parms_id_type params_id) const;
+  std::shared_ptr<const seal::Plaintext> encodedToMatch(
+      const SEALCtxt& ctxt) const;
+
+  // encodes the values at every level at the scale they are multiplied with
+  // at that level (see ScalePlan)
+  void precompute() const;
+
+  // number of encodings held by this plaintext. CKKS encodings may since
+  // have been evicted from the plaintext cache
+  size_t encodings() const {
+    return _encodings.size() + (std::atomic_load(&_bfv_encoding) ? 1 : 0);
+  }
+
   bool isAllZero() const;
   bool isAllOne() const;
 
   bool isValidMask() const;
 
-  std::mutex mutex;
+  // number and hash of the values (see PlaintextCache::hash)
+  size_t n_values() const { return cache_values().size(); }
+  size_t values_hash() const;
 
  protected:
   seal::Plaintext _internal_ptxt;
@@ -69,12 +96,34 @@ class SEALPtxt : public HEPtxt {
   const SEALContext& _context;
   bool _allZero = false;
   bool _allOne = false;
+  // bytes reported to the object counter
+  int64_t _counted_bytes = 0;
+
+  // reports the change of the size of the plaintext to the object counter.
+  // needs to be called after the plaintext was modified
+  void track_bytes();
+
+  // key for the plaintext cache. computed on first use
+  mutable std::once_flag _cache_key_flag;
+  // only used if the values are not available as `double_values`
+  mutable std::vector<double> _cache_values;
+  mutable size_t _cache_hash = 0;
+  const std::vector<double>& cache_values() const;
+
+  // CKKS encodings by (chain index, scale). the plaintext cache owns them and
+  // accounts for their memory, only weak references are kept here. with the
+  // cache disabled nothing is retained
+  mutable EncodingTable<seal::Plaintext, true> _encodings;
+  // the BFV encoding does not depend on the level and is not cached. only
+  // accessed through std::atomic_load and std::atomic_store
+  mutable std::shared_ptr<const seal::Plaintext> _bfv_encoding;
 
   SEALPtxt(const SEALPtxt& other)
       : _content_type(other._content_type),
         _context(other._context),
         _allZero(other._allZero),
-        _allOne(other._allOne) {
+        _allOne(other._allOne),
+        _encodings(other._encodings.levels()) {
     count_ptxt(1);
   };
 };
@@ -0,0 +1,130 @@
+#include "ptxt_cache.h"
+
+#include <cstring>
+#include <string_view>
+
+namespace aluminum_shark {
+
+std::atomic_ulong PlaintextCache::hits = 0;
+std::atomic_ulong PlaintextCache::misses = 0;
+std::atomic_ulong PlaintextCache::evictions = 0;
+
+PlaintextCache::PlaintextCache(size_t max_bytes) : _max_bytes(max_bytes) {}
+
+size_t PlaintextCache::hash(const std::vector<double>& values) {
+  return std::hash<std::string_view>{}(
+      std::string_view(reinterpret_cast<const char*>(values.data()),
+                       values.size() * sizeof(double)));
+}
+
+size_t PlaintextCache::key(size_t values_hash,
+                           const seal::parms_id_type& parms_id,
+                           double scale) const {
+  // boost::hash_combine
+  size_t seed = values_hash;
+  auto combine = [&seed](size_t v) {
+    seed ^= v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+  };
+  for (auto p : parms_id) {
+    combine(p);
+  }
+  uint64_t scale_bits;
+  std::memcpy(&scale_bits, &scale, sizeof(scale));
+  combine(scale_bits);
+  return seed;
+}
+
+PlaintextCache::entry_list::iterator PlaintextCache::find(
+    size_t key, const std::vector<double>& values,
+    const seal::parms_id_type& parms_id, double scale) {
+  auto range = _index.equal_range(key);
+  for (auto it = range.first; it != range.second; ++it) {
+    const Entry& entry = *it->second;
+    if (entry.scale == scale && entry.parms_id == parms_id &&
+        entry.values == values) {
+      return it->second;
+    }
+  }
+  return _entries.end();
+}
+
+std::shared_ptr<const seal::Plaintext> PlaintextCache::get(
+    const std::vector<double>& values, size_t values_hash,
+    const seal::parms_id_type& parms_id, double scale,
+    const encode_fn& encode) {
+  if (_max_bytes == 0) {
+    auto ptxt = std::make_shared<seal::Plaintext>();
+    encode(*ptxt);
+    return ptxt;
+  }
+  size_t k = key(values_hash, parms_id, scale);
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = find(k, values, parms_id, scale);
+    if (it != _entries.end()) {
+      // move to the front
+      _entries.splice(_entries.begin(), _entries, it);
+      ++hits;
+      return it->ptxt;
+    }
+  }
+  ++misses;
+  // encode without holding the lock. other threads can use the cache in the
+  // meantime
+  auto ptxt = std::make_shared<seal::Plaintext>();
+  encode(*ptxt);
+  size_t bytes = ptxt->coeff_count() * sizeof(seal::Plaintext::pt_coeff_type);
+  if (bytes > _max_bytes) {
+    return ptxt;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  // another thread might have encoded the same plaintext
+  auto it = find(k, values, parms_id, scale);
+  if (it != _entries.end()) {
+    _entries.splice(_entries.begin(), _entries, it);
+    return it->ptxt;
+  }
+  _entries.push_front(Entry{values, values_hash, parms_id, scale, bytes, ptxt});
+  _index.emplace(k, _entries.begin());
+  _bytes += bytes;
+  evict();
+  return ptxt;
+}
+
+void PlaintextCache::evict() {
+  while (_bytes > _max_bytes && !_entries.empty()) {
+    auto last = std::prev(_entries.end());
+    size_t k = key(last->values_hash, last->parms_id, last->scale);
+    auto range = _index.equal_range(k);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (it->second == last) {
+        _index.erase(it);
+        break;
+      }
+    }
+    _bytes -= last->bytes;
+    // plaintexts still in use stay alive through their shared_ptr
+    _entries.erase(last);
+    ++evictions;
+  }
+}
+
+void PlaintextCache::clear() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _index.clear();
+  _entries.clear();
+  _bytes = 0;
+}
+
+size_t PlaintextCache::size() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+size_t PlaintextCache::bytes() const {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _bytes;
+}
+
+}  // namespace aluminum_shark
@@ -0,0 +1,79 @@
+#ifndef ALUMINUM_SHARK_SEAL_BACKEND_PTXT_CACHE_H
+#define ALUMINUM_SHARK_SEAL_BACKEND_PTXT_CACHE_H
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "seal/seal.h"
+
+namespace aluminum_shark {
+
+// Bounded LRU cache of encoded CKKS plaintexts. Entries are identified by the
+// values they encode, the parms_id and the scale. The hash of the values is
+// used for the lookup, the values themselves are compared to rule out
+// collisions. The cache hands out shared immutable plaintexts so they can be
+// used by multiple operations at the same time. The size of the cache is
+// limited by the memory used by the plaintexts.
+class PlaintextCache {
+ public:
+  using encode_fn = std::function<void(seal::Plaintext&)>;
+
+  // `max_bytes` == 0 disables the cache
+  explicit PlaintextCache(size_t max_bytes);
+
+  // returns the plaintext for `values` encoded at `parms_id` and `scale`.
+  // `encode` is called to create the plaintext if it is not in the cache.
+  // `values_hash` needs to be the result of `hash(values)`
+  std::shared_ptr<const seal::Plaintext> get(
+      const std::vector<double>& values, size_t values_hash,
+      const seal::parms_id_type& parms_id, double scale,
+      const encode_fn& encode);
+
+  // removes all entries
+  void clear();
+
+  // number of entries and bytes currently in the cache
+  size_t size() const;
+  size_t bytes() const;
+
+  static size_t hash(const std::vector<double>& values);
+
+  // statistics. shared by all caches
+  static std::atomic_ulong hits;
+  static std::atomic_ulong misses;
+  static std::atomic_ulong evictions;
+
+ private:
+  struct Entry {
+    std::vector<double> values;
+    size_t values_hash;
+    seal::parms_id_type parms_id;
+    double scale;
+    size_t bytes;
+    std::shared_ptr<const seal::Plaintext> ptxt;
+  };
+  using entry_list = std::list<Entry>;
+
+  const size_t _max_bytes;
+  size_t _bytes = 0;
+  mutable std::mutex _mutex;
+  // most recently used entries are at the front
+  entry_list _entries;
+  std::unordered_multimap<size_t, entry_list::iterator> _index;
+
+  size_t key(size_t values_hash, const seal::parms_id_type& parms_id,
+             double scale) const;
+  // needs to be called with the lock held
+  entry_list::iterator find(size_t key, const std::vector<double>& values,
+                            const seal::parms_id_type& parms_id, double scale);
+  void evict();
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_PTXT_CACHE_H */
@@ -0,0 +1,138 @@
+#include "scale_plan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+
+#include "backend_logging.h"
+
+namespace aluminum_shark {
+
+ScalePlan::ScalePlan(const seal::SEALContext& context, double scale) {
+  auto first = context.first_context_data();
+  _scales.resize(first->chain_index() + 1);
+  _primes.resize(first->chain_index() + 1);
+  for (auto data = first; data; data = data->next_context_data()) {
+    const size_t i = data->chain_index();
+    _scales[i] = scale;
+    _primes[i] =
+        static_cast<double>(data->parms().coeff_modulus().back().value());
+    // same operations as multiply and rescale_to_next
+    scale = scale * scale / _primes[i];
+  }
+}
+
+double ScalePlan::scale(size_t chain_index) const {
+  return chain_index < _scales.size() ? _scales[chain_index] : 0;
+}
+
+double ScalePlan::product_scale(size_t chain_index) const {
+  return scale(chain_index) * scale(chain_index);
+}
+
+double ScalePlan::plain_scale(size_t chain_index, double ctxt_scale) const {
+  if (chain_index == 0 || chain_index >= _scales.size()) {
+    return ctxt_scale;
+  }
+  if (ctxt_scale == _scales[chain_index]) {
+    // bit exact, the product rescales to the planned scale below
+    return ctxt_scale;
+  }
+  return product_scale(chain_index) / ctxt_scale;
+}
+
+void ScalePlan::snap(seal::Ciphertext& ctxt, size_t chain_index) const {
+  ctxt.scale() = snapped(chain_index, ctxt.scale());
+}
+
+double ScalePlan::snapped(size_t chain_index, double scale) const {
+  if (chain_index >= _scales.size()) {
+    return scale;
+  }
+  // planned scales of different levels differ by far more than this
+  const double planned = _scales[chain_index];
+  return std::fabs(scale - planned) <= planned * 1e-12 ? planned : scale;
+}
+
+std::vector<seal::Modulus> ScalePlan::coeff_modulus(size_t poly_modulus_degree,
+                                                    std::vector<int> bit_sizes,
+                                                    double scale) {
+  const int scale_bits = static_cast<int>(std::lround(scale));
+  const int max_bits = seal::CoeffModulus::MaxBitCount(poly_modulus_degree);
+  if (bit_sizes.size() >= 2) {
+    std::vector<int> planned = bit_sizes;
+    planned.front() = std::max(planned.front(), std::min(60, scale_bits + 10));
+    planned.back() = std::max(
+        planned.back(), *std::max_element(planned.begin(), planned.end() - 1));
+    if (std::accumulate(planned.begin(), planned.end(), 0) <= max_bits) {
+      bit_sizes = planned;
+    } else {
+      BACKEND_LOG << "keeping the first and special prime sizes, larger ones "
+                     "exceed "
+                  << max_bits << " bits" << std::endl;
+    }
+  }
+  std::vector<seal::Modulus> primes =
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes);
+
+  // primes that are dropped by rescaling and have the size of the scale
+  std::vector<size_t> positions;
+  for (size_t i = 1; i + 1 < bit_sizes.size(); ++i) {
+    if (bit_sizes[i] == scale_bits) {
+      positions.push_back(i);
+    }
+  }
+  if (positions.empty() || scale_bits < 20 || scale_bits > 59) {
+    return primes;
+  }
+  std::vector<uint64_t> used;
+  for (size_t i = 0; i < primes.size(); ++i) {
+    if (std::find(positions.begin(), positions.end(), i) == positions.end()) {
+      used.push_back(primes[i].value());
+    }
+  }
+  // candidates closest to 2^scale first. NTT friendly primes are 1 mod 2n
+  const uint64_t factor = 2 * poly_modulus_degree;
+  const uint64_t center = (uint64_t{1} << scale_bits) / factor * factor + 1;
+  std::vector<uint64_t> pool;
+  for (uint64_t k = 0; pool.size() < 4 * positions.size(); ++k) {
+    const uint64_t below = center - k * factor;
+    const uint64_t above = center + (k + 1) * factor;
+    for (uint64_t candidate : {below, above}) {
+      if (candidate < (uint64_t{1} << 60) &&
+          seal::Modulus(candidate).is_prime() &&
+          std::find(used.begin(), used.end(), candidate) == used.end()) {
+        pool.push_back(candidate);
+      }
+    }
+  }
+  // the planned scale doubles its distance to 2^scale with every rescale and
+  // moves by the distance of the prime. from the top level down pick the
+  // prime that keeps it closest
+  double distance = 0;
+  for (size_t i = primes.size() - 2; i > 0; --i) {
+    if (std::find(positions.begin(), positions.end(), i) != positions.end()) {
+      auto best = std::min_element(
+          pool.begin(), pool.end(), [&](uint64_t lhs, uint64_t rhs) {
+            return std::fabs(2 * distance - (std::log2(lhs) - scale)) <
+                   std::fabs(2 * distance - (std::log2(rhs) - scale));
+          });
+      primes[i] = seal::Modulus(*best);
+      pool.erase(best);
+    }
+    distance = 2 * distance - (std::log2(primes[i].value()) - scale);
+  }
+  double total_bits = 0;
+  for (const seal::Modulus& prime : primes) {
+    total_bits += std::log2(prime.value());
+  }
+  if (std::ceil(total_bits) > max_bits) {
+    return seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes);
+  }
+  BACKEND_LOG << "planned scales drift by 2^" << distance
+              << " at the last level" << std::endl;
+  return primes;
+}
+
+}  // namespace aluminum_shark
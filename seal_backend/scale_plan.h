@@ -0,0 +1,62 @@
+#ifndef ALUMINUM_SHARK_SEAL_BACKEND_SCALE_PLAN_H
+#define ALUMINUM_SHARK_SEAL_BACKEND_SCALE_PLAN_H
+
+#include <vector>
+
+#include "seal/seal.h"
+
+namespace aluminum_shark {
+
+// exact scales of CKKS ciphertexts. a fresh ciphertext has the context scale
+// at the top level and a product is rescaled by the last prime q_l of its
+// level l. the plan fixes the scale of every level to the scale the product of
+// two ciphertexts at the planned scale of the level above has:
+// scale(l - 1) = scale(l) * scale(l) / q_l, computed the same way SEAL does.
+//
+// plaintexts and constants are encoded at the scale that puts the rescaled
+// product exactly on the planned scale whatever the scale of the ciphertext
+// is. ciphertexts at the same level therefore always line up and a plaintext
+// is encoded once per level.
+class ScalePlan {
+ public:
+  ScalePlan() = default;
+  // `scale` is the scale of fresh ciphertexts
+  ScalePlan(const seal::SEALContext& context, double scale);
+
+  // planned scale of ciphertexts at `chain_index`
+  double scale(size_t chain_index) const;
+  // scale of a product at `chain_index` before it is rescaled
+  double product_scale(size_t chain_index) const;
+  // scale to encode a plaintext at that is multiplied with a ciphertext at
+  // `chain_index` and `ctxt_scale`. the rescaled product has
+  // `scale(chain_index - 1)`. at chain index 0 nothing can be rescaled and
+  // `ctxt_scale` is returned
+  double plain_scale(size_t chain_index, double ctxt_scale) const;
+  // sets the scale of the rescaled `ctxt` at `chain_index` to the planned scale
+  // if it only differs from it by the rounding of the scale computation
+  void snap(seal::Ciphertext& ctxt, size_t chain_index) const;
+  // the scale `snap` gives a ciphertext at `chain_index` and `scale`
+  double snapped(size_t chain_index, double scale) const;
+
+  // primes for `bit_sizes` (see seal::CoeffModulus::Create) chosen for a
+  // context with scale 2^`scale`:
+  // - the first prime has at least 10 bits more than the scale, values up to
+  //   2^10 can be decrypted at the last level
+  // - the special prime is at least as large as the largest other prime
+  // - the primes in between that have as many bits as the scale are the
+  //   primes closest to the scale, ordered so that the planned scales stay as
+  //   close to 2^`scale` as possible
+  // bit sizes are only raised if the total stays within the 128 bit security
+  // bound for `poly_modulus_degree`
+  static std::vector<seal::Modulus> coeff_modulus(
+      size_t poly_modulus_degree, std::vector<int> bit_sizes, double scale);
+
+ private:
+  // by chain index
+  std::vector<double> _scales;
+  std::vector<double> _primes;
+};
+
+}  // namespace aluminum_shark
+
+#endif /* ALUMINUM_SHARK_SEAL_BACKEND_SCALE_PLAN_H */
@@ -0,0 +1,100 @@
+// measures how batch encryption and decryption scale with the number of
+// worker threads. loads the backend, encrypts `count` rows of a row-major
+// buffer with encryptBatch and decrypts them into a second buffer with
+// decryptBatch through the entry points the backend exports. prints
+// ciphertexts per second for 1 to `max_threads` threads and checks the round
+// trip.
+//
+// ./batch_encrypt_bench [backend library] [max threads] [count]
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "he_backend/he_backend.h"
+#include "parallel.h"
+
+using namespace aluminum_shark;
+
+namespace {
+
+using encrypt_batch_fn = void (*)(HEContext*, const double*,
+                                  const BatchLayout&, std::shared_ptr<HECtxt>*,
+                                  size_t);
+using decrypt_batch_fn = void (*)(HEContext*, const std::shared_ptr<HECtxt>*,
+                                  const BatchLayout&, double*, size_t);
+
+// looks up `name` in the backend library loaded by loadBackend
+void* backend_symbol(const char* library, const char* name) {
+  void* handle = dlopen(library, RTLD_LAZY | RTLD_NOLOAD);
+  void* symbol = handle ? dlsym(handle, name) : nullptr;
+  if (!symbol) {
+    throw std::runtime_error(std::string("backend does not export ") + name);
+  }
+  return symbol;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const char* library = argc > 1 ? argv[1] : "../aluminum_shark_seal.so";
+  const size_t max_threads =
+      argc > 2 ? std::stoul(argv[2])
+               : std::max(1u, std::thread::hardware_concurrency());
+  const size_t count = argc > 3 ? std::stoul(argv[3]) : 256;
+
+  std::shared_ptr<HEBackend> backend = loadBackend(library);
+  auto encrypt_batch = reinterpret_cast<encrypt_batch_fn>(
+      backend_symbol(library, "encryptBatchDouble"));
+  auto decrypt_batch = reinterpret_cast<decrypt_batch_fn>(
+      backend_symbol(library, "decryptBatchDouble"));
+
+  std::vector<int> coeff_modulus{60, 40, 40, 60};
+  std::unique_ptr<HEContext> context(
+      backend->createContextCKKS(8192, coeff_modulus, std::pow(2.0, 40)));
+  context->createPublicKey();
+  context->createPrivateKey();
+
+  BatchLayout layout = BatchLayout::rows(count, context->numberOfSlots());
+  std::vector<double> input(count * layout.slots);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<double>(i % 1000) / 1000;
+  }
+  std::vector<double> output(input.size());
+  std::vector<std::shared_ptr<HECtxt>> ctxts(count);
+
+  std::cout << "threads, encrypt ctxt/s, decrypt ctxt/s, max error"
+            << std::endl;
+  for (size_t n = 1; n <= max_threads; n *= 2) {
+    auto start = std::chrono::steady_clock::now();
+    encrypt_batch(context.get(), input.data(), layout, ctxts.data(), n);
+    double encrypt_s = seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    decrypt_batch(context.get(), ctxts.data(), layout, output.data(), n);
+    double decrypt_s = seconds_since(start);
+
+    double error = 0;
+    for (size_t i = 0; i < input.size(); ++i) {
+      error = std::max(error, std::abs(input[i] - output[i]));
+    }
+    std::cout << n << ", " << count / encrypt_s << ", " << count / decrypt_s
+              << ", " << error << std::endl;
+  }
+  // the ciphertexts need to go before the context
+  ctxts.clear();
+  return 0;
+}
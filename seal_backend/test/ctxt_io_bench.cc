@@ -0,0 +1,143 @@
+// measures the throughput of saving and loading a batch of ciphertexts. compares
+// SEAL's stream serialization with the ciphertext file used by the backend
+// (raw polynomial data loaded from a memory mapped file) and its compressed
+// variant. prints MB/s for saving and loading.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "ctxt_io.h"
+#include "seal/seal.h"
+
+using aluminum_shark::CtxtFileReader;
+using aluminum_shark::CtxtFileWriter;
+
+namespace {
+
+const std::string FILE_NAME = "ctxt_io_bench.bin";
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+void report(const std::string& name, double mb, double save_s, double load_s,
+            size_t file_bytes) {
+  std::cout << name << ", " << mb / save_s << ", " << mb / load_s << ", "
+            << file_bytes / (1024.0 * 1024.0) << std::endl;
+}
+
+size_t file_size(const std::string& file) {
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  return in.tellg();
+}
+
+void bench_file(const std::string& name, const seal::SEALContext& context,
+                const std::vector<seal::Ciphertext>& ctxts,
+                seal::compr_mode_type compression, double mb) {
+  auto start = std::chrono::steady_clock::now();
+  {
+    CtxtFileWriter writer(FILE_NAME, "bench", 0,
+                          static_cast<uint32_t>(compression), {ctxts.size()},
+                          ctxts.size());
+    for (const auto& ctxt : ctxts) {
+      aluminum_shark::write_ciphertext(writer, context, ctxt, compression);
+    }
+    writer.close();
+  }
+  double save_s = seconds_since(start);
+
+  std::vector<seal::Ciphertext> loaded(ctxts.size());
+  start = std::chrono::steady_clock::now();
+  {
+    CtxtFileReader reader(FILE_NAME, "bench");
+    for (size_t i = 0; i < reader.count(); ++i) {
+      aluminum_shark::read_ciphertext(reader, i, context, loaded[i]);
+    }
+  }
+  double load_s = seconds_since(start);
+  for (size_t i = 0; i < ctxts.size(); ++i) {
+    if (!std::equal(ctxts[i].data(),
+                    ctxts[i].data() + ctxts[i].dyn_array().size(),
+                    loaded[i].data())) {
+      std::cout << name << ": ciphertext " << i << " differs" << std::endl;
+    }
+  }
+  report(name, mb, save_s, load_s, file_size(FILE_NAME));
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  size_t poly_modulus_degree = 16384;
+  std::vector<int> bit_sizes{60, 40, 40, 40, 40, 40, 40, 60};
+  double scale = std::pow(2.0, 40);
+  const size_t n_ctxts = argc > 1 ? std::stoul(argv[1]) : 64;
+
+  seal::EncryptionParameters parms(seal::scheme_type::ckks);
+  parms.set_poly_modulus_degree(poly_modulus_degree);
+  parms.set_coeff_modulus(
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes));
+  seal::SEALContext context(parms);
+  seal::KeyGenerator keygen(context);
+  seal::PublicKey public_key;
+  keygen.create_public_key(public_key);
+  seal::Encryptor encryptor(context, public_key);
+  seal::CKKSEncoder encoder(context);
+
+  std::cout << "encrypting " << n_ctxts << " ciphertexts" << std::endl;
+  std::vector<double> input(encoder.slot_count());
+  std::vector<seal::Ciphertext> ctxts(n_ctxts);
+  for (size_t c = 0; c < n_ctxts; ++c) {
+    for (size_t i = 0; i < input.size(); ++i) {
+      input[i] = std::sin(static_cast<double>(c * input.size() + i));
+    }
+    seal::Plaintext ptxt;
+    encoder.encode(input, scale, ptxt);
+    encryptor.encrypt(ptxt, ctxts[c]);
+  }
+  double mb = 0;
+  for (const auto& ctxt : ctxts) {
+    mb += ctxt.dyn_array().size() * sizeof(seal::Ciphertext::ct_coeff_type);
+  }
+  mb /= 1024.0 * 1024.0;
+
+  std::cout << "format, save MB/s, load MB/s, file MB" << std::endl;
+
+  // SEAL's own serialization through file streams
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::ofstream out(FILE_NAME, std::ios::binary);
+    for (const auto& ctxt : ctxts) {
+      ctxt.save(out, seal::compr_mode_type::none);
+    }
+  }
+  double save_s = seconds_since(start);
+  std::vector<seal::Ciphertext> loaded(n_ctxts);
+  start = std::chrono::steady_clock::now();
+  {
+    std::ifstream in(FILE_NAME, std::ios::binary);
+    for (auto& ctxt : loaded) {
+      ctxt.load(context, in);
+    }
+  }
+  double load_s = seconds_since(start);
+  report("seal stream", mb, save_s, load_s, file_size(FILE_NAME));
+
+  bench_file("mapped raw", context, ctxts, seal::compr_mode_type::none, mb);
+#ifdef SEAL_USE_ZSTD
+  bench_file("mapped zstd", context, ctxts, seal::compr_mode_type::zstd, mb);
+#endif
+#ifdef SEAL_USE_ZLIB
+  bench_file("mapped zlib", context, ctxts, seal::compr_mode_type::zlib, mb);
+#endif
+  std::remove(FILE_NAME.c_str());
+  return 0;
+}
@@ -0,0 +1,125 @@
+// adds a ciphertext at the top level (a skip connection) to `count`
+// ciphertexts two levels below through the loaded backend. the first variant
+// adds a fresh encryption of the skip values every time, so every addition
+// brings the skip ciphertext down again. the second adds the same ciphertext
+// every time, its lower level version comes from the LevelCache of the
+// ciphertext. prints the us per addition of both variants with the level cache
+// lookups reported by the ressource monitor and checks the sums against the
+// clear values. run with ALUMINUM_SHARK_LEVEL_CACHE_MB=0 to compare with the
+// cache disabled.
+//
+// ./level_cache_bench [backend library] [count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "he_backend/he_backend.h"
+
+using namespace aluminum_shark;
+
+namespace {
+
+double monitor_value(Monitor& monitor, const std::string& name) {
+  double value = 0;
+  monitor.get(name, value);
+  return value;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const char* library = argc > 1 ? argv[1] : "../aluminum_shark_seal.so";
+  const size_t count = argc > 2 ? std::stoul(argv[2]) : 64;
+  std::shared_ptr<HEBackend> backend = loadBackend(library);
+  Monitor& monitor = *backend->enable_ressource_monitor(true);
+  std::vector<int> coeff_modulus{60, 40, 40, 40, 40, 40, 60};
+  std::unique_ptr<HEContext> context(
+      backend->createContextCKKS(16384, coeff_modulus, std::pow(2.0, 40)));
+  context->createPublicKey();
+  context->createPrivateKey();
+  const size_t slots = context->numberOfSlots();
+
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(-1, 1);
+  auto random_values = [&]() {
+    std::vector<double> values(slots);
+    for (double& v : values) {
+      v = dist(rng);
+    }
+    return values;
+  };
+  // two plaintext products bring the inputs two levels down
+  const double factor = 0.5;
+  std::vector<std::vector<double>> clear;
+  for (size_t i = 0; i < count; ++i) {
+    clear.push_back(random_values());
+  }
+  auto encrypt_inputs = [&]() {
+    std::vector<std::shared_ptr<HECtxt>> inputs;
+    for (std::vector<double>& values : clear) {
+      inputs.push_back(context->encrypt(values, "x"));
+      inputs.back()->multInPlace(factor);
+      inputs.back()->multInPlace(factor);
+    }
+    return inputs;
+  };
+  std::vector<double> skip_values = random_values();
+
+  struct Variant {
+    std::string name;
+    double us = 0;
+    double hits = 0;
+    double misses = 0;
+    double max_error = 0;
+  };
+  std::vector<Variant> variants(2);
+  variants[0].name = "fresh skip ciphertext";
+  variants[1].name = "level cache";
+  for (size_t v = 0; v < variants.size(); ++v) {
+    Variant& variant = variants[v];
+    std::vector<std::shared_ptr<HECtxt>> inputs = encrypt_inputs();
+    std::vector<std::shared_ptr<HECtxt>> skips(v == 0 ? count : 1);
+    for (std::shared_ptr<HECtxt>& skip : skips) {
+      skip = context->encrypt(skip_values, "skip");
+    }
+    variant.hits = -monitor_value(monitor, "level_cache_hits");
+    variant.misses = -monitor_value(monitor, "level_cache_misses");
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; ++i) {
+      inputs[i]->addInPlace(skips[v == 0 ? i : 0]);
+    }
+    variant.us = std::chrono::duration<double, std::micro>(
+                     std::chrono::steady_clock::now() - start)
+                     .count() /
+                 count;
+    variant.hits += monitor_value(monitor, "level_cache_hits");
+    variant.misses += monitor_value(monitor, "level_cache_misses");
+    for (size_t i = 0; i < count; ++i) {
+      std::vector<double> result = context->decryptDouble(inputs[i]);
+      for (size_t j = 0; j < slots; ++j) {
+        const double expected =
+            clear[i][j] * factor * factor + skip_values[j];
+        variant.max_error =
+            std::max(variant.max_error, std::fabs(result[j] - expected));
+      }
+    }
+  }
+
+  bool correct = true;
+  std::cout << "variant, us per addition, cache hits, cache misses, max error"
+            << std::endl;
+  for (const Variant& variant : variants) {
+    std::cout << variant.name << ", " << variant.us << ", " << variant.hits
+              << ", " << variant.misses << ", " << variant.max_error
+              << std::endl;
+    correct = correct && variant.max_error < 1e-3;
+  }
+  std::cout << "results " << (correct ? "correct" : "WRONG") << std::endl;
+  return correct ? 0 : 1;
+}
@@ -0,0 +1,108 @@
+// measures sum_i ctxt_i * ptxt_i as it is computed by a dense layer. compares
+// one multiply_plain, rescale and add per term with multiply_plain_accumulate
+// followed by a single rescale. prints the time per linear combination and the
+// largest difference between the decrypted results.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "linear_combination.h"
+#include "seal/seal.h"
+
+namespace {
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  size_t poly_modulus_degree = 16384;
+  std::vector<int> bit_sizes{60, 40, 40, 40, 40, 40, 40, 60};
+  double scale = std::pow(2.0, 40);
+  const size_t n_terms = argc > 1 ? std::stoul(argv[1]) : 128;
+  const size_t runs = argc > 2 ? std::stoul(argv[2]) : 5;
+
+  seal::EncryptionParameters parms(seal::scheme_type::ckks);
+  parms.set_poly_modulus_degree(poly_modulus_degree);
+  parms.set_coeff_modulus(
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes));
+  seal::SEALContext context(parms);
+  seal::KeyGenerator keygen(context);
+  seal::PublicKey public_key;
+  keygen.create_public_key(public_key);
+  seal::Encryptor encryptor(context, public_key);
+  seal::Decryptor decryptor(context, keygen.secret_key());
+  seal::Evaluator evaluator(context);
+  seal::CKKSEncoder encoder(context);
+
+  std::cout << "encoding " << n_terms << " terms" << std::endl;
+  std::vector<double> input(encoder.slot_count());
+  std::vector<seal::Ciphertext> ctxts(n_terms);
+  std::vector<seal::Plaintext> ptxts(n_terms);
+  for (size_t t = 0; t < n_terms; ++t) {
+    for (size_t i = 0; i < input.size(); ++i) {
+      input[i] = std::sin(static_cast<double>(t * input.size() + i));
+    }
+    seal::Plaintext ptxt;
+    encoder.encode(input, scale, ptxt);
+    encryptor.encrypt(ptxt, ctxts[t]);
+    for (size_t i = 0; i < input.size(); ++i) {
+      input[i] = std::cos(static_cast<double>(t + i)) / n_terms;
+    }
+    encoder.encode(input, scale, ptxts[t]);
+  }
+  std::vector<const seal::Ciphertext*> ctxt_ptrs;
+  std::vector<const seal::Plaintext*> ptxt_ptrs;
+  for (size_t t = 0; t < n_terms; ++t) {
+    ctxt_ptrs.push_back(&ctxts[t]);
+    ptxt_ptrs.push_back(&ptxts[t]);
+  }
+
+  seal::Ciphertext naive;
+  auto start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < runs; ++r) {
+    evaluator.multiply_plain(ctxts[0], ptxts[0], naive);
+    evaluator.rescale_to_next_inplace(naive);
+    seal::Ciphertext product;
+    for (size_t t = 1; t < n_terms; ++t) {
+      evaluator.multiply_plain(ctxts[t], ptxts[t], product);
+      evaluator.rescale_to_next_inplace(product);
+      evaluator.add_inplace(naive, product);
+    }
+  }
+  double naive_s = seconds_since(start) / runs;
+
+  seal::Ciphertext fused;
+  start = std::chrono::steady_clock::now();
+  for (size_t r = 0; r < runs; ++r) {
+    aluminum_shark::multiply_plain_accumulate(context, ctxt_ptrs, ptxt_ptrs,
+                                              fused);
+    evaluator.rescale_to_next_inplace(fused);
+  }
+  double fused_s = seconds_since(start) / runs;
+
+  std::vector<double> naive_values, fused_values;
+  seal::Plaintext decrypted;
+  decryptor.decrypt(naive, decrypted);
+  encoder.decode(decrypted, naive_values);
+  decryptor.decrypt(fused, decrypted);
+  encoder.decode(decrypted, fused_values);
+  double max_diff = 0;
+  for (size_t i = 0; i < naive_values.size(); ++i) {
+    max_diff = std::max(max_diff, std::abs(naive_values[i] - fused_values[i]));
+  }
+
+  std::cout << "method, ms" << std::endl;
+  std::cout << "multiply_plain + rescale, " << naive_s * 1000 << std::endl;
+  std::cout << "multiply_plain_accumulate, " << fused_s * 1000 << std::endl;
+  std::cout << "speedup: " << naive_s / fused_s << std::endl;
+  std::cout << "max difference: " << max_diff << std::endl;
+  return 0;
+}
@@ -0,0 +1,105 @@
+// measures the per operation cost of the debug output in the ciphertext
+// operations while logging is turned off. compares a plain add_inplace with
+// the previous pattern (operands formatted into a stringstream and streamed to
+// NullStream) and with BACKEND_LOG_DEBUG. prints ns per addition. run without
+// ALUMINUM_SHARK_BACKEND_LOGGING set.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "backend_logging.h"
+#include "seal/seal.h"
+
+// BACKEND_LOG as it was before the log macros skipped their operands
+#define LEGACY_LOG                                     \
+  (::aluminum_shark::seal_backend::log()               \
+       ? std::cout                                     \
+       : ::aluminum_shark::seal_backend::nullstream()) \
+      << "Backend: [" << __FILE__ << ":" << __LINE__ << "] "
+
+namespace {
+
+enum class Mode { NONE, LEGACY, MACRO };
+
+double ns_per_add(Mode mode, const seal::SEALContext& context,
+                  seal::Evaluator& evaluator, seal::Ciphertext& lhs,
+                  const seal::Ciphertext& rhs, size_t n) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    if (mode == Mode::LEGACY) {
+      std::stringstream ss;
+      ss << " ctxt += ctxt  this " << static_cast<void*>(&lhs) << std::endl;
+      ss << "adding. lhs scale " << std::log2(lhs.scale()) << " rhs scale "
+         << std::log2(rhs.scale()) << std::endl;
+      ss << "\t lhs params index: "
+         << context.get_context_data(lhs.parms_id())->chain_index()
+         << " \n\t rhs params index "
+         << context.get_context_data(rhs.parms_id())->chain_index()
+         << std::endl;
+      LEGACY_LOG << ss.str();
+    } else if (mode == Mode::MACRO) {
+      BACKEND_LOG_DEBUG
+          << " ctxt += ctxt  this " << static_cast<void*>(&lhs) << std::endl
+          << "adding. lhs scale " << std::log2(lhs.scale()) << " rhs scale "
+          << std::log2(rhs.scale()) << std::endl
+          << "\t lhs params index: "
+          << context.get_context_data(lhs.parms_id())->chain_index()
+          << " \n\t rhs params index "
+          << context.get_context_data(rhs.parms_id())->chain_index()
+          << std::endl;
+    }
+    evaluator.add_inplace(lhs, rhs);
+  }
+  return std::chrono::duration<double, std::nano>(
+             std::chrono::steady_clock::now() - start)
+             .count() /
+         n;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  size_t poly_modulus_degree = argc > 1 ? std::stoul(argv[1]) : 8192;
+  const size_t n = argc > 2 ? std::stoul(argv[2]) : 10000;
+  std::vector<int> bit_sizes{60, 40, 40, 60};
+  double scale = std::pow(2.0, 40);
+
+  seal::EncryptionParameters parms(seal::scheme_type::ckks);
+  parms.set_poly_modulus_degree(poly_modulus_degree);
+  parms.set_coeff_modulus(
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes));
+  seal::SEALContext context(parms);
+  seal::KeyGenerator keygen(context);
+  seal::PublicKey public_key;
+  keygen.create_public_key(public_key);
+  seal::Encryptor encryptor(context, public_key);
+  seal::Evaluator evaluator(context);
+  seal::CKKSEncoder encoder(context);
+
+  std::vector<double> input(encoder.slot_count(), 1e-6);
+  seal::Plaintext ptxt;
+  encoder.encode(input, scale, ptxt);
+  seal::Ciphertext lhs, rhs;
+  encryptor.encrypt(ptxt, lhs);
+  encryptor.encrypt(ptxt, rhs);
+
+  std::cout << "log level " << aluminum_shark::seal_backend::log_level()
+            << ", compiled max level " << ALUMINUM_SHARK_BACKEND_MAX_LOG_LEVEL
+            << std::endl;
+  std::cout << "mode, ns per add" << std::endl;
+  // warm up
+  ns_per_add(Mode::NONE, context, evaluator, lhs, rhs, n / 10 + 1);
+  std::cout << "no logging, "
+            << ns_per_add(Mode::NONE, context, evaluator, lhs, rhs, n)
+            << std::endl;
+  std::cout << "stringstream + NullStream, "
+            << ns_per_add(Mode::LEGACY, context, evaluator, lhs, rhs, n)
+            << std::endl;
+  std::cout << "BACKEND_LOG_DEBUG, "
+            << ns_per_add(Mode::MACRO, context, evaluator, lhs, rhs, n)
+            << std::endl;
+  return 0;
+}
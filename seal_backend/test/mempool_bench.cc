@@ -0,0 +1,117 @@
+// measures how fast threads get memory for the result of a ciphertext
+// operation. every iteration creates a result ciphertext, adds two ciphertexts
+// into it and destroys it. compares SEAL's global memory pool, a pool per
+// thread (MMProfPerThread) and a pool per thread with the ciphertext freelists.
+// prints the average latency of the allocation and the throughput of the whole
+// iteration for 1 to `max_threads` threads.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ctxt_pool.h"
+#include "seal/seal.h"
+
+using aluminum_shark::CiphertextFreelist;
+
+namespace {
+
+struct Result {
+  double alloc_ns = 0;
+  double ops_per_s = 0;
+};
+
+Result run(size_t n_threads, size_t iterations,
+           const seal::SEALContext& context, const seal::Ciphertext& lhs,
+           const seal::Ciphertext& rhs) {
+  std::vector<double> alloc_ns(n_threads);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < n_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      seal::Evaluator evaluator(context);
+      std::chrono::steady_clock::duration alloc{0};
+      for (size_t i = 0; i < iterations; ++i) {
+        auto alloc_start = std::chrono::steady_clock::now();
+        seal::Ciphertext result =
+            CiphertextFreelist::acquire(lhs.size(), lhs.coeff_modulus_size());
+        result.resize(context, lhs.parms_id(), lhs.size());
+        alloc += std::chrono::steady_clock::now() - alloc_start;
+        evaluator.add(lhs, rhs, result);
+        CiphertextFreelist::release(result);
+      }
+      alloc_ns[t] = std::chrono::duration<double, std::nano>(alloc).count() /
+                    iterations;
+      CiphertextFreelist::clear();
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  Result result;
+  for (double ns : alloc_ns) {
+    result.alloc_ns += ns / n_threads;
+  }
+  result.ops_per_s = n_threads * iterations / seconds;
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const size_t max_threads =
+      argc > 1 ? std::stoul(argv[1])
+               : std::max(1u, std::thread::hardware_concurrency());
+  const size_t iterations = argc > 2 ? std::stoul(argv[2]) : 2000;
+  size_t poly_modulus_degree = 8192;
+  std::vector<int> bit_sizes{60, 40, 40, 60};
+  double scale = std::pow(2.0, 40);
+
+  seal::EncryptionParameters parms(seal::scheme_type::ckks);
+  parms.set_poly_modulus_degree(poly_modulus_degree);
+  parms.set_coeff_modulus(
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes));
+  seal::SEALContext context(parms);
+  seal::KeyGenerator keygen(context);
+  seal::PublicKey public_key;
+  keygen.create_public_key(public_key);
+  seal::Encryptor encryptor(context, public_key);
+  seal::CKKSEncoder encoder(context);
+
+  std::vector<double> input(encoder.slot_count(), 0.5);
+  seal::Plaintext ptxt;
+  encoder.encode(input, scale, ptxt);
+  seal::Ciphertext lhs, rhs;
+  encryptor.encrypt(ptxt, lhs);
+  encryptor.encrypt(ptxt, rhs);
+
+  std::cout << "pool, threads, alloc ns, ops/s" << std::endl;
+  for (int mode = 0; mode < 3; ++mode) {
+    std::string name;
+    if (mode == 0) {
+      name = "global";
+      seal::MemoryManager::SwitchProfile(
+          std::make_unique<seal::MMProfGlobal>());
+    } else {
+      name = mode == 1 ? "per thread" : "per thread + freelist";
+      seal::MemoryManager::SwitchProfile(
+          std::make_unique<aluminum_shark::MMProfPerThread>());
+    }
+    CiphertextFreelist::enable(mode == 2);
+    for (size_t n = 1; n <= max_threads; n *= 2) {
+      Result result = run(n, iterations, context, lhs, rhs);
+      std::cout << name << ", " << n << ", " << result.alloc_ns << ", "
+                << result.ops_per_s << std::endl;
+    }
+  }
+  std::cout << "freelist hits " << CiphertextFreelist::hits << " misses "
+            << CiphertextFreelist::misses << std::endl;
+  return 0;
+}
@@ -0,0 +1,75 @@
+// compares the previous SEALCtxt::rotate (copy the ciphertext, then rotate
+// the copy in place) with rotating straight into the destination the way the
+// copy-on-write SEALCtxt does. every variant allocates from its own memory
+// pool. prints us per rotation, the bytes copied into the intermediate copy
+// and the pool size in MB, which is the peak memory held by the variant.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "seal/seal.h"
+
+namespace {
+
+template <class F>
+void run(const std::string& name, size_t n, size_t copied_bytes, F op) {
+  seal::MemoryPoolHandle pool = seal::MemoryPoolHandle::New();
+  seal::Ciphertext dst(pool);
+  // warm up
+  op(dst, pool);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < n; ++i) {
+    op(dst, pool);
+  }
+  double us = std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+  std::cout << name << ", " << us / n << ", " << copied_bytes << ", "
+            << static_cast<double>(pool.alloc_byte_count()) / (1 << 20)
+            << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const size_t n = argc > 1 ? std::stoul(argv[1]) : 100;
+  size_t poly_modulus_degree = 8192;
+  std::vector<int> bit_sizes{60, 40, 40, 60};
+
+  seal::EncryptionParameters parms(seal::scheme_type::ckks);
+  parms.set_poly_modulus_degree(poly_modulus_degree);
+  parms.set_coeff_modulus(
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes));
+  seal::SEALContext context(parms);
+  seal::KeyGenerator keygen(context);
+  seal::PublicKey public_key;
+  keygen.create_public_key(public_key);
+  seal::GaloisKeys gal_keys;
+  keygen.create_galois_keys(std::vector<int>{1}, gal_keys);
+  seal::Encryptor encryptor(context, public_key);
+  seal::Evaluator evaluator(context);
+  seal::CKKSEncoder encoder(context);
+
+  std::vector<double> input(encoder.slot_count(), 0.5);
+  seal::Plaintext ptxt;
+  encoder.encode(input, std::pow(2.0, 40), ptxt);
+  seal::Ciphertext src;
+  encryptor.encrypt(ptxt, src);
+  const size_t bytes =
+      src.dyn_array().size() * sizeof(seal::Ciphertext::ct_coeff_type);
+
+  std::cout << "variant, us per rotation, bytes copied, pool MB" << std::endl;
+  run("copy + rotate_vector_inplace", n, bytes,
+      [&](seal::Ciphertext& dst, seal::MemoryPoolHandle& pool) {
+        dst = src;
+        evaluator.rotate_vector_inplace(dst, 1, gal_keys, pool);
+      });
+  run("rotate_vector into destination", n, 0,
+      [&](seal::Ciphertext& dst, seal::MemoryPoolHandle& pool) {
+        evaluator.rotate_vector(src, 1, gal_keys, dst, pool);
+      });
+  return 0;
+}
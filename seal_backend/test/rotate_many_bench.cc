@@ -0,0 +1,94 @@
+// compares SEAL's `rotate_vector` per step with the hoisted rotations used by
+// `SEALCtxt::rotateMany`. prints the cost per rotation for a growing number of
+// steps and the maximum difference between both results.
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "hoisted_rotation.h"
+#include "seal/seal.h"
+
+using aluminum_shark::HoistedRotator;
+
+int main(int argc, char const* argv[]) {
+  size_t poly_modulus_degree = 16384;
+  std::vector<int> bit_sizes{60, 40, 40, 40, 40, 40, 40, 60};
+  double scale = std::pow(2.0, 40);
+  const int max_steps = 64;
+  const int repetitions = 3;
+
+  seal::EncryptionParameters parms(seal::scheme_type::ckks);
+  parms.set_poly_modulus_degree(poly_modulus_degree);
+  parms.set_coeff_modulus(
+      seal::CoeffModulus::Create(poly_modulus_degree, bit_sizes));
+  seal::SEALContext context(parms);
+
+  std::cout << "creating keys" << std::endl;
+  seal::KeyGenerator keygen(context);
+  seal::PublicKey public_key;
+  keygen.create_public_key(public_key);
+  std::vector<int> key_steps;
+  for (int i = 1; i <= max_steps; ++i) {
+    key_steps.push_back(i);
+  }
+  seal::GaloisKeys galois_keys;
+  keygen.create_galois_keys(key_steps, galois_keys);
+
+  seal::Encryptor encryptor(context, public_key);
+  seal::Evaluator evaluator(context);
+  seal::Decryptor decryptor(context, keygen.secret_key());
+  seal::CKKSEncoder encoder(context);
+
+  std::vector<double> input(encoder.slot_count());
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = std::sin(static_cast<double>(i));
+  }
+  seal::Plaintext ptxt;
+  encoder.encode(input, scale, ptxt);
+  seal::Ciphertext ctxt;
+  encryptor.encrypt(ptxt, ctxt);
+
+  std::cout << "steps, rotate_vector us/rotation, hoisted us/rotation, "
+               "speedup, max difference"
+            << std::endl;
+  for (int n_steps = 1; n_steps <= max_steps; n_steps *= 2) {
+    std::vector<seal::Ciphertext> expected(n_steps), hoisted(n_steps);
+    double naive_us = 0, hoisted_us = 0;
+    for (int r = 0; r < repetitions; ++r) {
+      auto start = std::chrono::steady_clock::now();
+      for (int s = 0; s < n_steps; ++s) {
+        evaluator.rotate_vector(ctxt, s + 1, galois_keys, expected[s]);
+      }
+      auto mid = std::chrono::steady_clock::now();
+      HoistedRotator rotator(context, ctxt);
+      for (int s = 0; s < n_steps; ++s) {
+        rotator.rotate(s + 1, galois_keys, hoisted[s]);
+      }
+      auto end = std::chrono::steady_clock::now();
+      naive_us +=
+          std::chrono::duration<double, std::micro>(mid - start).count();
+      hoisted_us +=
+          std::chrono::duration<double, std::micro>(end - mid).count();
+    }
+    naive_us /= repetitions * n_steps;
+    hoisted_us /= repetitions * n_steps;
+
+    double max_diff = 0;
+    for (int s = 0; s < n_steps; ++s) {
+      seal::Plaintext p_expected, p_hoisted;
+      decryptor.decrypt(expected[s], p_expected);
+      decryptor.decrypt(hoisted[s], p_hoisted);
+      std::vector<double> v_expected, v_hoisted;
+      encoder.decode(p_expected, v_expected);
+      encoder.decode(p_hoisted, v_hoisted);
+      for (size_t i = 0; i < v_expected.size(); ++i) {
+        max_diff = std::max(max_diff, std::fabs(v_expected[i] - v_hoisted[i]));
+      }
+    }
+    std::cout << n_steps << ", " << naive_us << ", " << hoisted_us << ", "
+              << naive_us / hoisted_us << ", " << max_diff << std::endl;
+  }
+  return 0;
+}
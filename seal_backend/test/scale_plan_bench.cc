@@ -0,0 +1,136 @@
+// runs the RNN style recurrence h = (x_t * w + h * u)^2 over fresh inputs x_t
+// through the loaded backend, once with the planned primes (see ScalePlan) and
+// once with plan_primes=0. every addition has operands at different levels and
+// goes through SEALCtxt::match_to. prints per variant the us per step and per
+// addition, the operations the backend used to match the operands (from the
+// ressource monitor) and the maximum error.
+//
+// ./scale_plan_bench [backend library] [repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "he_backend/he_backend.h"
+#include "python/arg_utils.h"
+
+using namespace aluminum_shark;
+
+namespace {
+
+const std::vector<std::string> match_values{
+    "match_mod_switch", "match_rescale", "match_multiplication"};
+
+double monitor_value(Monitor& monitor, const std::string& name) {
+  double value = 0;
+  monitor.get(name, value);
+  return value;
+}
+
+double us_since(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+void run(HEBackend& backend, const std::string& name, bool planned,
+         size_t repeats) {
+  std::vector<long> bit_sizes{60, 40, 40, 40, 40, 40, 40, 40, 40, 60};
+  // types as in python/aluminum_shark/c_arguments.py
+  std::vector<aluminum_shark_Argument> arguments(5);
+  arguments[0].name = "poly_modulus_degree";
+  arguments[0].int_ = 16384;
+  arguments[1].name = "coeff_modulus";
+  arguments[1].is_array = true;
+  arguments[1].array_ = bit_sizes.data();
+  arguments[1].size_ = bit_sizes.size();
+  arguments[2].name = "scale";
+  arguments[2].type = 1;
+  arguments[2].double_ = std::pow(2.0, 40);
+  arguments[3].name = "plan_primes";
+  arguments[3].int_ = planned;
+  arguments[4].name = "galois_keys";
+  arguments[4].int_ = 0;
+  std::unique_ptr<HEContext> context(backend.createContextCKKS(arguments));
+  context->createPublicKey();
+  context->createPrivateKey();
+  const size_t slots = context->numberOfSlots();
+  // every step uses two levels, the special prime holds none
+  const size_t steps_per_repeat = (bit_sizes.size() - 2) / 2;
+
+  Monitor& monitor = *backend.get_ressource_monitor();
+  std::vector<double> matched(match_values.size());
+  for (size_t i = 0; i < match_values.size(); ++i) {
+    matched[i] = -monitor_value(monitor, match_values[i]);
+  }
+
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(-0.5, 0.5);
+  const double w = 0.5;
+  const double u = 0.5;
+  double step_us = 0;
+  double add_us = 0;
+  size_t steps = 0;
+  double max_error = 0;
+  for (size_t r = 0; r < repeats; ++r) {
+    std::vector<double> clear(slots);
+    for (double& v : clear) {
+      v = dist(rng);
+    }
+    std::shared_ptr<HECtxt> h = context->encrypt(clear, "h");
+    for (size_t s = 0; s < steps_per_repeat; ++s) {
+      std::vector<double> x(slots);
+      for (double& v : x) {
+        v = dist(rng);
+      }
+      std::shared_ptr<HECtxt> x_ctxt = context->encrypt(x, "x");
+
+      auto start = std::chrono::steady_clock::now();
+      x_ctxt->multInPlace(w);
+      h->multInPlace(u);
+      auto add_start = std::chrono::steady_clock::now();
+      h->addInPlace(x_ctxt);
+      add_us += us_since(add_start);
+      h->multInPlace(h);
+      step_us += us_since(start);
+      ++steps;
+      for (size_t i = 0; i < slots; ++i) {
+        clear[i] = std::pow(x[i] * w + clear[i] * u, 2);
+      }
+    }
+    std::vector<double> result = context->decryptDouble(h);
+    for (size_t i = 0; i < slots; ++i) {
+      max_error = std::max(max_error, std::fabs(result[i] - clear[i]));
+    }
+  }
+  for (size_t i = 0; i < match_values.size(); ++i) {
+    matched[i] += monitor_value(monitor, match_values[i]);
+  }
+  std::cout << name << ", " << step_us / steps << ", " << add_us / steps;
+  for (double count : matched) {
+    std::cout << ", " << count;
+  }
+  std::cout << ", " << max_error << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const char* library = argc > 1 ? argv[1] : "../aluminum_shark_seal.so";
+  const size_t repeats = argc > 2 ? std::stoul(argv[2]) : 5;
+  std::shared_ptr<HEBackend> backend = loadBackend(library);
+  backend->enable_ressource_monitor(true);
+  std::cout << "variant, us per step, us per addition";
+  for (const std::string& name : match_values) {
+    std::cout << ", " << name;
+  }
+  std::cout << ", max error" << std::endl;
+  run(*backend, "plain primes", false, repeats);
+  run(*backend, "planned primes", true, repeats);
+  return 0;
+}
@@ -0,0 +1,160 @@
+// checks the operations the backend skips for zero and one operands against
+// the same operations done in full. the reference plaintexts hold a different
+// value in their last slot, so they are neither all zero nor all one and the
+// backend computes the products. all other slots have to decrypt to the same
+// values. every shortcut result is also added to its reference, which fails
+// if the shortcut left the ciphertext at a scale or level the backend can't
+// match.
+//
+// ./shortcut_test [backend library]
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "he_backend/he_backend.h"
+
+using namespace aluminum_shark;
+
+namespace {
+
+using linear_combination_fn = std::shared_ptr<HECtxt> (*)(
+    HEContext*, const std::vector<std::shared_ptr<HECtxt>>&,
+    const std::vector<std::shared_ptr<HEPtxt>>&, std::shared_ptr<HEPtxt>);
+
+bool all_passed = true;
+
+std::vector<double> decrypt(const HEContext& context,
+                            std::shared_ptr<HECtxt> ctxt, bool ckks) {
+  if (ckks) {
+    return context.decryptDouble(ctxt);
+  }
+  std::vector<long> values = context.decryptLong(ctxt);
+  return std::vector<double>(values.begin(), values.end());
+}
+
+// compares all but the last slot of `shortcut` and `reference`, and of their
+// sum with twice the reference
+void check(const std::string& name, const HEContext& context,
+           std::shared_ptr<HECtxt> shortcut, std::shared_ptr<HECtxt> reference,
+           bool ckks) {
+  const double tolerance = ckks ? 1e-3 : 0;
+  std::vector<double> expected = decrypt(context, reference, ckks);
+  std::vector<double> result = decrypt(context, shortcut, ckks);
+  std::vector<double> sum = decrypt(context, *shortcut + reference, ckks);
+  double error = 0;
+  double sum_error = 0;
+  for (size_t i = 0; i + 1 < expected.size(); ++i) {
+    error = std::max(error, std::fabs(result[i] - expected[i]));
+    sum_error = std::max(sum_error, std::fabs(sum[i] - 2 * expected[i]));
+  }
+  const bool passed = error <= tolerance && sum_error <= tolerance;
+  all_passed = all_passed && passed;
+  std::cout << name << ": " << (passed ? "passed" : "FAILED") << " (error "
+            << error << ", error of the sum " << sum_error << ")"
+            << std::endl;
+}
+
+// `n` values of `value`. the last slot holds `last`
+template <class T>
+std::vector<T> filled(size_t n, T value, T last) {
+  std::vector<T> values(n, value);
+  values.back() = last;
+  return values;
+}
+
+template <class T>
+std::vector<T> inputs(size_t n, T offset) {
+  std::vector<T> values(n);
+  for (size_t i = 0; i < n; ++i) {
+    values[i] = static_cast<T>(i % 7) + offset;
+  }
+  return values;
+}
+
+void ckks_checks(HEBackend& backend, linear_combination_fn linear_combination) {
+  std::vector<int> coeff_modulus{60, 40, 40, 40, 40, 60};
+  std::unique_ptr<HEContext> context(
+      backend.createContextCKKS(16384, coeff_modulus, std::pow(2.0, 40)));
+  context->createPublicKey();
+  context->createPrivateKey();
+  const size_t n = context->numberOfSlots();
+  std::vector<double> x_values = inputs<double>(n, 0.5);
+  std::vector<double> y_values = inputs<double>(n, -3);
+  std::shared_ptr<HECtxt> x = context->encrypt(x_values, "x");
+  std::shared_ptr<HECtxt> y = context->encrypt(y_values, "y");
+  std::shared_ptr<HEPtxt> zeros = context->encode(filled<double>(n, 0, 0));
+  std::shared_ptr<HEPtxt> not_zeros = context->encode(filled<double>(n, 0, 1));
+  std::shared_ptr<HEPtxt> ones = context->encode(filled<double>(n, 1, 1));
+  std::shared_ptr<HEPtxt> not_ones = context->encode(filled<double>(n, 1, 2));
+
+  // a zero shared by two copies. the copy that is modified first encrypts the
+  // zero for both
+  std::shared_ptr<HECtxt> zero = *x * zeros;
+  std::shared_ptr<HECtxt> reference = *x * not_zeros;
+  std::shared_ptr<HECtxt> zero_copy = zero->deepCopy();
+  std::shared_ptr<HECtxt> reference_copy = reference->deepCopy();
+  zero_copy->addInPlace(2.0);
+  reference_copy->addInPlace(2.0);
+  check("zero materialized after copy on write", *context, zero_copy,
+        reference_copy, true);
+  check("zero shared with the materialized copy", *context, zero, reference,
+        true);
+
+  check("zero minus x", *context, *(*x * zeros) - y, *reference - y, true);
+
+  // every product moves to the next level, the planned scales of the levels
+  // differ
+  std::shared_ptr<HECtxt> product = x->deepCopy();
+  reference = x->deepCopy();
+  for (size_t level = 0; level + 2 < coeff_modulus.size(); ++level) {
+    product->multInPlace(ones);
+    reference->multInPlace(not_ones);
+    check("product with ones, step " + std::to_string(level + 1), *context,
+          product, reference, true);
+  }
+
+  std::shared_ptr<HEPtxt> bias = context->encode(inputs<double>(n, 1));
+  std::shared_ptr<HECtxt> combination =
+      linear_combination(context.get(), {x, y}, {zeros, zeros}, bias);
+  reference =
+      linear_combination(context.get(), {x, y}, {not_zeros, not_zeros}, bias);
+  check("linear combination of zero products", *context, combination,
+        reference, true);
+}
+
+void bfv_checks(HEBackend& backend) {
+  std::vector<int> coeff_modulus{60, 40, 40, 60};
+  std::unique_ptr<HEContext> context(
+      backend.createContextBFV(8192, coeff_modulus, 65537));
+  context->createPublicKey();
+  context->createPrivateKey();
+  const size_t n = context->numberOfSlots();
+  std::vector<long> x_values = inputs<long>(n, 1);
+  std::shared_ptr<HECtxt> x = context->encrypt(x_values, "x");
+  std::shared_ptr<HEPtxt> ones = context->encode(filled<long>(n, 1, 1));
+  std::shared_ptr<HEPtxt> not_ones = context->encode(filled<long>(n, 1, 2));
+  check("BFV product with ones", *context, *x * ones, *x * not_ones, false);
+}
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  const char* library = argc > 1 ? argv[1] : "../aluminum_shark_seal.so";
+  std::shared_ptr<HEBackend> backend = loadBackend(library);
+  void* handle = dlopen(library, RTLD_LAZY | RTLD_NOLOAD);
+  auto linear_combination = reinterpret_cast<linear_combination_fn>(
+      handle ? dlsym(handle, "linearCombination") : nullptr);
+  if (!linear_combination) {
+    std::cerr << "backend does not export linearCombination" << std::endl;
+    return 1;
+  }
+  ckks_checks(*backend, linear_combination);
+  bfv_checks(*backend);
+  return all_passed ? 0 : 1;
+}
@@ -0,0 +1,465 @@
+// replays a capture of ciphertext operations (see common/op_capture.h)
+// against a backend library without TensorFlow or python.
+//
+// usage: op_replay <backend library> <capture> [threads]
+//
+// every captured context is created with fresh keys. captured inputs are
+// encrypted random values and plaintext operands random values derived from
+// the captured hash, both at the top level of the context. the operations
+// run on `threads` threads (ALUMINUM_SHARK_BATCH_THREADS by default) in the
+// order of the capture, each operation waits for the operations that wrote
+// or read its ciphertexts before it. prints the number of operations and the
+// replayed and captured time per kind of operation.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "he_backend/he_backend.h"
+#include "op_capture.h"
+#include "parallel.h"
+#include "python/arg_utils.h"
+
+using namespace aluminum_shark;
+
+namespace {
+
+// a context parameter as written by `capture_argument`
+struct Parameter {
+  std::string name;
+  char type;
+  bool is_array;
+  std::vector<std::string> values;
+  // storage for the aluminum_shark_Argument
+  std::vector<long> longs;
+  std::vector<double> doubles;
+};
+
+std::vector<Parameter> parse_parameters(const std::string& parameters) {
+  std::vector<Parameter> parsed;
+  std::stringstream lines(parameters);
+  std::string line;
+  while (std::getline(lines, line)) {
+    size_t colon = line.find(':');
+    size_t equals = line.find('=', colon);
+    if (colon == std::string::npos || equals == std::string::npos ||
+        equals == colon + 1) {
+      throw std::runtime_error("malformed context parameter: " + line);
+    }
+    Parameter p;
+    p.name = line.substr(0, colon);
+    p.type = line[colon + 1];
+    p.is_array = line.compare(colon + 2, 2, "[]") == 0;
+    std::stringstream values(line.substr(equals + 1));
+    std::string value;
+    while (std::getline(values, value, p.is_array ? ',' : '\n')) {
+      p.values.push_back(value);
+      if (p.type == 'i') {
+        p.longs.push_back(std::stol(value));
+      } else if (p.type == 'd') {
+        p.doubles.push_back(std::stod(value));
+      }
+    }
+    if (p.values.empty()) {
+      p.values.emplace_back();
+    }
+    parsed.push_back(std::move(p));
+  }
+  return parsed;
+}
+
+const Parameter& parameter(const std::vector<Parameter>& parameters,
+                           const std::string& name) {
+  for (const Parameter& p : parameters) {
+    if (p.name == name) {
+      return p;
+    }
+  }
+  throw std::runtime_error("capture is missing context parameter " + name);
+}
+
+HEContext* create_context(HEBackend& backend,
+                          const Capture::Context& captured) {
+  std::vector<Parameter> parameters = parse_parameters(captured.parameters);
+  if (captured.from_arguments) {
+    std::vector<aluminum_shark_Argument> arguments;
+    for (Parameter& p : parameters) {
+      aluminum_shark_Argument arg{};
+      arg.name = p.name.data();
+      arg.is_array = p.is_array;
+      // types as in python/aluminum_shark/c_arguments.py
+      if (p.type == 'i') {
+        arg.type = 0;
+        arg.int_ = p.longs.empty() ? 0 : p.longs[0];
+        arg.array_ = p.longs.data();
+        arg.size_ = p.longs.size();
+      } else if (p.type == 'd') {
+        arg.type = 1;
+        arg.double_ = p.doubles.empty() ? 0 : p.doubles[0];
+        arg.array_ = p.doubles.data();
+        arg.size_ = p.doubles.size();
+      } else {
+        arg.type = 2;
+        arg.string_ = p.values[0].data();
+      }
+      arguments.push_back(arg);
+    }
+    return backend.createContextCKKS(arguments);
+  }
+  size_t poly_modulus_degree =
+      parameter(parameters, "poly_modulus_degree").longs.at(0);
+  const std::vector<long>& coeff =
+      parameter(parameters, "coeff_modulus").longs;
+  std::vector<int> coeff_modulus(coeff.begin(), coeff.end());
+  if (captured.ckks) {
+    return backend.createContextCKKS(
+        poly_modulus_degree, coeff_modulus,
+        parameter(parameters, "scale").doubles.at(0));
+  }
+  return backend.createContextBFV(
+      poly_modulus_degree, coeff_modulus,
+      parameter(parameters, "plain_modulus").longs.at(0));
+}
+
+// random values seeded with `seed`. doubles in [-1, 1], integers in [-8, 8].
+// all 0 or all 1 if `flags` say so
+template <class T>
+std::vector<T> random_values(size_t n, uint64_t seed, uint8_t flags = 0) {
+  std::vector<T> values(n, flags & CAPTURE_ALL_ONE ? 1 : 0);
+  if (flags & (CAPTURE_ALL_ZERO | CAPTURE_ALL_ONE)) {
+    return values;
+  }
+  std::mt19937_64 rng(seed);
+  typename std::conditional<std::is_floating_point<T>::value,
+                            std::uniform_real_distribution<T>,
+                            std::uniform_int_distribution<T>>::type
+      dist(-8, 8);
+  for (T& v : values) {
+    v = std::is_floating_point<T>::value ? dist(rng) / 8 : dist(rng);
+  }
+  return values;
+}
+
+std::shared_ptr<HEPtxt> random_ptxt(const HEContext& context, bool ckks,
+                                    size_t n, uint64_t seed, uint8_t flags) {
+  if (ckks) {
+    return context.encode(random_values<double>(n, seed, flags));
+  }
+  return context.encode(random_values<long>(n, seed, flags));
+}
+
+std::shared_ptr<HECtxt> random_ctxt(const HEContext& context, bool ckks,
+                                    uint64_t seed) {
+  size_t n = context.numberOfSlots();
+  if (ckks) {
+    std::vector<double> values = random_values<double>(n, seed);
+    return context.encrypt(values);
+  }
+  std::vector<long> values = random_values<long>(n, seed);
+  return context.encrypt(values);
+}
+
+// the operations of a capture with everything they need prepared
+class Replay {
+ public:
+  Replay(HEBackend& backend, const Capture& capture)
+      : _records(capture.records),
+        _ptxts(_records.size()),
+        _deps(_records.size()) {
+    uint32_t max_id = 0;
+    for (const CaptureRecord& r : _records) {
+      if (r.op != CAPTURE_OP::CONTEXT) {
+        max_id = std::max({max_id, r.result, r.lhs});
+      }
+    }
+    _ctxts.resize(max_id + 1);
+    prepare(backend, capture);
+    schedule();
+  }
+
+  // runs all operations on `threads` threads. returns the time each took in
+  // microseconds
+  std::vector<double> run(size_t threads) {
+    const size_t n = _records.size();
+    std::unique_ptr<std::atomic<bool>[]> done(new std::atomic<bool>[n]);
+    for (size_t i = 0; i < n; ++i) {
+      done[i].store(false, std::memory_order_relaxed);
+    }
+    std::vector<double> us(n, 0);
+    // indices are handed out in order so every dependency is being executed
+    // by some thread when it is waited for
+    parallel_for(n, threads, [&](size_t i) {
+      for (uint32_t d : _deps[i]) {
+        while (!done[d].load(std::memory_order_acquire)) {
+          std::this_thread::yield();
+        }
+      }
+      auto start = std::chrono::steady_clock::now();
+      try {
+        execute(i);
+      } catch (...) {
+        done[i].store(true, std::memory_order_release);
+        throw;
+      }
+      us[i] = std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+      done[i].store(true, std::memory_order_release);
+    });
+    return us;
+  }
+
+ private:
+  const std::vector<CaptureRecord>& _records;
+  // declared before the ciphertexts so they are destroyed after them
+  std::vector<std::unique_ptr<HEContext>> _contexts;
+  std::vector<std::shared_ptr<HECtxt>> _ctxts;
+  // plaintext operand of each record
+  std::vector<std::shared_ptr<HEPtxt>> _ptxts;
+  // records that need to finish before each record
+  std::vector<std::vector<uint32_t>> _deps;
+
+  static bool ctxt_operand(const CaptureRecord& r) {
+    return (r.op == CAPTURE_OP::ADD || r.op == CAPTURE_OP::SUB ||
+            r.op == CAPTURE_OP::MULT) &&
+           !(r.flags & (CAPTURE_PLAIN | CAPTURE_SCALAR));
+  }
+
+  // creates the contexts, inputs and plaintexts
+  void prepare(HEBackend& backend, const Capture& capture) {
+    const HEContext* context = nullptr;
+    bool ckks = true;
+    // plaintexts with the same values share the encoding
+    std::map<std::pair<uint64_t, uint8_t>, std::shared_ptr<HEPtxt>> encoded;
+    for (size_t i = 0; i < _records.size(); ++i) {
+      const CaptureRecord& r = _records[i];
+      if (r.op == CAPTURE_OP::CONTEXT) {
+        const Capture::Context& captured = capture.contexts[r.result];
+        _contexts.emplace_back(create_context(backend, captured));
+        _contexts.back()->createPublicKey();
+        _contexts.back()->createPrivateKey();
+        context = _contexts.back().get();
+        ckks = captured.ckks;
+        encoded.clear();
+        continue;
+      }
+      if (context == nullptr) {
+        throw std::runtime_error("capture has operations before a context");
+      }
+      if (r.op == CAPTURE_OP::INPUT) {
+        _ctxts[r.result] = random_ctxt(*context, ckks, r.result);
+      } else if (r.flags & CAPTURE_PLAIN) {
+        uint64_t hash;
+        std::memcpy(&hash, &r.arg, sizeof(hash));
+        const uint8_t kind = r.flags & (CAPTURE_ALL_ZERO | CAPTURE_ALL_ONE);
+        std::shared_ptr<HEPtxt>& ptxt = encoded[{hash, kind}];
+        if (!ptxt) {
+          size_t n = std::min<size_t>(r.rhs, context->numberOfSlots());
+          ptxt = random_ptxt(*context, ckks, std::max<size_t>(n, 1), hash,
+                             r.flags);
+        }
+        _ptxts[i] = ptxt;
+      }
+    }
+  }
+
+  // derives the dependencies between the records. a record depends on the
+  // last record that wrote each ciphertext it reads. a record that writes a
+  // ciphertext also depends on all records that read it since
+  void schedule() {
+    std::vector<int64_t> last_write(_ctxts.size(), -1);
+    std::vector<std::vector<uint32_t>> readers(_ctxts.size());
+    auto read = [&](uint32_t i, uint32_t id) {
+      if (last_write[id] >= 0) {
+        _deps[i].push_back(last_write[id]);
+      }
+      readers[id].push_back(i);
+    };
+    auto write = [&](uint32_t i, uint32_t id) {
+      if (last_write[id] >= 0) {
+        _deps[i].push_back(last_write[id]);
+      }
+      for (uint32_t reader : readers[id]) {
+        if (reader != i) {
+          _deps[i].push_back(reader);
+        }
+      }
+      readers[id].clear();
+      last_write[id] = i;
+    };
+    for (uint32_t i = 0; i < _records.size(); ++i) {
+      const CaptureRecord& r = _records[i];
+      switch (r.op) {
+        case CAPTURE_OP::CONTEXT:
+        case CAPTURE_OP::INPUT:
+          // done before the replay
+          break;
+        case CAPTURE_OP::RELEASE:
+          write(i, r.lhs);
+          break;
+        default:
+          read(i, r.lhs);
+          if (ctxt_operand(r)) {
+            read(i, r.rhs);
+          }
+          write(i, r.flags & CAPTURE_INPLACE ? r.lhs : r.result);
+      }
+    }
+  }
+
+  template <class T>
+  void apply(const CaptureRecord& r, HECtxt& lhs, T operand) {
+    const bool inplace = r.flags & CAPTURE_INPLACE;
+    switch (r.op) {
+      case CAPTURE_OP::ADD:
+        if (inplace) {
+          lhs.addInPlace(operand);
+        } else {
+          _ctxts[r.result] = lhs + operand;
+        }
+        break;
+      case CAPTURE_OP::SUB:
+        if (inplace) {
+          lhs.subInPlace(operand);
+        } else {
+          _ctxts[r.result] = lhs - operand;
+        }
+        break;
+      case CAPTURE_OP::MULT:
+        if (inplace) {
+          lhs.multInPlace(operand);
+        } else {
+          _ctxts[r.result] = lhs * operand;
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  std::shared_ptr<HECtxt> ctxt(uint32_t id) const {
+    if (!_ctxts[id]) {
+      throw std::runtime_error("ciphertext " + std::to_string(id) +
+                               " is used before it is created");
+    }
+    return _ctxts[id];
+  }
+
+  void execute(size_t i) {
+    const CaptureRecord& r = _records[i];
+    switch (r.op) {
+      case CAPTURE_OP::CONTEXT:
+      case CAPTURE_OP::INPUT:
+        return;
+      case CAPTURE_OP::RELEASE:
+        _ctxts[r.lhs].reset();
+        return;
+      case CAPTURE_OP::COPY:
+        _ctxts[r.result] = ctxt(r.lhs)->deepCopy();
+        return;
+      case CAPTURE_OP::ROTATE:
+        if (r.flags & CAPTURE_INPLACE) {
+          ctxt(r.lhs)->rotInPlace(r.arg);
+        } else {
+          _ctxts[r.result] = ctxt(r.lhs)->rotate(r.arg);
+        }
+        return;
+      default:
+        break;
+    }
+    std::shared_ptr<HECtxt> lhs = ctxt(r.lhs);
+    if (r.flags & CAPTURE_PLAIN) {
+      apply(r, *lhs, _ptxts[i]);
+    } else if ((r.flags & CAPTURE_SCALAR) && (r.flags & CAPTURE_DOUBLE)) {
+      double value;
+      std::memcpy(&value, &r.arg, sizeof(value));
+      apply(r, *lhs, value);
+    } else if (r.flags & CAPTURE_SCALAR) {
+      apply(r, *lhs, static_cast<long>(r.arg));
+    } else {
+      apply(r, *lhs, ctxt(r.rhs));
+    }
+  }
+};
+
+struct OpStats {
+  size_t count = 0;
+  double replay_us = 0;
+  double capture_us = 0;
+};
+
+}  // namespace
+
+int main(int argc, char const* argv[]) {
+  if (argc < 3 || argc > 4) {
+    std::cerr << "usage: " << argv[0]
+              << " <backend library> <capture> [threads]" << std::endl;
+    return 1;
+  }
+  const size_t threads = argc == 4 ? std::stoul(argv[3]) : batch_threads();
+  try {
+    Capture capture = read_capture(argv[2]);
+    std::shared_ptr<HEBackend> backend = loadBackend(argv[1]);
+    std::cout << "replaying " << capture.records.size() << " records of "
+              << capture.contexts.size() << " contexts on " << threads
+              << " threads" << std::endl;
+
+    Replay replay(*backend, capture);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> us = replay.run(threads);
+    double wall_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    std::map<std::string, OpStats> stats;
+    OpStats total;
+    for (size_t i = 0; i < capture.records.size(); ++i) {
+      const CaptureRecord& r = capture.records[i];
+      if (r.op == CAPTURE_OP::CONTEXT || r.op == CAPTURE_OP::INPUT ||
+          r.op == CAPTURE_OP::RELEASE) {
+        continue;
+      }
+      OpStats& s = stats[capture_op_name(r)];
+      for (OpStats* t : {&s, &total}) {
+        ++t->count;
+        t->replay_us += us[i];
+        t->capture_us += r.duration_us;
+      }
+    }
+
+    std::cout << std::left << std::setw(24) << "op" << std::right
+              << std::setw(10) << "count" << std::setw(14) << "replay ms"
+              << std::setw(14) << "capture ms" << std::setw(10) << "ratio"
+              << std::endl;
+    std::cout << std::fixed << std::setprecision(3);
+    auto print = [](const std::string& name, const OpStats& s) {
+      std::cout << std::left << std::setw(24) << name << std::right
+                << std::setw(10) << s.count << std::setw(14)
+                << s.replay_us / 1e3 << std::setw(14) << s.capture_us / 1e3
+                << std::setw(10)
+                << (s.capture_us > 0 ? s.replay_us / s.capture_us : 0)
+                << std::endl;
+    };
+    for (const auto& entry : stats) {
+      print(entry.first, entry.second);
+    }
+    print("total", total);
+    std::cout << "wall time: " << wall_ms << " ms" << std::endl;
+  } catch (const std::exception& e) {
+    std::cerr << "replay failed: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}